@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""Compare two Google Benchmark JSON files from sdn-kernels-bench.
+
+  compare-baseline.py baseline.json current.json [--threshold 0.10]
+
+Prints the current/baseline real_time ratio of every benchmark present in
+both files and exits with status 1 when any of them is slower than the
+baseline by more than the threshold.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    times = {}
+    for b in data.get("benchmarks", []):
+        # With --benchmark_repetitions only the mean aggregate is compared
+        if b.get("run_type") == "aggregate" and b.get("aggregate_name") != "mean":
+            continue
+        name = b.get("run_name", b["name"])
+        times[name] = b["real_time"]
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="Allowed slowdown as a fraction (default 0.10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressions = 0
+    for name in sorted(baseline.keys() & current.keys()):
+        ratio = current[name] / baseline[name] if baseline[name] else float("inf")
+        slower = ratio > 1.0 + args.threshold
+        regressions += slower
+        print("%-60s %12.1f %12.1f %7.3f%s" % (name, baseline[name], current[name], ratio,
+                                              "  REGRESSION" if slower else ""))
+    for name in sorted(baseline.keys() - current.keys()):
+        print("%-60s missing from %s" % (name, args.current))
+
+    print("%d of %d benchmarks regressed by more than %.0f%%"
+          % (regressions, len(baseline.keys() & current.keys()), args.threshold * 100))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
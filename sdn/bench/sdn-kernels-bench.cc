@@ -0,0 +1,387 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+#include "ns3/sdn-module.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <sstream>
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Microbenchmarks for the datapath and control-plane kernels, on Google Benchmark:
+
+  FlowTableAdd/Remove/Find     SDNFlowTable with N exact-match rules; Find draws
+                               keys uniformly or from a Zipf distribution
+  FlowTableFindBurst           FindMatchingFlows, 32 keys per call
+  SwitchParseAndLookup         SDNSwitch::ExtractFlowKey + LookupFlow on a UDP packet
+  ShortestPath                 ComputeShortestPath on an N-node torus, unit (BFS)
+                               and random (Dijkstra) link weights
+  PopulateRoutingTable         On a k-ary fat-tree from SDNTopologyHelper
+  GetNextHop                   Random ingress port / destination host pairs
+
+Sizes are set with our own flags, given before any Google Benchmark flag:
+
+  --sizes=1000,100000   flow table sizes
+  --zipf=0.99           Zipf exponent of the skewed key distribution
+  --graphs=1024,16384   torus sizes (rounded down to a square)
+  --fattree=4,8,16      fat-tree arities
+
+Machine-readable output and baselines use Google Benchmark's own flags, e.g.
+
+  sdn-kernels-bench --benchmark_out=current.json --benchmark_out_format=json
+  compare-baseline.py baseline.json current.json
+
+*/
+
+namespace {
+
+struct Options {
+    std::vector<uint32_t> sizes = {1000, 100000, 1000000};
+    double zipf = 0.99;
+    std::vector<uint32_t> graphs = {1024, 16384};
+    std::vector<uint32_t> fatTrees = {4, 8, 16};
+};
+
+enum KeyDistribution { Uniform, Zipf };
+
+const uint32_t kQueries = 1 << 16;
+
+FlowKey MakeKey(uint32_t i)
+{
+    FlowKey key;
+    key.srcIp = 0x0a000000 + i;                      // 10.x.y.z
+    key.dstIp = 0xc0a80000 + (i * 7919) % 65536;     // 192.168.x.y
+    key.srcPort = static_cast<uint16_t>(1024 + i % 60000);
+    key.dstPort = static_cast<uint16_t>(80 + i % 7);
+    key.protocol = 17;
+    return key;
+}
+
+FlowEntry MakeEntry(uint32_t i)
+{
+    FlowKey key = MakeKey(i);
+    FlowEntry entry;
+    entry.srcIp = Ipv4Address(key.srcIp);
+    entry.dstIp = Ipv4Address(key.dstIp);
+    entry.srcPort = key.srcPort;
+    entry.dstPort = key.dstPort;
+    entry.protocol = key.protocol;
+    return entry;
+}
+
+Ptr<SDNFlowTable> MakeTable(uint32_t n)
+{
+    Ptr<SDNFlowTable> table = CreateObject<SDNFlowTable>();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        table->AddFlowEntry(MakeEntry(i));
+    }
+    return table;
+}
+
+// kQueries rule indexes in [0, n): uniform, or Zipf-ranked (index 0 most popular)
+std::vector<uint32_t> MakeQueries(uint32_t n, KeyDistribution distribution, double exponent)
+{
+    std::mt19937 rng(42);
+    std::vector<uint32_t> queries(kQueries);
+    if (distribution == Uniform)
+    {
+        std::uniform_int_distribution<uint32_t> pick(0, n - 1);
+        for (auto& q : queries)
+        {
+            q = pick(rng);
+        }
+        return queries;
+    }
+    std::vector<double> weights(n);
+    for (uint32_t rank = 0; rank < n; rank++)
+    {
+        weights[rank] = 1.0 / std::pow(rank + 1.0, exponent);
+    }
+    std::discrete_distribution<uint32_t> pick(weights.begin(), weights.end());
+    for (auto& q : queries)
+    {
+        q = pick(rng);
+    }
+    return queries;
+}
+
+void FlowTableAdd(benchmark::State& state, uint32_t n)
+{
+    std::vector<FlowEntry> entries;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        entries.push_back(MakeEntry(i));
+    }
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Ptr<SDNFlowTable> table = CreateObject<SDNFlowTable>();
+        state.ResumeTiming();
+        for (const auto& entry : entries)
+        {
+            benchmark::DoNotOptimize(table->AddFlowEntry(entry));
+        }
+        state.PauseTiming();
+        table = nullptr;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+void FlowTableRemove(benchmark::State& state, uint32_t n)
+{
+    std::vector<FlowEntry> entries;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        entries.push_back(MakeEntry(i));
+    }
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Ptr<SDNFlowTable> table = MakeTable(n);
+        state.ResumeTiming();
+        for (const auto& entry : entries)
+        {
+            benchmark::DoNotOptimize(table->RemoveFlowEntry(entry));
+        }
+        state.PauseTiming();
+        table = nullptr;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+void FlowTableFind(benchmark::State& state, uint32_t n, KeyDistribution distribution, double exponent)
+{
+    Ptr<SDNFlowTable> table = MakeTable(n);
+    std::vector<FlowKey> keys;
+    for (uint32_t q : MakeQueries(n, distribution, exponent))
+    {
+        keys.push_back(MakeKey(q));
+    }
+    uint32_t i = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(table->FindMatchingFlow(keys[i++ & (kQueries - 1)]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void FlowTableFindBurst(benchmark::State& state, uint32_t n, KeyDistribution distribution, double exponent)
+{
+    const uint32_t burst = 32;
+    Ptr<SDNFlowTable> table = MakeTable(n);
+    std::vector<FlowKey> keys;
+    for (uint32_t q : MakeQueries(n, distribution, exponent))
+    {
+        keys.push_back(MakeKey(q));
+    }
+    FlowId flows[burst];
+    uint32_t i = 0;
+    for (auto _ : state)
+    {
+        table->FindMatchingFlows(&keys[i], burst, flows);
+        benchmark::DoNotOptimize(flows);
+        i = (i + burst) & (kQueries - 1);
+    }
+    state.SetItemsProcessed(state.iterations() * burst);
+}
+
+void SwitchParseAndLookup(benchmark::State& state, uint32_t n)
+{
+    Ptr<SDNSwitch> swtch = CreateObject<SDNSwitch>();
+    swtch->SetFlowTable(MakeTable(n));
+
+    std::vector<Ptr<Packet>> packets;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> pick(0, n - 1);
+    for (uint32_t p = 0; p < 1024; p++)
+    {
+        FlowKey key = MakeKey(pick(rng));
+        Ptr<Packet> packet = Create<Packet>(64);
+        UdpHeader udp;
+        udp.SetSourcePort(key.srcPort);
+        udp.SetDestinationPort(key.dstPort);
+        packet->AddHeader(udp);
+        Ipv4Header ip;
+        ip.SetSource(Ipv4Address(key.srcIp));
+        ip.SetDestination(Ipv4Address(key.dstIp));
+        ip.SetProtocol(key.protocol);
+        ip.SetPayloadSize(packet->GetSize());
+        packet->AddHeader(ip);
+        packets.push_back(packet);
+    }
+
+    uint32_t i = 0;
+    for (auto _ : state)
+    {
+        FlowKey key;
+        FlowId flow = kNoFlow;
+        SDNSwitch::ExtractFlowKey(packets[i++ & 1023], key);
+        benchmark::DoNotOptimize(swtch->LookupFlow(key, flow));
+        benchmark::DoNotOptimize(flow);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void ShortestPath(benchmark::State& state, uint32_t n, bool weighted)
+{
+    uint32_t side = std::max<uint32_t>(3, std::sqrt(static_cast<double>(n)));
+    n = side * side;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> weight(1, 10);
+    std::vector<std::vector<Link>> adjacency(n);
+    for (uint32_t r = 0; r < side; r++)
+    {
+        for (uint32_t c = 0; c < side; c++)
+        {
+            uint32_t s = r * side + c;
+            for (uint32_t t : {r * side + (c + 1) % side, ((r + 1) % side) * side + c})
+            {
+                uint32_t w = weighted ? weight(rng) : 1;
+                adjacency[s].push_back({t, nullptr, w});
+                adjacency[t].push_back({s, nullptr, w});
+            }
+        }
+    }
+    TopologyGraph graph;
+    graph.Build(adjacency, n);
+
+    ShortestPathScratch scratch;
+    uint32_t source = 0;
+    for (auto _ : state)
+    {
+        ComputeShortestPath(graph, source, scratch);
+        benchmark::DoNotOptimize(scratch.firstEdge.data());
+        source = (source + 1) % n;
+    }
+    state.counters["nodes"] = n;
+    state.SetItemsProcessed(state.iterations());
+}
+
+void PopulateRoutingTable(benchmark::State& state, uint32_t k)
+{
+    SDNTopologyHelper helper;
+    SDNNetwork net = helper.FatTree(k);
+    for (auto _ : state)
+    {
+        net.controller->PopulateRoutingTable(net.hosts, net.switchNodes, net.devices);
+    }
+    state.counters["switches"] = net.switches.size();
+    state.counters["hosts"] = net.hosts.GetN();
+}
+
+void GetNextHop(benchmark::State& state, uint32_t k)
+{
+    SDNTopologyHelper helper;
+    SDNNetwork net = helper.FatTree(k);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> pickSwitch(0, net.switches.size() - 1);
+    std::uniform_int_distribution<uint32_t> pickHost(0, net.hosts.GetN() - 1);
+    std::vector<std::pair<Ptr<NetDevice>, Ipv4Address>> queries;
+    for (uint32_t q = 0; q < kQueries; q++)
+    {
+        const auto& ports = net.switches[pickSwitch(rng)]->m_devices;
+        queries.emplace_back(ports[rng() % ports.size()], net.hostAddresses.GetAddress(pickHost(rng)));
+    }
+
+    uint32_t i = 0;
+    for (auto _ : state)
+    {
+        const auto& q = queries[i++ & (kQueries - 1)];
+        benchmark::DoNotOptimize(net.controller->GetNextHop(q.first, q.second));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Parses "--name=a,b,c" into values; false if arg is not that flag
+template <typename T>
+bool ParseList(const char* arg, const char* name, std::vector<T>& values)
+{
+    size_t len = std::strlen(name);
+    if (std::strncmp(arg, name, len) != 0 || arg[len] != '=') return false;
+    values.clear();
+    std::stringstream list(arg + len + 1);
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        values.push_back(static_cast<T>(std::stod(item)));
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // Take our flags out of argv; the rest belong to Google Benchmark
+    Options options;
+    int kept = 1;
+    for (int a = 1; a < argc; a++)
+    {
+        std::vector<double> zipf;
+        if (ParseList(argv[a], "--sizes", options.sizes) || ParseList(argv[a], "--graphs", options.graphs) ||
+            ParseList(argv[a], "--fattree", options.fatTrees))
+        {
+            continue;
+        }
+        if (ParseList(argv[a], "--zipf", zipf))
+        {
+            options.zipf = zipf.empty() ? options.zipf : zipf[0];
+            continue;
+        }
+        argv[kept++] = argv[a];
+    }
+    argc = kept;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    for (uint32_t n : options.sizes)
+    {
+        std::string size = "/" + std::to_string(n);
+        benchmark::RegisterBenchmark(("FlowTableAdd" + size).c_str(), FlowTableAdd, n)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("FlowTableRemove" + size).c_str(), FlowTableRemove, n)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("FlowTableFind/uniform" + size).c_str(), FlowTableFind, n, Uniform, 0.0);
+        benchmark::RegisterBenchmark(("FlowTableFind/zipf" + size).c_str(), FlowTableFind, n, Zipf, options.zipf);
+        benchmark::RegisterBenchmark(("FlowTableFindBurst/uniform" + size).c_str(), FlowTableFindBurst, n,
+                                     Uniform, 0.0);
+        benchmark::RegisterBenchmark(("FlowTableFindBurst/zipf" + size).c_str(), FlowTableFindBurst, n,
+                                     Zipf, options.zipf);
+        benchmark::RegisterBenchmark(("SwitchParseAndLookup" + size).c_str(), SwitchParseAndLookup, n);
+    }
+    for (uint32_t n : options.graphs)
+    {
+        std::string size = "/" + std::to_string(n);
+        benchmark::RegisterBenchmark(("ShortestPath/bfs" + size).c_str(), ShortestPath, n, false)
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("ShortestPath/dijkstra" + size).c_str(), ShortestPath, n, true)
+            ->Unit(benchmark::kMicrosecond);
+    }
+    for (uint32_t k : options.fatTrees)
+    {
+        std::string size = "/" + std::to_string(k);
+        benchmark::RegisterBenchmark(("PopulateRoutingTable/fattree" + size).c_str(), PopulateRoutingTable, k)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("GetNextHop/fattree" + size).c_str(), GetNextHop, k);
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+#include "ns3/sdn-module.h"
+
+#include <chrono>
+#include <random>
+using namespace ns3;
+using namespace sdn;
+NS_LOG_COMPONENT_DEFINE("SDNFlowLookupSimdBench");
+
+/*
+
+Microbenchmark: burst lookups (SDNFlowTable::FindMatchingFlows) through the scalar,
+SSE2 and AVX2 signature compare, against one FindMatchingFlow per packet, for
+10^2 .. 10^maxExp installed exact-match flows. Levels the CPU lacks are skipped.
+
+*/
+
+static FlowKey MakeKey(uint32_t i)
+{
+    FlowKey key;
+    key.srcIp = 0x0a000000 + i;                      // 10.x.y.z
+    key.dstIp = 0xc0a80000 + (i * 7919) % 65536;     // 192.168.x.y
+    key.srcPort = static_cast<uint16_t>(1024 + i % 60000);
+    key.dstPort = static_cast<uint16_t>(80 + i % 7);
+    key.protocol = (i & 1) ? 6 : 17;
+    return key;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t maxExp = 6;
+    uint32_t lookups = 1000000;
+    uint32_t burst = 32;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("maxExp", "Largest table size as a power of ten (2..7)", maxExp);
+    cmd.AddValue("lookups", "Lookups per table size and path", lookups);
+    cmd.AddValue("burst", "Keys per FindMatchingFlows call", burst);
+    cmd.Parse(argc, argv);
+    burst = std::max<uint32_t>(burst, 1);
+
+    const CuckooIndex::SimdLevel levels[] = {CuckooIndex::Scalar, CuckooIndex::Sse2, CuckooIndex::Avx2};
+    const char* names[] = {"scalar", "sse2", "avx2"};
+    CuckooIndex::SimdLevel supported = CuckooIndex::GetSupportedSimdLevel();
+    NS_LOG_UNCOND("Supported SIMD path: " << names[supported]);
+
+    std::mt19937 rng(42);
+    std::cout << "entries,single_ns_per_lookup,scalar_burst_ns,sse2_burst_ns,avx2_burst_ns\n";
+
+    uint32_t n = 100;
+    for (uint32_t exp = 2; exp <= maxExp; exp++, n *= 10)
+    {
+        Ptr<SDNFlowTable> table = CreateObject<SDNFlowTable>();
+        for (uint32_t i = 0; i < n; i++)
+        {
+            FlowKey key = MakeKey(i);
+            FlowEntry entry;
+            entry.srcIp = Ipv4Address(key.srcIp);
+            entry.dstIp = Ipv4Address(key.dstIp);
+            entry.srcPort = key.srcPort;
+            entry.dstPort = key.dstPort;
+            entry.protocol = key.protocol;
+            table->AddFlowEntry(entry);
+        }
+
+        std::uniform_int_distribution<uint32_t> pick(0, n - 1);
+        std::vector<FlowKey> queries;
+        queries.reserve(lookups);
+        for (uint32_t i = 0; i < lookups; i++)
+        {
+            queries.push_back(MakeKey(pick(rng)));
+        }
+        std::vector<FlowId> flows(lookups);
+
+        uint64_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& q : queries)
+        {
+            found += table->FindMatchingFlow(q) != kNoFlow;
+        }
+        auto stop = std::chrono::steady_clock::now();
+        std::cout << n << "," << std::chrono::duration<double, std::nano>(stop - start).count() / lookups;
+
+        for (CuckooIndex::SimdLevel level : levels)
+        {
+            if (level > supported)
+            {
+                std::cout << ",";
+                continue;
+            }
+            table->SetAttribute("LookupSimd", EnumValue(level));
+            start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < lookups; i += burst)
+            {
+                table->FindMatchingFlows(&queries[i], std::min(burst, lookups - i), &flows[i]);
+            }
+            stop = std::chrono::steady_clock::now();
+            for (FlowId flow : flows)
+            {
+                found += flow != kNoFlow;
+            }
+            std::cout << "," << std::chrono::duration<double, std::nano>(stop - start).count() / lookups;
+        }
+        std::cout << std::endl;
+
+        uint64_t expected = static_cast<uint64_t>(lookups) * (2 + supported);
+        if (found != expected)
+        {
+            NS_LOG_WARN("SDNFlowLookupSimdBench: " << (expected - found) << " lookups missed");
+        }
+    }
+
+    return 0;
+}
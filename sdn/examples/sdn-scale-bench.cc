@@ -0,0 +1,264 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "ns3/sdn-module.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <set>
+using namespace ns3;
+using namespace sdn;
+NS_LOG_COMPONENT_DEFINE("SDNScaleBench");
+
+/*
+
+Macrobenchmark: builds a fat-tree, leaf-spine, torus, linear, Waxman or
+Barabasi-Albert network with SDNTopologyHelper, runs a mix of short (mice)
+and long (elephant) UDP flows over it, and reports
+
+  wall-clock time of the build and of the run, simulator events per second,
+  peak RSS, the controller's route computation time, flow-setup latency
+  (first miss to FlowAdd, over the control channel) and packets delivered.
+
+The last line is a CSV row (header printed just before it), so two builds
+can be compared by running the same command line, e.g.
+
+  ./ns3 run "sdn-scale-bench --topology=fattree --k=16 --flows=5000"
+
+With --trace=<file> the controller's inputs and decisions are recorded for
+sdn-trace-replay.
+
+*/
+
+int main(int argc, char *argv[])
+{
+    std::string topology = "fattree";
+    uint32_t k = 8;                  // fattree
+    uint32_t leaves = 32;            // leafspine
+    uint32_t spines = 8;
+    uint32_t rows = 32;              // torus
+    uint32_t cols = 32;
+    uint32_t switches = 1024;        // linear, waxman, ba
+    uint32_t hostsPerSwitch = 2;
+    double alpha = 0.05;             // waxman
+    double beta = 0.4;
+    uint32_t m = 2;                  // ba
+
+    std::string pattern = "random";
+    uint32_t flows = 1000;
+    double elephantFraction = 0.1;
+    uint32_t micePackets = 10;
+    uint32_t elephantPackets = 200;
+    uint32_t packetSize = 512;
+    std::string flowRate = "10Mbps";
+    double spread = 1.0;             // Flow starts are spread over this many seconds
+    double duration = 5.0;
+    std::string controlDelay = "1ms";
+    bool proactive = false;
+    bool arpCachePush = false;
+    uint32_t routeThreads = 0;
+    std::string trace;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("topology", "fattree, leafspine, torus, linear, waxman or ba", topology);
+    cmd.AddValue("k", "Fat-tree arity (even)", k);
+    cmd.AddValue("leaves", "Leaf-spine leaf switches", leaves);
+    cmd.AddValue("spines", "Leaf-spine spine switches", spines);
+    cmd.AddValue("rows", "Torus rows", rows);
+    cmd.AddValue("cols", "Torus columns", cols);
+    cmd.AddValue("switches", "Switches for linear, waxman and ba", switches);
+    cmd.AddValue("hostsPerSwitch", "Hosts per switch (per leaf for leafspine; fattree uses k/2 per edge switch)", hostsPerSwitch);
+    cmd.AddValue("alpha", "Waxman alpha", alpha);
+    cmd.AddValue("beta", "Waxman beta", beta);
+    cmd.AddValue("m", "Barabasi-Albert links per new switch", m);
+    cmd.AddValue("pattern", "random (uniform pairs), permutation (each host sends to one other) or incast (all to host 0)", pattern);
+    cmd.AddValue("flows", "UDP flows (capped at the host count for permutation)", flows);
+    cmd.AddValue("elephantFraction", "Share of flows that are elephants", elephantFraction);
+    cmd.AddValue("micePackets", "Packets per mouse flow", micePackets);
+    cmd.AddValue("elephantPackets", "Packets per elephant flow", elephantPackets);
+    cmd.AddValue("packetSize", "UDP payload bytes", packetSize);
+    cmd.AddValue("flowRate", "Sending rate of every flow", flowRate);
+    cmd.AddValue("spread", "Flow start times are uniform over [1, 1 + spread] seconds", spread);
+    cmd.AddValue("duration", "Simulated seconds", duration);
+    cmd.AddValue("controlDelay", "One-way switch-controller latency (empty: synchronous controller)", controlDelay);
+    cmd.AddValue("proactive", "Pre-install destination rules instead of reacting to PacketIns", proactive);
+    cmd.AddValue("arpCachePush", "Fill every switch's ARP cache from the controller's bindings", arpCachePush);
+    cmd.AddValue("routeThreads", "Route computation threads (0 = one per core)", routeThreads);
+    cmd.AddValue("trace", "Record the controller's inputs and decisions to this file", trace);
+    cmd.Parse(argc, argv);
+
+    SDNTopologyHelper helper;
+    helper.SetControllerAttribute("ProactiveMode", BooleanValue(proactive));
+    helper.SetControllerAttribute("ArpCachePush", BooleanValue(arpCachePush));
+    helper.SetControllerAttribute("RouteComputationThreads", UintegerValue(routeThreads));
+    if (!controlDelay.empty())
+    {
+        helper.EnableControlChannel(true);
+        helper.SetControlChannelAttribute("Delay", StringValue(controlDelay));
+    }
+
+    auto buildStart = std::chrono::steady_clock::now();
+    SDNNetwork net;
+    if (topology == "fattree")
+    {
+        net = helper.FatTree(k);
+    }
+    else if (topology == "leafspine")
+    {
+        net = helper.LeafSpine(leaves, spines, hostsPerSwitch);
+    }
+    else if (topology == "torus")
+    {
+        net = helper.Torus(rows, cols, hostsPerSwitch);
+    }
+    else if (topology == "linear")
+    {
+        net = helper.Linear(switches, hostsPerSwitch);
+    }
+    else if (topology == "waxman")
+    {
+        net = helper.Waxman(switches, alpha, beta, hostsPerSwitch);
+    }
+    else if (topology == "ba")
+    {
+        net = helper.BarabasiAlbert(switches, m, hostsPerSwitch);
+    }
+    else
+    {
+        NS_LOG_UNCOND("Unknown topology " << topology);
+        return 1;
+    }
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+
+    uint32_t nHosts = net.hosts.GetN();
+    if (nHosts < 2)
+    {
+        NS_LOG_UNCOND("Topology has fewer than two hosts");
+        return 1;
+    }
+
+    // Traffic: one OnOff source per flow, one sink per destination host
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    std::vector<uint32_t> permutation(nHosts);
+    for (uint32_t h = 0; h < nHosts; h++)
+    {
+        permutation[h] = h;
+    }
+    for (uint32_t h = nHosts - 1; h > 0; h--)
+    {
+        std::swap(permutation[h], permutation[random->GetInteger(0, h)]);
+    }
+    if (pattern == "permutation")
+    {
+        flows = std::min(flows, nHosts);
+    }
+
+    const uint16_t port = 9;
+    std::set<uint32_t> sinkHosts;
+    uint32_t elephants = 0;
+    for (uint32_t f = 0; f < flows; f++)
+    {
+        uint32_t src;
+        uint32_t dst;
+        if (pattern == "permutation")
+        {
+            src = f;
+            dst = permutation[f] == f ? (f + 1) % nHosts : permutation[f];
+        }
+        else if (pattern == "incast")
+        {
+            src = 1 + random->GetInteger(0, nHosts - 2);
+            dst = 0;
+        }
+        else
+        {
+            src = random->GetInteger(0, nHosts - 1);
+            dst = (src + 1 + random->GetInteger(0, nHosts - 2)) % nHosts;
+        }
+
+        bool elephant = random->GetValue(0, 1) < elephantFraction;
+        elephants += elephant;
+        OnOffHelper onoff("ns3::UdpSocketFactory", Address(InetSocketAddress(net.hostAddresses.GetAddress(dst), port)));
+        onoff.SetConstantRate(DataRate(flowRate), packetSize);
+        onoff.SetAttribute("MaxBytes", UintegerValue(uint64_t(elephant ? elephantPackets : micePackets) * packetSize));
+        ApplicationContainer app = onoff.Install(net.hosts.Get(src));
+        app.Start(Seconds(1.0 + random->GetValue(0, spread)));
+        app.Stop(Seconds(duration));
+        sinkHosts.insert(dst);
+    }
+
+    ApplicationContainer sinks;
+    PacketSinkHelper sink("ns3::UdpSocketFactory", Address(InetSocketAddress(Ipv4Address::GetAny(), port)));
+    for (uint32_t h : sinkHosts)
+    {
+        sinks.Add(sink.Install(net.hosts.Get(h)));
+    }
+
+    Ptr<SDNTraceRecorder> recorder;
+    if (!trace.empty())
+    {
+        recorder = CreateObject<SDNTraceRecorder>();
+        recorder->SetAttribute("FileName", StringValue(trace));
+        recorder->Attach(net.controller);
+        recorder->Start();
+    }
+
+    Simulator::Stop(Seconds(duration));
+    auto runStart = std::chrono::steady_clock::now();
+    Simulator::Run();
+    double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    uint64_t events = Simulator::GetEventCount();
+    if (recorder)
+    {
+        recorder->Stop();
+    }
+
+    LatencyHistogram setup;
+    uint64_t packetIns = 0;
+    uint64_t lookups = 0;
+    for (const auto& swtch : net.switches)
+    {
+        setup.Merge(swtch->GetFlowSetupLatency());
+        packetIns += swtch->GetNPacketIns();
+        lookups += swtch->GetNLookups();
+    }
+    uint64_t delivered = 0;
+    for (uint32_t i = 0; i < sinks.GetN(); i++)
+    {
+        delivered += DynamicCast<PacketSink>(sinks.Get(i))->GetTotalRx() / packetSize;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double peakRssMb = usage.ru_maxrss / 1024.0;   // KiB on Linux
+
+    std::cout << "topology:        " << topology << " (" << net.switches.size() << " switches, " << nHosts
+              << " hosts, " << net.nSwitchLinks << " switch links)\n"
+              << "flows:           " << flows << " " << pattern << " (" << elephants << " elephants)\n"
+              << "build:           " << buildSeconds << " s (routes " << net.routeComputationSeconds << " s)\n"
+              << "run:             " << runSeconds << " s, " << events << " events, "
+              << (runSeconds > 0 ? events / runSeconds : 0) << " events/s\n"
+              << "peak RSS:        " << peakRssMb << " MiB\n"
+              << "lookups:         " << lookups << ", PacketIns " << packetIns << ", delivered " << delivered << " packets\n"
+              << "flow setup:      mean " << setup.GetMean().GetMicroSeconds() << " us, p99 "
+              << setup.GetQuantile(0.99).GetMicroSeconds() << " us over " << setup.GetCount() << " flows\n";
+    if (recorder)
+    {
+        std::cout << "trace:           " << recorder->GetNRecords() << " records in " << trace << "\n";
+    }
+
+    std::cout << "topology,switches,hosts,flows,build_s,route_s,run_s,events,events_per_s,peak_rss_mib,"
+                 "setup_mean_us,setup_p99_us,packet_ins,delivered\n"
+              << topology << "," << net.switches.size() << "," << nHosts << "," << flows << ","
+              << buildSeconds << "," << net.routeComputationSeconds << "," << runSeconds << ","
+              << events << "," << (runSeconds > 0 ? events / runSeconds : 0) << "," << peakRssMb << ","
+              << setup.GetMean().GetMicroSeconds() << "," << setup.GetQuantile(0.99).GetMicroSeconds() << ","
+              << packetIns << "," << delivered << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
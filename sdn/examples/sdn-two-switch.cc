@@ -27,6 +27,17 @@ int main(int argc, char *argv[])
     LogComponentEnable("SDNExample", LOG_LEVEL_INFO);
     LogComponentEnable("SDNController", LOG_LEVEL_INFO);
     LogComponentEnable("SDNSwitch", LOG_LEVEL_INFO);
+
+    bool proactive = false;
+    bool installPath = false;
+    std::string controlDelay = "";
+    std::string metricsFile = "";
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("proactive", "Pre-install destination rules instead of reacting to PacketIns", proactive);
+    cmd.AddValue("installPath", "Install each new flow on every switch along its path", installPath);
+    cmd.AddValue("controlDelay", "One-way switch-controller latency, e.g. 5ms (default: synchronous controller)", controlDelay);
+    cmd.AddValue("metricsFile", "Write switch and controller metrics every 100ms to this file (.json for JSON lines)", metricsFile);
+    cmd.Parse(argc, argv);
     
     NodeContainer nodes;
     nodes.Create(3);
@@ -61,6 +72,8 @@ int main(int argc, char *argv[])
     address.Assign(nodeDevices);
 
     Ptr<SDNController> controller = CreateObject<SDNController>();
+    controller->SetAttribute("ProactiveMode", BooleanValue(proactive));
+    controller->SetAttribute("InstallPath", BooleanValue(installPath));
     controller->PopulateRoutingTable(nodes, switchNodes, NetDeviceContainer(nodeDevices, switchDevices));
     controller->DisplayDetailedRoutingTable();
     controller->DisplayARPResolution();
@@ -77,6 +90,27 @@ int main(int argc, char *argv[])
     sdnSwitch2->AddDevice(switchDevices.Get(2));
     sdnSwitch2->AddDevice(switchDevices.Get(3));
     sdnSwitch2->AddDevice(switchDevices.Get(4));
+    if (!controlDelay.empty())
+    {
+        Ptr<SDNControlChannel> channel = CreateObject<SDNControlChannel>();
+        channel->SetAttribute("Delay", StringValue(controlDelay));
+        sdnSwitch1->SetControlChannel(channel);
+        sdnSwitch2->SetControlChannel(channel);
+    }
+
+    Ptr<SDNMetricsExporter> metrics;
+    if (!metricsFile.empty())
+    {
+        bool json = metricsFile.size() > 5 && metricsFile.compare(metricsFile.size() - 5, 5, ".json") == 0;
+        metrics = CreateObject<SDNMetricsExporter>();
+        metrics->SetAttribute("FileName", StringValue(metricsFile));
+        metrics->SetAttribute("Interval", TimeValue(MilliSeconds(100)));
+        metrics->SetAttribute("Format", EnumValue(json ? SDNMetricsExporter::Json : SDNMetricsExporter::Csv));
+        metrics->AddSwitch(sdnSwitch1);
+        metrics->AddSwitch(sdnSwitch2);
+        metrics->AddController(controller);
+        Simulator::Schedule(Seconds(0), &SDNMetricsExporter::Start, metrics);
+    }
     
     uint16_t port = 9;
     OnOffHelper onoff("ns3::UdpSocketFactory", Address(InetSocketAddress(Ipv4Address("10.1.1.3"), port)));
@@ -92,6 +126,10 @@ int main(int argc, char *argv[])
     csma.EnablePcapAll("sdn-two", true);
     Simulator::Stop(Seconds(10.0));
     Simulator::Run();
+    if (metrics)
+    {
+        metrics->Stop();
+    }
     Simulator::Destroy();
     
     flowTable1->PrintFlowStats();
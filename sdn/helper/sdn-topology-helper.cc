@@ -0,0 +1,342 @@
+#include "sdn-topology-helper.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNTopologyHelper");
+
+SDNTopologyHelper::SDNTopologyHelper()
+    : m_controlChannel(false),
+      m_inBandControl(false),
+      m_systemCount(1),
+      m_network("10.0.0.0"),
+      m_mask("255.0.0.0")
+{
+    m_controllerFactory.SetTypeId("ns3::sdn::SDNController");
+    m_switchFactory.SetTypeId("ns3::sdn::SDNSwitch");
+    m_flowTableFactory.SetTypeId("ns3::sdn::SDNFlowTable");
+    m_channelFactory.SetTypeId("ns3::sdn::SDNControlChannel");
+    m_link.SetDeviceAttribute("DataRate", StringValue("10Gbps"));
+    m_link.SetChannelAttribute("Delay", StringValue("1us"));
+    m_random = CreateObject<UniformRandomVariable>();
+}
+
+void SDNTopologyHelper::SetLinkDeviceAttribute(std::string name, const AttributeValue& value)
+{
+    m_link.SetDeviceAttribute(name, value);
+}
+
+void SDNTopologyHelper::SetLinkChannelAttribute(std::string name, const AttributeValue& value)
+{
+    m_link.SetChannelAttribute(name, value);
+}
+
+void SDNTopologyHelper::SetControllerAttribute(std::string name, const AttributeValue& value)
+{
+    m_controllerFactory.Set(name, value);
+}
+
+void SDNTopologyHelper::SetSwitchAttribute(std::string name, const AttributeValue& value)
+{
+    m_switchFactory.Set(name, value);
+}
+
+void SDNTopologyHelper::SetFlowTableAttribute(std::string name, const AttributeValue& value)
+{
+    m_flowTableFactory.Set(name, value);
+}
+
+void SDNTopologyHelper::EnableControlChannel(bool enable)
+{
+    m_controlChannel = enable;
+}
+
+void SDNTopologyHelper::SetControlChannelAttribute(std::string name, const AttributeValue& value)
+{
+    m_channelFactory.Set(name, value);
+}
+
+void SDNTopologyHelper::EnableInBandControl(bool enable)
+{
+    m_inBandControl = enable;
+}
+
+void SDNTopologyHelper::SetSystemCount(uint32_t n)
+{
+    NS_ASSERT_MSG(n >= 1, "SDNTopologyHelper: Need at least one system");
+    m_systemCount = n;
+}
+
+uint32_t SDNTopologyHelper::BlockRank(uint32_t i, uint32_t n) const
+{
+    return static_cast<uint64_t>(i) * m_systemCount / n;
+}
+
+uint32_t SDNTopologyHelper::RoundRobinRank(uint32_t i) const
+{
+    return i % m_systemCount;
+}
+
+void SDNTopologyHelper::SetBase(Ipv4Address network, Ipv4Mask mask)
+{
+    m_network = network;
+    m_mask = mask;
+}
+
+int64_t SDNTopologyHelper::AssignStreams(int64_t stream)
+{
+    m_random->SetStream(stream);
+    return 1;
+}
+
+std::vector<uint32_t> SDNTopologyHelper::SpreadHosts(uint32_t nSwitches, uint32_t hostsPerSwitch)
+{
+    std::vector<uint32_t> hostSwitch;
+    hostSwitch.reserve(static_cast<size_t>(nSwitches) * hostsPerSwitch);
+    for (uint32_t s = 0; s < nSwitches; s++) {
+        hostSwitch.insert(hostSwitch.end(), hostsPerSwitch, s);
+    }
+    return hostSwitch;
+}
+
+SDNNetwork SDNTopologyHelper::FatTree(uint32_t k)
+{
+    NS_ASSERT_MSG(k >= 2 && k % 2 == 0, "SDNTopologyHelper: Fat-tree arity must be even");
+    uint32_t half = k / 2;
+    uint32_t nCore = half * half;
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    std::vector<uint32_t> hostSwitch;
+    std::vector<uint32_t> systemIds(nCore + k * k);
+
+    for (uint32_t c = 0; c < nCore; c++) {
+        systemIds[c] = RoundRobinRank(c);
+    }
+    for (uint32_t pod = 0; pod < k; pod++) {
+        uint32_t aggBase = nCore + pod * k;
+        uint32_t edgeBase = aggBase + half;
+        std::fill(systemIds.begin() + aggBase, systemIds.begin() + aggBase + k, BlockRank(pod, k));
+        for (uint32_t a = 0; a < half; a++) {
+            // Aggregation switch a of every pod uplinks to the same group of k/2 core switches
+            for (uint32_t c = 0; c < half; c++) {
+                links.emplace_back(aggBase + a, a * half + c);
+            }
+            for (uint32_t e = 0; e < half; e++) {
+                links.emplace_back(edgeBase + e, aggBase + a);
+            }
+        }
+        for (uint32_t e = 0; e < half; e++) {
+            hostSwitch.insert(hostSwitch.end(), half, edgeBase + e);
+        }
+    }
+    return Build(nCore + k * k, links, hostSwitch, systemIds);
+}
+
+SDNNetwork SDNTopologyHelper::LeafSpine(uint32_t leaves, uint32_t spines, uint32_t hostsPerLeaf)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    std::vector<uint32_t> systemIds(leaves + spines);
+    for (uint32_t leaf = 0; leaf < leaves; leaf++) {
+        systemIds[leaf] = BlockRank(leaf, leaves);
+        for (uint32_t spine = 0; spine < spines; spine++) {
+            links.emplace_back(leaf, leaves + spine);
+        }
+    }
+    for (uint32_t spine = 0; spine < spines; spine++) {
+        systemIds[leaves + spine] = RoundRobinRank(spine);
+    }
+    return Build(leaves + spines, links, SpreadHosts(leaves, hostsPerLeaf), systemIds);
+}
+
+SDNNetwork SDNTopologyHelper::Torus(uint32_t rows, uint32_t cols, uint32_t hostsPerSwitch)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    for (uint32_t r = 0; r < rows; r++) {
+        for (uint32_t c = 0; c < cols; c++) {
+            uint32_t s = r * cols + c;
+            // Right and down neighbours; with two in a dimension the wrap link would duplicate them
+            if (c + 1 < cols || cols > 2) links.emplace_back(s, r * cols + (c + 1) % cols);
+            if (r + 1 < rows || rows > 2) links.emplace_back(s, ((r + 1) % rows) * cols + c);
+        }
+    }
+    return Build(rows * cols, links, SpreadHosts(rows * cols, hostsPerSwitch));
+}
+
+SDNNetwork SDNTopologyHelper::Linear(uint32_t nSwitches, uint32_t hostsPerSwitch)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    for (uint32_t s = 1; s < nSwitches; s++) {
+        links.emplace_back(s - 1, s);
+    }
+    return Build(nSwitches, links, SpreadHosts(nSwitches, hostsPerSwitch));
+}
+
+SDNNetwork SDNTopologyHelper::Waxman(uint32_t nSwitches, double alpha, double beta, uint32_t hostsPerSwitch)
+{
+    std::vector<double> x(nSwitches), y(nSwitches);
+    for (uint32_t s = 0; s < nSwitches; s++) {
+        x[s] = m_random->GetValue(0, 1);
+        y[s] = m_random->GetValue(0, 1);
+    }
+
+    std::vector<uint32_t> component(nSwitches);
+    std::iota(component.begin(), component.end(), 0);
+    auto find = [&](uint32_t s) {
+        while (component[s] != s) {
+            component[s] = component[component[s]];
+            s = component[s];
+        }
+        return s;
+    };
+
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    double scale = alpha * std::sqrt(2.0);
+    for (uint32_t a = 0; a < nSwitches; a++) {
+        for (uint32_t b = a + 1; b < nSwitches; b++) {
+            double d = std::hypot(x[a] - x[b], y[a] - y[b]);
+            if (m_random->GetValue(0, 1) < beta * std::exp(-d / scale)) {
+                links.emplace_back(a, b);
+                component[find(a)] = find(b);
+            }
+        }
+    }
+    uint32_t bridges = 0;
+    for (uint32_t s = 1; s < nSwitches; s++) {
+        if (find(s) != find(s - 1)) {
+            links.emplace_back(s - 1, s);
+            component[find(s)] = find(s - 1);
+            bridges++;
+        }
+    }
+    NS_LOG_INFO("SDNTopologyHelper: Waxman graph with " << links.size() << " links, "
+                << bridges << " added to connect it");
+    return Build(nSwitches, links, SpreadHosts(nSwitches, hostsPerSwitch));
+}
+
+SDNNetwork SDNTopologyHelper::BarabasiAlbert(uint32_t nSwitches, uint32_t m, uint32_t hostsPerSwitch)
+{
+    NS_ASSERT_MSG(m >= 1 && nSwitches > m, "SDNTopologyHelper: Barabasi-Albert needs more than m switches");
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    std::vector<uint32_t> endpoints;   // Each switch once per link end, so a uniform pick is degree-weighted
+
+    for (uint32_t a = 0; a <= m; a++) {
+        for (uint32_t b = a + 1; b <= m; b++) {
+            links.emplace_back(a, b);
+            endpoints.push_back(a);
+            endpoints.push_back(b);
+        }
+    }
+    std::vector<uint32_t> targets;
+    for (uint32_t s = m + 1; s < nSwitches; s++) {
+        targets.clear();
+        while (targets.size() < m) {
+            uint32_t target = endpoints[m_random->GetInteger(0, endpoints.size() - 1)];
+            if (std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(target);
+            }
+        }
+        for (uint32_t target : targets) {
+            links.emplace_back(s, target);
+            endpoints.push_back(s);
+            endpoints.push_back(target);
+        }
+    }
+    return Build(nSwitches, links, SpreadHosts(nSwitches, hostsPerSwitch));
+}
+
+SDNNetwork SDNTopologyHelper::Build(uint32_t nSwitches, const std::vector<std::pair<uint32_t, uint32_t>>& links,
+                                   const std::vector<uint32_t>& hostSwitch, const std::vector<uint32_t>& systemIds)
+{
+    std::vector<uint32_t> rank = systemIds;
+    if (rank.empty()) {
+        rank.resize(nSwitches);
+        for (uint32_t s = 0; s < nSwitches; s++) {
+            rank[s] = BlockRank(s, nSwitches);
+        }
+    }
+    NS_ASSERT_MSG(rank.size() == nSwitches, "SDNTopologyHelper: Need one system id per switch");
+
+    // Nodes are created in the same order on every rank, so node ids agree across ranks
+    SDNNetwork net;
+    for (uint32_t s = 0; s < nSwitches; s++) {
+        NS_ASSERT_MSG(rank[s] < m_systemCount, "SDNTopologyHelper: System id out of range");
+        net.switchNodes.Add(CreateObject<Node>(rank[s]));
+    }
+    for (uint32_t h = 0; h < hostSwitch.size(); h++) {
+        NS_ASSERT_MSG(hostSwitch[h] < nSwitches, "SDNTopologyHelper: Host attached to a missing switch");
+        net.hosts.Add(CreateObject<Node>(rank[hostSwitch[h]]));
+    }
+    InternetStackHelper stack;
+    stack.Install(net.hosts);
+
+    NetDeviceContainer hostDevices;
+    for (uint32_t h = 0; h < hostSwitch.size(); h++) {
+        NetDeviceContainer link = m_link.Install(net.hosts.Get(h), net.switchNodes.Get(hostSwitch[h]));
+        hostDevices.Add(link.Get(0));
+        net.devices.Add(link);
+    }
+    for (const auto& l : links) {
+        NS_ASSERT_MSG(l.first < nSwitches && l.second < nSwitches, "SDNTopologyHelper: Link to a missing switch");
+        net.devices.Add(m_link.Install(net.switchNodes.Get(l.first), net.switchNodes.Get(l.second)));
+        net.nCrossRankLinks += rank[l.first] != rank[l.second];
+    }
+    net.nSwitchLinks = links.size();
+
+    Ipv4AddressHelper address;
+    address.SetBase(m_network, m_mask);
+    net.hostAddresses = address.Assign(hostDevices);
+
+    bool inBand = m_inBandControl || m_systemCount > 1;
+    ObjectFactory inBandFactory = m_channelFactory;
+    inBandFactory.SetTypeId("ns3::sdn::SDNInBandControlChannel");
+    if (inBand) {
+        net.controllerNode = CreateObject<Node>(0);
+    }
+
+    net.controller = m_controllerFactory.Create<SDNController>();
+    net.switches.reserve(nSwitches);
+    for (uint32_t s = 0; s < nSwitches; s++) {
+        Ptr<Node> node = net.switchNodes.Get(s);
+        Ptr<SDNSwitch> swtch = m_switchFactory.Create<SDNSwitch>();
+        net.controller->AddSwitch(swtch);
+        swtch->SetFlowTable(m_flowTableFactory.Create<SDNFlowTable>());
+        // Switch nodes have no IP stack, so every device is a link port
+        for (uint32_t d = 0; d < node->GetNDevices(); d++) {
+            swtch->AddDevice(node->GetDevice(d));
+        }
+        if (inBand) {
+            // Installed after the ports were added, so the control link is not one of them
+            Ptr<SDNInBandControlChannel> channel = inBandFactory.Create<SDNInBandControlChannel>();
+            net.controlDevices.Add(channel->Install(swtch, node, net.controllerNode));
+        } else if (m_controlChannel) {
+            swtch->SetControlChannel(m_channelFactory.Create<SDNControlChannel>());
+        }
+        net.switches.push_back(swtch);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    net.controller->PopulateRoutingTable(net.hosts, net.switchNodes, net.devices);
+    net.routeComputationSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    NS_LOG_INFO("SDNTopologyHelper: Built " << nSwitches << " switches, " << hostSwitch.size()
+                << " hosts, " << links.size() << " switch links; routes in "
+                << net.routeComputationSeconds << " s");
+    if (m_systemCount > 1) {
+        NS_LOG_INFO("SDNTopologyHelper: " << m_systemCount << " systems, " << net.nCrossRankLinks
+                    << " switch links cross them");
+    }
+    return net;
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,119 @@
+#ifndef SDN_TOPOLOGY_HELPER_H
+#define SDN_TOPOLOGY_HELPER_H
+
+#include "ns3/sdn-controller.h"
+#include "ns3/sdn-switch.h"
+#include "ns3/sdn-flow-table.h"
+#include "ns3/sdn-control-channel.h"
+#include "ns3/sdn-inband-control-channel.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/object-factory.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/random-variable-stream.h"
+
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+namespace sdn {
+
+// What SDNTopologyHelper built
+struct SDNNetwork {
+    NodeContainer hosts;
+    NodeContainer switchNodes;
+    std::vector<Ptr<SDNSwitch>> switches;     // switches[i] forwards for switchNodes.Get(i)
+    Ptr<SDNController> controller;
+    Ipv4InterfaceContainer hostAddresses;     // GetAddress(i) belongs to hosts.Get(i)
+    NetDeviceContainer devices;               // Both ends of every link
+    uint32_t nSwitchLinks = 0;
+    double routeComputationSeconds = 0;       // Wall-clock time of PopulateRoutingTable
+    Ptr<Node> controllerNode;                 // In-band control only
+    NetDeviceContainer controlDevices;        // Both ends of every in-band control link
+    uint32_t nCrossRankLinks = 0;             // Switch links with ends on different system ids
+};
+
+// Builds SDN networks in one call: hosts and switch nodes joined by point-to-point links, an
+// SDNSwitch with its own SDNFlowTable on every switch node, and one SDNController that has
+// computed all routes. Hosts share one IPv4 subnet (SetBase), so at the IP layer every host
+// is one hop from every other and the switches do all the forwarding.
+//
+// Switches are numbered as documented per builder. Random graphs draw from an ns-3 random
+// stream, so RngSeed/RngRun (or AssignStreams) select the graph.
+class SDNTopologyHelper
+{
+public:
+    SDNTopologyHelper();
+
+    // Links default to 10Gbps with 1us of delay
+    void SetLinkDeviceAttribute(std::string name, const AttributeValue& value);
+    void SetLinkChannelAttribute(std::string name, const AttributeValue& value);
+    void SetControllerAttribute(std::string name, const AttributeValue& value);
+    void SetSwitchAttribute(std::string name, const AttributeValue& value);
+    void SetFlowTableAttribute(std::string name, const AttributeValue& value);
+    // With a control channel, each switch talks to the controller over its own SDNControlChannel;
+    // without one (the default) the controller is called synchronously
+    void EnableControlChannel(bool enable);
+    void SetControlChannelAttribute(std::string name, const AttributeValue& value);
+    // Control over SDNInBandControlChannel links to a controller node instead
+    void EnableInBandControl(bool enable);
+    // Spreads the network over n ranks of ns-3's distributed simulator (MpiInterface::GetSize()).
+    // Every node gets a system id, the controller node sits on rank 0 and control is in-band,
+    // so control messages cross ranks as packets. The lookahead is the smallest delay of any
+    // link between ranks, data links (1us by default) included: a longer one needs both the
+    // control channel Delay and the link Delay (SetLinkChannelAttribute) raised.
+    // Fat-trees are split by pod and leaf-spine networks by leaf, with the core or spine layer
+    // dealt out round robin; other topologies are split into blocks of consecutive switch
+    // indexes. Hosts go with their switch. Every rank must build the same network.
+    void SetSystemCount(uint32_t n);
+    // Host address range; defaults to 10.0.0.0/8
+    void SetBase(Ipv4Address network, Ipv4Mask mask);
+    int64_t AssignStreams(int64_t stream);
+
+    // k-ary fat-tree (k even): (k/2)^2 core switches first, then per pod k/2 aggregation and
+    // k/2 edge switches; k/2 hosts per edge switch, k^3/4 in all
+    SDNNetwork FatTree(uint32_t k);
+    // Leaves first, then spines; every leaf links to every spine
+    SDNNetwork LeafSpine(uint32_t leaves, uint32_t spines, uint32_t hostsPerLeaf);
+    // rows x cols grid, row by row, wrapping around in each dimension longer than two
+    SDNNetwork Torus(uint32_t rows, uint32_t cols, uint32_t hostsPerSwitch);
+    SDNNetwork Linear(uint32_t nSwitches, uint32_t hostsPerSwitch);
+    // Waxman random graph: switches placed uniformly in the unit square, each pair linked with
+    // probability beta * exp(-d / (alpha * sqrt(2))). Components are chained together so the
+    // network is connected.
+    SDNNetwork Waxman(uint32_t nSwitches, double alpha, double beta, uint32_t hostsPerSwitch);
+    // Barabasi-Albert preferential attachment: a clique of m + 1 switches, then each further
+    // switch links to m distinct earlier ones with probability proportional to their degree
+    SDNNetwork BarabasiAlbert(uint32_t nSwitches, uint32_t m, uint32_t hostsPerSwitch);
+
+    // Any topology: switch-to-switch links as index pairs, and for each host the switch it hangs
+    // off. systemIds gives each switch's rank; if empty, switches are split into consecutive blocks.
+    SDNNetwork Build(uint32_t nSwitches, const std::vector<std::pair<uint32_t, uint32_t>>& links,
+                     const std::vector<uint32_t>& hostSwitch,
+                     const std::vector<uint32_t>& systemIds = std::vector<uint32_t>());
+
+private:
+    static std::vector<uint32_t> SpreadHosts(uint32_t nSwitches, uint32_t hostsPerSwitch);
+    // Rank of the i-th of n items split into consecutive blocks, and dealt out round robin
+    uint32_t BlockRank(uint32_t i, uint32_t n) const;
+    uint32_t RoundRobinRank(uint32_t i) const;
+
+    PointToPointHelper m_link;
+    ObjectFactory m_controllerFactory;
+    ObjectFactory m_switchFactory;
+    ObjectFactory m_flowTableFactory;
+    ObjectFactory m_channelFactory;
+    bool m_controlChannel;
+    bool m_inBandControl;
+    uint32_t m_systemCount;
+    Ipv4Address m_network;
+    Ipv4Mask m_mask;
+    Ptr<UniformRandomVariable> m_random;
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_TOPOLOGY_HELPER_H
@@ -1,6 +1,8 @@
 #ifndef CONTROL_PACKET_H
 #define CONTROL_PACKET_H
 
+#include <vector>
+
 namespace ns3 {
 namespace sdn {
 
@@ -8,32 +10,53 @@ enum controlType {
   ARPPacket,            // Handle ARP resolution
   IPPacket,             // Forwarding decision for general IP packets
   FlowAdd,              // Add a new flow rule to a switch
-  FlowDelete,           // Remove a flow rule
+  FlowDelete,           // Remove the flow rules towards flowEntry.dstIp
   FlowModify,           // Modify an existing flow rule
+  FlowRemoved,          // Switch reports a flow it dropped on its own, with final counters
   LinkStateUpdate,      // Topology update notification
   StatsRequest,         // Controller asking switch for stats
   StatsReply,           // Switch replies with flow/table stats
   PacketIn,             // Packet arrived at switch with no matching rule
-  PacketOut,            // Controller sends packet out a port
+  PacketOut,            // Controller sends packet out a port (an ARP request out of flowEntry.outputDevice)
   SwitchJoin,           // A switch joins the network
   SwitchLeave,          // A switch disconnects or fails
   Hello,                // Initial handshake (e.g., between switch and controller)
   BarrierRequest,       // Synchronization barrier (for ordered message handling)
   BarrierReply,         // Response to BarrierRequest
+  ArpCacheUpdate,       // Controller pushes IP -> MAC bindings into a switch's ARP cache
   Error                 // Incomplete control packet
 };
 
+// bufferId of a FlowAdd that releases no buffered packets (OpenFlow's OFP_NO_BUFFER)
+const uint32_t kNoBuffer = 0xffffffff;
+
+// One rule of a bulk FlowAdd and the switch buffer it releases
+struct FlowMod {
+    FlowEntry entry;
+    uint32_t bufferId = kNoBuffer;
+};
+
 struct controlPacket {
-    controlType type;
+    controlType type = Error;
     Ipv4Address srcIp;
     Ipv4Address dstIp;
-    uint8_t protocolNumber;
-    uint16_t srcPort;
-    uint16_t dstPort;
+    uint8_t protocolNumber = 0;
+    uint16_t srcPort = 0;
+    uint16_t dstPort = 0;
     Address srcMac;
     Address dstMac;
-    FlowEntry* flow;
-  };
+    FlowId flow = kNoFlow;          // Synchronous FlowAdd: the installed rule, kNoFlow if none
+    bool linkUp = false;            // LinkStateUpdate: new state of the port the message refers to
+    uint64_t packetCount = 0;       // FlowRemoved: final counters of the flow
+    uint64_t byteCount = 0;
+    FlowRemovedReason removedReason = IdleTimeoutExpired;
+    uint32_t xid = 0;               // Transaction id; a reply over a control channel echoes its request's
+    uint32_t bufferId = kNoBuffer;  // PacketIn/FlowAdd: switch buffer holding the missed packets of the flow
+    FlowEntry flowEntry;            // FlowAdd reply over a control channel: the rule to install
+    std::vector<FlowMod> flowMods;  // Bulk FlowAdd: several rules in one message, installed in order
+    bool arpReply = false;          // ARPPacket: a reply seen by the switch; srcIp/srcMac is a binding to learn
+    std::vector<std::pair<Ipv4Address, Address>> arpEntries;   // ArpCacheUpdate
+};
 
 } // namespace sdn
 } // namespace ns3
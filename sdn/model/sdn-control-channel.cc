@@ -0,0 +1,156 @@
+#include "sdn-control-channel.h"
+#include "sdn-switch.h"
+#include "sdn-controller.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNControlChannel");
+
+// IPv4 address plus MAC address of one pushed ARP binding
+static const uint32_t kArpBindingSize = 10;
+
+TypeId SDNControlChannel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::sdn::SDNControlChannel")
+        .SetParent<Object>()
+        .SetGroupName("SDN")
+        .AddConstructor<SDNControlChannel>()
+        .AddAttribute("Delay",
+                      "Propagation delay between a switch and the controller",
+                      TimeValue(MilliSeconds(1)),
+                      MakeTimeAccessor(&SDNControlChannel::m_delay),
+                      MakeTimeChecker())
+        .AddAttribute("DataRate",
+                      "Transmit rate of each direction of the channel",
+                      DataRateValue(DataRate("1Gbps")),
+                      MakeDataRateAccessor(&SDNControlChannel::m_dataRate),
+                      MakeDataRateChecker())
+        .AddAttribute("MessageSize",
+                      "Bytes on the wire per control message; 0 sizes each message by its OpenFlow 1.0 encoding",
+                      UintegerValue(128),
+                      MakeUintegerAccessor(&SDNControlChannel::m_messageSize),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("FlowModSize",
+                      "Extra bytes per additional rule in a bulk FlowAdd",
+                      UintegerValue(64),
+                      MakeUintegerAccessor(&SDNControlChannel::m_flowModSize),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("MaxQueueSize",
+                      "Messages that can wait for transmission in each direction",
+                      UintegerValue(1000),
+                      MakeUintegerAccessor(&SDNControlChannel::m_maxQueueSize),
+                      MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+SDNControlChannel::SDNControlChannel()
+    : m_messageSize(128),
+      m_flowModSize(64),
+      m_maxQueueSize(1000),
+      m_sent(0),
+      m_dropped(0),
+      m_bytesSent(0)
+{
+    NS_LOG_INFO("SDNControlChannel created");
+}
+
+SDNControlChannel::~SDNControlChannel()
+{
+}
+
+// A bulk FlowAdd shares one message header among all of its rules
+uint32_t SDNControlChannel::GetMessageSize(const controlPacket& ctrl, SDNControlHeader::Direction direction) const
+{
+    if (m_messageSize == 0) {
+        return SDNControlHeader(ctrl, direction, nullptr).GetSerializedSize();
+    }
+    if (ctrl.type == FlowAdd && ctrl.flowMods.size() > 1) {
+        return m_messageSize + (ctrl.flowMods.size() - 1) * m_flowModSize;
+    }
+    if (ctrl.type == ArpCacheUpdate) {
+        return m_messageSize + ctrl.arpEntries.size() * kArpBindingSize;
+    }
+    return m_messageSize;
+}
+
+// Queue occupancy is the set of messages whose transmission has not finished yet;
+// finished ones are retired lazily, so no event is needed per transmission
+
+bool SDNControlChannel::Transmit(Direction& direction, uint32_t bytes, Time& arrival)
+{
+    Time now = Simulator::Now();
+    while (!direction.txDone.empty() && direction.txDone.front() <= now) {
+        direction.txDone.pop_front();
+    }
+    if (direction.txDone.size() >= m_maxQueueSize) {
+        m_dropped++;
+        return false;
+    }
+
+    Time start = direction.busyUntil > now ? direction.busyUntil : now;
+    direction.busyUntil = start + m_dataRate.CalculateBytesTxTime(bytes);
+    direction.txDone.push_back(direction.busyUntil);
+    arrival = direction.busyUntil + m_delay - now;
+    m_sent++;
+    m_bytesSent += bytes;
+    return true;
+}
+
+bool SDNControlChannel::SendToController(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port)
+{
+    Time delay;
+    if (!Transmit(m_up, GetMessageSize(ctrl, SDNControlHeader::ToController), delay)) {
+        NS_LOG_WARN("SDNControlChannel: Queue to controller full, dropping message type " << ctrl.type);
+        return false;
+    }
+    Simulator::Schedule(delay, &SDNControlChannel::DeliverToController, this, swtch, ctrl, port);
+    return true;
+}
+
+bool SDNControlChannel::SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl)
+{
+    Time delay;
+    if (!Transmit(m_down, GetMessageSize(ctrl, SDNControlHeader::ToSwitch), delay)) {
+        NS_LOG_WARN("SDNControlChannel: Queue to switch full, dropping message type " << ctrl.type);
+        return false;
+    }
+    Simulator::Schedule(delay, &SDNControlChannel::DeliverToSwitch, this, swtch, ctrl);
+    return true;
+}
+
+void SDNControlChannel::DeliverToController(Ptr<SDNSwitch> swtch, controlPacket ctrl, Ptr<NetDevice> port)
+{
+    swtch->m_controller->HandlePacketIn(swtch, &ctrl, port);
+}
+
+void SDNControlChannel::DeliverToSwitch(Ptr<SDNSwitch> swtch, controlPacket ctrl)
+{
+    swtch->HandleControlMessage(ctrl);
+}
+
+bool SDNControlChannel::IsInBand() const
+{
+    return false;
+}
+
+uint64_t SDNControlChannel::GetNSent() const
+{
+    return m_sent;
+}
+
+uint64_t SDNControlChannel::GetNDropped() const
+{
+    return m_dropped;
+}
+
+uint64_t SDNControlChannel::GetNBytesSent() const
+{
+    return m_bytesSent;
+}
+
+} // namespace sdn
+} // namespace ns3
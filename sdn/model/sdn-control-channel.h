@@ -0,0 +1,72 @@
+#ifndef SDN_CONTROL_CHANNEL_H
+#define SDN_CONTROL_CHANNEL_H
+
+#include <deque>
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/net-device.h"
+#include "sdn-flow-table.h"
+#include "control-packet.h"
+#include "sdn-control-header.h"
+
+namespace ns3 {
+namespace sdn {
+
+class SDNSwitch;
+class SDNController;
+
+// Out-of-band link between switches and the controller. Each direction is a FIFO with a
+// finite transmit rate and queue; a message arrives one propagation delay after it has been
+// serialized, as a scheduled simulator event. Messages that find the queue full are dropped.
+// One channel can be shared by several switches (they then share its capacity).
+class SDNControlChannel : public Object
+{
+public:
+    static TypeId GetTypeId();
+    SDNControlChannel();
+    virtual ~SDNControlChannel();
+
+    // Both return false if the message was dropped
+    virtual bool SendToController(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port);
+    virtual bool SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl);
+    // True when messages are packets on simulated links (SDNInBandControlChannel); the
+    // controller then changes a switch's state only through messages
+    virtual bool IsInBand() const;
+
+    uint64_t GetNSent() const;
+    uint64_t GetNDropped() const;
+    // Bytes of the messages sent, as sized by MessageSize or their encoding
+    uint64_t GetNBytesSent() const;
+
+protected:
+    uint32_t GetMessageSize(const controlPacket& ctrl, SDNControlHeader::Direction direction) const;
+
+    Time m_delay;
+    DataRate m_dataRate;
+    uint32_t m_messageSize;
+    uint32_t m_flowModSize;
+    uint32_t m_maxQueueSize;
+    uint64_t m_sent;
+    uint64_t m_dropped;
+    uint64_t m_bytesSent;
+
+private:
+    struct Direction {
+        Time busyUntil;              // End of the transmission in progress
+        std::deque<Time> txDone;     // Completion times of messages not yet fully sent
+    };
+
+    bool Transmit(Direction& direction, uint32_t bytes, Time& arrival);
+    void DeliverToController(Ptr<SDNSwitch> swtch, controlPacket ctrl, Ptr<NetDevice> port);
+    void DeliverToSwitch(Ptr<SDNSwitch> swtch, controlPacket ctrl);
+
+    Direction m_up;      // Switch -> controller
+    Direction m_down;    // Controller -> switch
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_CONTROL_CHANNEL_H
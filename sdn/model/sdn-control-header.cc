@@ -0,0 +1,900 @@
+#include "sdn-control-header.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/mac48-address.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNControlHeader");
+NS_OBJECT_ENSURE_REGISTERED(SDNControlHeader);
+
+// OpenFlow 1.0 wire values. The openflow library ns-3 links against implements an earlier
+// draft with different numbering, so they are spelled out here.
+namespace of10 {
+const uint8_t kVersion = 0x01;
+
+enum Type : uint8_t {
+    Hello = 0, Error = 1, Vendor = 4, PacketIn = 10, FlowRemoved = 11, PortStatus = 12,
+    PacketOut = 13, FlowMod = 14, StatsRequest = 16, StatsReply = 17, BarrierRequest = 18,
+    BarrierReply = 19
+};
+
+const uint16_t kFlowModAdd = 0;
+const uint16_t kFlowModModify = 1;
+const uint16_t kFlowModDelete = 3;
+
+const uint32_t kWildcardInPort = 1 << 0;
+const uint32_t kWildcardDlVlan = 1 << 1;
+const uint32_t kWildcardDlSrc = 1 << 2;
+const uint32_t kWildcardDlDst = 1 << 3;
+const uint32_t kWildcardNwProto = 1 << 5;
+const uint32_t kWildcardTpSrc = 1 << 6;
+const uint32_t kWildcardTpDst = 1 << 7;
+const uint32_t kNwSrcShift = 8;
+const uint32_t kNwDstShift = 14;
+const uint32_t kWildcardDlVlanPcp = 1 << 20;
+const uint32_t kWildcardNwTos = 1 << 21;
+
+const uint8_t kReasonNoMatch = 0;
+const uint8_t kReasonAction = 1;
+const uint8_t kRemovedIdleTimeout = 0;
+const uint8_t kRemovedHardTimeout = 1;
+const uint8_t kRemovedDelete = 2;
+const uint8_t kPortAdd = 0;
+const uint8_t kPortDelete = 1;
+const uint8_t kPortModify = 2;
+const uint32_t kPortConfigDown = 1 << 0;
+const uint32_t kPortStateLinkDown = 1 << 0;
+
+const uint16_t kPortMax = 0xff00;
+const uint16_t kPortInPort = 0xfff8;
+const uint16_t kPortLocal = 0xfffe;
+const uint16_t kPortNone = 0xffff;
+const uint16_t kActionOutput = 0;
+const uint16_t kStatsAggregate = 2;
+const uint16_t kErrorBadRequest = 1;
+const uint16_t kBadRequestBadType = 1;
+
+const uint32_t kHeaderSize = 8;
+const uint32_t kMatchSize = 40;
+const uint32_t kActionOutputSize = 8;
+const uint32_t kPacketInSize = 18;          // Up to the frame
+const uint32_t kPacketOutSize = 16;         // Up to the actions
+const uint32_t kFlowModSize = 72;           // Without actions
+const uint32_t kFlowRemovedSize = 88;
+const uint32_t kPortStatusSize = 64;
+const uint32_t kStatsRequestSize = 12 + kMatchSize + 4;
+const uint32_t kStatsReplySize = 12 + 24;
+const uint32_t kErrorSize = 12;
+} // namespace of10
+
+// Vendor message carrying ArpCacheUpdate bindings: vendor id, count, then per binding the
+// IPv4 address, the MAC address and two bytes of padding. An update too large for the 16-bit
+// message length is split over several messages, all but the last flagged in their count.
+static const uint32_t kSdnVendorId = 0x53444e00;   // "SDN"
+static const uint32_t kArpBindingSize = 12;
+static const uint32_t kMaxArpBindings = (0xffff - of10::kHeaderSize - 8) / kArpBindingSize;
+static const uint32_t kMoreBindings = 0x80000000;
+// Set in every flow_mod of a bulk FlowAdd except the last
+static const uint16_t kMoreFlowMods = 0x8000;
+
+// Frames rebuilt for PacketIn and PacketOut: Ethernet, then IPv4 and the two transport ports,
+// or ARP for IPv4 over Ethernet
+static const uint32_t kEthernetSize = 14;
+static const uint32_t kIpFrameSize = kEthernetSize + 20 + 4;
+static const uint32_t kArpFrameSize = kEthernetSize + 28;
+static const uint16_t kEtherTypeIpv4 = 0x0800;
+static const uint16_t kEtherTypeArp = 0x0806;
+static const uint16_t kArpRequest = 1;
+static const uint16_t kArpReply = 2;
+
+static void WriteMac(Buffer::Iterator& i, const Address& address)
+{
+    uint8_t mac[6] = {0, 0, 0, 0, 0, 0};
+    if (Mac48Address::IsMatchingType(address)) {
+        Mac48Address::ConvertFrom(address).CopyTo(mac);
+    }
+    i.Write(mac, 6);
+}
+
+static void WriteBroadcastMac(Buffer::Iterator& i)
+{
+    i.WriteU8(0xff, 6);
+}
+
+// All zeros reads back as an invalid Address, the controller's "no binding" answer
+static Address ReadMac(Buffer::Iterator& i)
+{
+    uint8_t mac[6];
+    i.Read(mac, 6);
+    if ((mac[0] | mac[1] | mac[2] | mac[3] | mac[4] | mac[5]) == 0) return Address();
+    Mac48Address address;
+    address.CopyFrom(mac);
+    return address;
+}
+
+static Ipv4Mask PrefixMask(uint32_t wildcardBits)
+{
+    uint32_t length = wildcardBits >= 32 ? 0 : 32 - wildcardBits;
+    return Ipv4Mask(length == 0 ? 0 : 0xffffffffu << (32 - length));
+}
+
+static bool IsFullRange(uint16_t port, uint16_t portMax)
+{
+    return port == 0 && portMax == 65535;
+}
+
+// Exact 5-tuple rule for messages that name a flow by its key
+static FlowEntry KeyEntry(const controlPacket& ctrl)
+{
+    FlowEntry entry;
+    entry.srcIp = ctrl.srcIp;
+    entry.dstIp = ctrl.dstIp;
+    entry.srcPort = ctrl.srcPort;
+    entry.dstPort = ctrl.dstPort;
+    entry.protocol = ctrl.protocolNumber;
+    return entry;
+}
+
+static void WriteMatch(Buffer::Iterator& i, const FlowEntry& entry)
+{
+    uint32_t wildcards = of10::kWildcardInPort | of10::kWildcardDlVlan | of10::kWildcardDlSrc | of10::kWildcardDlDst
+                       | of10::kWildcardDlVlanPcp | of10::kWildcardNwTos
+                       | ((32u - entry.srcMask.GetPrefixLength()) << of10::kNwSrcShift)
+                       | ((32u - entry.dstMask.GetPrefixLength()) << of10::kNwDstShift);
+    if (entry.anyProtocol) wildcards |= of10::kWildcardNwProto;
+    if (IsFullRange(entry.srcPort, entry.srcPortMax)) wildcards |= of10::kWildcardTpSrc;
+    if (IsFullRange(entry.dstPort, entry.dstPortMax)) wildcards |= of10::kWildcardTpDst;
+
+    i.WriteHtonU32(wildcards);
+    i.WriteHtonU16(0);                 // in_port
+    i.WriteU8(0, 12);                  // dl_src, dl_dst
+    i.WriteHtonU16(0xffff);            // dl_vlan: none
+    i.WriteU8(0, 2);                   // dl_vlan_pcp, pad
+    i.WriteHtonU16(kEtherTypeIpv4);
+    i.WriteU8(0);                      // nw_tos
+    i.WriteU8(entry.protocol);
+    i.WriteU8(0, 2);
+    i.WriteHtonU32(entry.srcIp.Get());
+    i.WriteHtonU32(entry.dstIp.Get());
+    i.WriteHtonU16(entry.srcPort);
+    i.WriteHtonU16(entry.dstPort);
+}
+
+// Returns the wildcards; port range maxima are left for the cookie
+static uint32_t ReadMatch(Buffer::Iterator& i, FlowEntry& entry)
+{
+    uint32_t wildcards = i.ReadNtohU32();
+    i.Next(2 + 12 + 2 + 2 + 2 + 1);
+    entry.protocol = i.ReadU8();
+    i.Next(2);
+    entry.srcIp = Ipv4Address(i.ReadNtohU32());
+    entry.dstIp = Ipv4Address(i.ReadNtohU32());
+    entry.srcPort = i.ReadNtohU16();
+    entry.dstPort = i.ReadNtohU16();
+    entry.srcMask = PrefixMask((wildcards >> of10::kNwSrcShift) & 0x3f);
+    entry.dstMask = PrefixMask((wildcards >> of10::kNwDstShift) & 0x3f);
+    entry.anyProtocol = (wildcards & of10::kWildcardNwProto) != 0;
+    return wildcards;
+}
+
+// Shortest length a message of the given type can declare and still hold the fixed part of
+// its body; PacketIn frames and PacketOut actions are checked as they are read
+static uint32_t MinMessageSize(uint8_t type)
+{
+    switch (type) {
+    case of10::PacketIn:
+        return of10::kPacketInSize + kEthernetSize;
+    case of10::PacketOut:
+        return of10::kPacketOutSize + kArpFrameSize;
+    case of10::FlowMod:
+        return of10::kFlowModSize;
+    case of10::FlowRemoved:
+        return of10::kFlowRemovedSize;
+    case of10::PortStatus:
+        return of10::kPortStatusSize;
+    case of10::StatsRequest:
+        return of10::kStatsRequestSize;
+    case of10::StatsReply:
+        return of10::kStatsReplySize;
+    case of10::Vendor:
+        return of10::kHeaderSize + 8;
+    default:
+        return of10::kHeaderSize;
+    }
+}
+
+static void WriteOfpHeader(Buffer::Iterator& i, uint8_t type, uint32_t length, uint32_t xid)
+{
+    NS_ASSERT_MSG(length <= 0xffff, "SDNControlHeader: Message too long for the OpenFlow length field");
+    i.WriteU8(of10::kVersion);
+    i.WriteU8(type);
+    i.WriteHtonU16(length);
+    i.WriteHtonU32(xid);
+}
+
+static void WriteArpFrame(Buffer::Iterator& i, uint16_t operation, const Address& sha, Ipv4Address spa,
+                          const Address& tha, Ipv4Address tpa)
+{
+    if (operation == kArpRequest) {
+        WriteBroadcastMac(i);
+    } else {
+        WriteMac(i, tha);
+    }
+    WriteMac(i, sha);
+    i.WriteHtonU16(kEtherTypeArp);
+    i.WriteHtonU16(1);                 // Ethernet
+    i.WriteHtonU16(kEtherTypeIpv4);
+    i.WriteU8(6);
+    i.WriteU8(4);
+    i.WriteHtonU16(operation);
+    WriteMac(i, sha);
+    i.WriteHtonU32(spa.Get());
+    WriteMac(i, tha);
+    i.WriteHtonU32(tpa.Get());
+}
+
+// Reads the ARP part of a frame whose Ethernet header has been consumed
+static uint16_t ReadArp(Buffer::Iterator& i, Address& sha, Ipv4Address& spa, Address& tha, Ipv4Address& tpa)
+{
+    i.Next(6);
+    uint16_t operation = i.ReadNtohU16();
+    sha = ReadMac(i);
+    spa = Ipv4Address(i.ReadNtohU32());
+    tha = ReadMac(i);
+    tpa = Ipv4Address(i.ReadNtohU32());
+    return operation;
+}
+
+TypeId SDNControlHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::sdn::SDNControlHeader")
+        .SetParent<Header>()
+        .SetGroupName("SDN")
+        .AddConstructor<SDNControlHeader>();
+    return tid;
+}
+
+SDNControlHeader::SDNControlHeader()
+    : m_ctrl(&m_own),
+      m_target(&m_own),
+      m_direction(ToController),
+      m_portNumber(of10::kPortNone)
+{
+    m_own.type = Error;
+}
+
+SDNControlHeader::SDNControlHeader(const controlPacket& ctrl, Direction direction, Ptr<Node> switchNode)
+    : m_ctrl(&ctrl),
+      m_target(nullptr),
+      m_direction(direction),
+      m_switchNode(switchNode),
+      m_portNumber(of10::kPortNone)
+{
+}
+
+SDNControlHeader::SDNControlHeader(controlPacket& target, Ptr<Node> switchNode)
+    : m_ctrl(&target),
+      m_target(&target),
+      m_direction(ToController),
+      m_switchNode(switchNode),
+      m_portNumber(of10::kPortNone)
+{
+}
+
+SDNControlHeader::SDNControlHeader(const SDNControlHeader& other)
+    : Header(other),
+      m_own(other.m_own),
+      m_ctrl(other.m_ctrl == &other.m_own ? &m_own : other.m_ctrl),
+      m_target(other.m_target == &other.m_own ? &m_own : other.m_target),
+      m_direction(other.m_direction),
+      m_switchNode(other.m_switchNode),
+      m_port(other.m_port),
+      m_portNumber(other.m_portNumber)
+{
+}
+
+SDNControlHeader& SDNControlHeader::operator=(const SDNControlHeader& other)
+{
+    if (this != &other) {
+        m_own = other.m_own;
+        m_ctrl = other.m_ctrl == &other.m_own ? &m_own : other.m_ctrl;
+        m_target = other.m_target == &other.m_own ? &m_own : other.m_target;
+        m_direction = other.m_direction;
+        m_switchNode = other.m_switchNode;
+        m_port = other.m_port;
+        m_portNumber = other.m_portNumber;
+    }
+    return *this;
+}
+
+TypeId SDNControlHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+const controlPacket& SDNControlHeader::GetControlPacket() const
+{
+    return *m_ctrl;
+}
+
+SDNControlHeader::Direction SDNControlHeader::GetDirection() const
+{
+    return m_direction;
+}
+
+void SDNControlHeader::SetPort(Ptr<NetDevice> port)
+{
+    m_port = port;
+}
+
+Ptr<NetDevice> SDNControlHeader::GetPort() const
+{
+    return m_port;
+}
+
+uint16_t SDNControlHeader::GetPortNumber(Ptr<NetDevice> device) const
+{
+    return device ? device->GetIfIndex() + 1 : of10::kPortNone;
+}
+
+Ptr<NetDevice> SDNControlHeader::GetDevice(uint16_t port) const
+{
+    if (!m_switchNode || port == 0 || port > of10::kPortMax || port > m_switchNode->GetNDevices()) {
+        return nullptr;
+    }
+    return m_switchNode->GetDevice(port - 1);
+}
+
+uint8_t SDNControlHeader::GetMessageType() const
+{
+    switch (m_ctrl->type) {
+    case FlowAdd:
+        return m_direction == ToController ? of10::PacketIn : of10::FlowMod;
+    case ARPPacket:
+        return m_direction == ToController ? of10::PacketIn : of10::PacketOut;
+    case IPPacket:
+    case PacketIn:
+        return of10::PacketIn;
+    case FlowModify:
+    case FlowDelete:
+        return of10::FlowMod;
+    case FlowRemoved:
+        return of10::FlowRemoved;
+    case LinkStateUpdate:
+    case SwitchJoin:
+    case SwitchLeave:
+        return of10::PortStatus;
+    case StatsRequest:
+        return of10::StatsRequest;
+    case StatsReply:
+        return of10::StatsReply;
+    case PacketOut:
+        return of10::PacketOut;
+    case Hello:
+        return of10::Hello;
+    case BarrierRequest:
+        return of10::BarrierRequest;
+    case BarrierReply:
+        return of10::BarrierReply;
+    case ArpCacheUpdate:
+        return of10::Vendor;
+    default:
+        return of10::Error;
+    }
+}
+
+uint32_t SDNControlHeader::GetSerializedSize() const
+{
+    const controlPacket& ctrl = *m_ctrl;
+    switch (GetMessageType()) {
+    case of10::PacketIn:
+        return of10::kPacketInSize + (ctrl.type == ARPPacket ? kArpFrameSize : kIpFrameSize);
+    case of10::PacketOut:
+        return of10::kPacketOutSize + of10::kActionOutputSize + kArpFrameSize;
+    case of10::FlowMod:
+        if (ctrl.type == FlowAdd && !ctrl.flowMods.empty()) {
+            uint32_t size = 0;
+            for (const auto& mod : ctrl.flowMods) {
+                size += of10::kFlowModSize + (mod.entry.outputDevice ? of10::kActionOutputSize : 0);
+            }
+            return size;
+        }
+        return of10::kFlowModSize + (ctrl.flowEntry.outputDevice ? of10::kActionOutputSize : 0);
+    case of10::FlowRemoved:
+        return of10::kFlowRemovedSize;
+    case of10::PortStatus:
+        return of10::kPortStatusSize;
+    case of10::StatsRequest:
+        return of10::kStatsRequestSize;
+    case of10::StatsReply:
+        return of10::kStatsReplySize;
+    case of10::Vendor: {
+        uint32_t messages = std::max<uint32_t>(1, (ctrl.arpEntries.size() + kMaxArpBindings - 1) / kMaxArpBindings);
+        return messages * (of10::kHeaderSize + 8) + ctrl.arpEntries.size() * kArpBindingSize;
+    }
+    case of10::Error:
+        return of10::kErrorSize;
+    default:
+        return of10::kHeaderSize;
+    }
+}
+
+void SDNControlHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    const controlPacket& ctrl = *m_ctrl;
+    uint8_t type = GetMessageType();
+
+    if (type == of10::FlowMod) {
+        if (ctrl.type == FlowAdd && !ctrl.flowMods.empty()) {
+            for (size_t m = 0; m < ctrl.flowMods.size(); m++) {
+                SerializeFlowMod(i, ctrl.flowMods[m].entry, ctrl.flowMods[m].bufferId,
+                                 m + 1 < ctrl.flowMods.size() ? kMoreFlowMods : 0);
+            }
+        } else {
+            SerializeFlowMod(i, ctrl.flowEntry, ctrl.type == FlowAdd ? ctrl.bufferId : kNoBuffer, 0);
+        }
+        return;
+    }
+    if (type == of10::Vendor) {
+        size_t b = 0;
+        do {
+            uint32_t count = std::min<size_t>(ctrl.arpEntries.size() - b, kMaxArpBindings);
+            WriteOfpHeader(i, type, of10::kHeaderSize + 8 + count * kArpBindingSize, ctrl.xid);
+            i.WriteHtonU32(kSdnVendorId);
+            i.WriteHtonU32(count | (b + count < ctrl.arpEntries.size() ? kMoreBindings : 0));
+            for (uint32_t e = 0; e < count; e++, b++) {
+                i.WriteHtonU32(ctrl.arpEntries[b].first.Get());
+                WriteMac(i, ctrl.arpEntries[b].second);
+                i.WriteU8(0, 2);
+            }
+        } while (b < ctrl.arpEntries.size());
+        return;
+    }
+
+    WriteOfpHeader(i, type, GetSerializedSize(), ctrl.xid);
+    switch (type) {
+    case of10::PacketIn:
+        SerializePacketIn(i);
+        break;
+    case of10::PacketOut:
+        SerializePacketOut(i);
+        break;
+    case of10::FlowRemoved: {
+        WriteMatch(i, KeyEntry(ctrl));
+        i.WriteHtonU64(0);             // cookie
+        i.WriteHtonU16(0);             // priority
+        i.WriteU8(ctrl.removedReason == IdleTimeoutExpired ? of10::kRemovedIdleTimeout
+                  : ctrl.removedReason == HardTimeoutExpired ? of10::kRemovedHardTimeout : of10::kRemovedDelete);
+        i.WriteU8(0);
+        i.WriteU8(0, 8);               // duration
+        i.WriteHtonU16(0);             // idle_timeout
+        i.WriteU8(0, 2);
+        i.WriteHtonU64(ctrl.packetCount);
+        i.WriteHtonU64(ctrl.byteCount);
+        break;
+    }
+    case of10::PortStatus: {
+        bool local = ctrl.type != LinkStateUpdate;
+        bool down = ctrl.type == LinkStateUpdate && !ctrl.linkUp;
+        i.WriteU8(ctrl.type == SwitchJoin ? of10::kPortAdd : ctrl.type == SwitchLeave ? of10::kPortDelete : of10::kPortModify);
+        i.WriteU8(0, 7);
+        i.WriteHtonU16(local ? of10::kPortLocal : GetPortNumber(m_port));
+        WriteMac(i, !local && m_port ? m_port->GetAddress() : Address());
+        i.WriteU8(0, 16);              // name
+        i.WriteHtonU32(down ? of10::kPortConfigDown : 0);
+        i.WriteHtonU32(down ? of10::kPortStateLinkDown : 0);
+        i.WriteU8(0, 20);              // curr, advertised, supported, peer
+        break;
+    }
+    case of10::StatsRequest:
+        i.WriteHtonU16(of10::kStatsAggregate);
+        i.WriteHtonU16(0);
+        WriteMatch(i, KeyEntry(ctrl));
+        i.WriteU8(0xff);               // All tables
+        i.WriteU8(0);
+        i.WriteHtonU16(of10::kPortNone);
+        break;
+    case of10::StatsReply:
+        i.WriteHtonU16(of10::kStatsAggregate);
+        i.WriteHtonU16(0);
+        i.WriteHtonU64(ctrl.packetCount);
+        i.WriteHtonU64(ctrl.byteCount);
+        i.WriteHtonU32(0);             // flow_count
+        i.WriteU8(0, 4);
+        break;
+    case of10::Error:
+        i.WriteHtonU16(of10::kErrorBadRequest);
+        i.WriteHtonU16(of10::kBadRequestBadType);
+        break;
+    default:
+        break;
+    }
+}
+
+void SDNControlHeader::SerializePacketIn(Buffer::Iterator& i) const
+{
+    const controlPacket& ctrl = *m_ctrl;
+    bool arp = ctrl.type == ARPPacket;
+    i.WriteHtonU32(arp ? kNoBuffer : ctrl.bufferId);
+    i.WriteHtonU16(arp ? kArpFrameSize : kIpFrameSize);
+    i.WriteHtonU16(GetPortNumber(m_port));
+    i.WriteU8(ctrl.type == IPPacket ? of10::kReasonAction : of10::kReasonNoMatch);
+    i.WriteU8(0);
+
+    if (arp) {
+        WriteArpFrame(i, ctrl.arpReply ? kArpReply : kArpRequest, ctrl.srcMac, ctrl.srcIp,
+                      ctrl.arpReply ? ctrl.dstMac : Address(), ctrl.dstIp);
+        return;
+    }
+    WriteMac(i, ctrl.dstMac);
+    WriteMac(i, ctrl.srcMac);
+    i.WriteHtonU16(kEtherTypeIpv4);
+    i.WriteU8(0x45);                   // Version 4, no options
+    i.WriteU8(0);
+    i.WriteHtonU16(24);                // Headers only
+    i.WriteU8(0, 4);                   // Identification, fragment
+    i.WriteU8(64);
+    i.WriteU8(ctrl.protocolNumber);
+    i.WriteHtonU16(0);                 // Checksum
+    i.WriteHtonU32(ctrl.srcIp.Get());
+    i.WriteHtonU32(ctrl.dstIp.Get());
+    i.WriteHtonU16(ctrl.srcPort);
+    i.WriteHtonU16(ctrl.dstPort);
+}
+
+// An ARP answer goes back out of the port the request came in on; a flooded request out of
+// flowEntry.outputDevice
+void SDNControlHeader::SerializePacketOut(Buffer::Iterator& i) const
+{
+    const controlPacket& ctrl = *m_ctrl;
+    bool answer = ctrl.type == ARPPacket;
+    i.WriteHtonU32(kNoBuffer);
+    i.WriteHtonU16(of10::kPortNone);
+    i.WriteHtonU16(of10::kActionOutputSize);
+    i.WriteHtonU16(of10::kActionOutput);
+    i.WriteHtonU16(of10::kActionOutputSize);
+    i.WriteHtonU16(answer ? of10::kPortInPort : GetPortNumber(ctrl.flowEntry.outputDevice));
+    i.WriteHtonU16(0);
+    if (answer) {
+        WriteArpFrame(i, kArpReply, ctrl.dstMac, ctrl.dstIp, ctrl.srcMac, ctrl.srcIp);
+    } else {
+        WriteArpFrame(i, kArpRequest, ctrl.srcMac, ctrl.srcIp, Address(), ctrl.dstIp);
+    }
+}
+
+void SDNControlHeader::SerializeFlowMod(Buffer::Iterator& i, const FlowEntry& entry, uint32_t bufferId,
+                                        uint16_t flags) const
+{
+    const controlPacket& ctrl = *m_ctrl;
+    uint16_t command = ctrl.type == FlowDelete ? of10::kFlowModDelete
+                     : ctrl.type == FlowModify ? of10::kFlowModModify : of10::kFlowModAdd;
+    WriteOfpHeader(i, of10::FlowMod, of10::kFlowModSize + (entry.outputDevice ? of10::kActionOutputSize : 0), ctrl.xid);
+    WriteMatch(i, entry);
+    i.WriteHtonU64((static_cast<uint64_t>(entry.srcPortMax) << 16) | entry.dstPortMax);   // cookie
+    i.WriteHtonU16(command);
+    i.WriteHtonU16(entry.idleTimeout);
+    i.WriteHtonU16(entry.hardTimeout);
+    i.WriteHtonU16(entry.priority);
+    i.WriteHtonU32(bufferId);
+    i.WriteHtonU16(of10::kPortNone);
+    i.WriteHtonU16(flags);
+    if (entry.outputDevice) {
+        i.WriteHtonU16(of10::kActionOutput);
+        i.WriteHtonU16(of10::kActionOutputSize);
+        i.WriteHtonU16(GetPortNumber(entry.outputDevice));
+        i.WriteHtonU16(0);
+    }
+}
+
+uint32_t SDNControlHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    if (!m_target) {
+        m_target = &m_own;
+    }
+    controlPacket& ctrl = *m_target;
+    m_ctrl = &ctrl;
+
+    // Reset in place, keeping the capacity of the lists
+    ctrl.flowMods.clear();
+    ctrl.arpEntries.clear();
+    ctrl.arpReply = false;
+    ctrl.flowEntry = FlowEntry();
+    ctrl.srcMac = Address();
+    ctrl.dstMac = Address();
+    ctrl.bufferId = kNoBuffer;
+    ctrl.flow = kNoFlow;
+    ctrl.linkUp = true;
+    ctrl.packetCount = 0;
+    ctrl.byteCount = 0;
+    m_port = nullptr;
+    m_portNumber = of10::kPortNone;
+    m_direction = ToController;
+
+    i.ReadU8();                        // version
+    uint8_t type = i.ReadU8();
+    uint16_t length = i.ReadNtohU16();
+    ctrl.xid = i.ReadNtohU32();
+    if (length < MinMessageSize(type)) {
+        // Reading the body would run past the message; the rest of it is skipped unread
+        NS_LOG_WARN("SDNControlHeader: Message type " << uint32_t(type) << " too short (" << length << " bytes)");
+        ctrl.type = Error;
+        return std::max<uint32_t>(length, of10::kHeaderSize);
+    }
+    uint32_t consumed = length;
+
+    switch (type) {
+    case of10::PacketIn:
+        DeserializePacketIn(i, length);
+        break;
+    case of10::PacketOut:
+        m_direction = ToSwitch;
+        DeserializePacketOut(i, length);
+        break;
+    case of10::FlowMod: {
+        m_direction = ToSwitch;
+        FlowEntry entry;
+        uint32_t bufferId;
+        uint16_t command;
+        uint16_t flags = DeserializeFlowMod(i, length, entry, bufferId, command);
+        ctrl.type = command == of10::kFlowModDelete ? FlowDelete : command == of10::kFlowModModify ? FlowModify : FlowAdd;
+        if (!(flags & kMoreFlowMods)) {
+            ctrl.flowEntry = entry;
+            ctrl.bufferId = bufferId;
+            break;
+        }
+        ctrl.flowMods.push_back(FlowMod{entry, bufferId});
+        while (flags & kMoreFlowMods) {
+            i.Next(2);                 // version, type
+            uint16_t next = i.ReadNtohU16();
+            i.ReadNtohU32();           // xid, shared by the whole bulk message
+            if (next < of10::kFlowModSize) {
+                ctrl.type = Error;
+                return consumed + std::max<uint32_t>(next, of10::kHeaderSize);
+            }
+            flags = DeserializeFlowMod(i, next, entry, bufferId, command);
+            ctrl.flowMods.push_back(FlowMod{entry, bufferId});
+            consumed += next;
+        }
+        break;
+    }
+    case of10::FlowRemoved: {
+        ctrl.type = FlowRemoved;
+        ReadMatch(i, ctrl.flowEntry);
+        ctrl.srcIp = ctrl.flowEntry.srcIp;
+        ctrl.dstIp = ctrl.flowEntry.dstIp;
+        ctrl.srcPort = ctrl.flowEntry.srcPort;
+        ctrl.dstPort = ctrl.flowEntry.dstPort;
+        ctrl.protocolNumber = ctrl.flowEntry.protocol;
+        ctrl.flowEntry = FlowEntry();
+        i.Next(8 + 2);                 // cookie, priority
+        uint8_t reason = i.ReadU8();
+        ctrl.removedReason = reason == of10::kRemovedIdleTimeout ? IdleTimeoutExpired
+                           : reason == of10::kRemovedHardTimeout ? HardTimeoutExpired : FlowEvicted;
+        i.Next(1 + 8 + 2 + 2);
+        ctrl.packetCount = i.ReadNtohU64();
+        ctrl.byteCount = i.ReadNtohU64();
+        break;
+    }
+    case of10::PortStatus: {
+        uint8_t reason = i.ReadU8();
+        i.Next(7);
+        m_portNumber = i.ReadNtohU16();
+        i.Next(6 + 16 + 4);            // hw_addr, name, config
+        uint32_t state = i.ReadNtohU32();
+        i.Next(20);
+        if (m_portNumber == of10::kPortLocal) {
+            ctrl.type = reason == of10::kPortAdd ? SwitchJoin : SwitchLeave;
+        } else {
+            ctrl.type = LinkStateUpdate;
+            ctrl.linkUp = (state & of10::kPortStateLinkDown) == 0;
+            m_port = GetDevice(m_portNumber);
+        }
+        break;
+    }
+    case of10::StatsRequest:
+        ctrl.type = StatsRequest;
+        m_direction = ToSwitch;
+        i.Next(4);
+        ReadMatch(i, ctrl.flowEntry);
+        ctrl.srcIp = ctrl.flowEntry.srcIp;
+        ctrl.dstIp = ctrl.flowEntry.dstIp;
+        ctrl.srcPort = ctrl.flowEntry.srcPort;
+        ctrl.dstPort = ctrl.flowEntry.dstPort;
+        ctrl.protocolNumber = ctrl.flowEntry.protocol;
+        ctrl.flowEntry = FlowEntry();
+        i.Next(4);
+        break;
+    case of10::StatsReply:
+        ctrl.type = StatsReply;
+        i.Next(4);
+        ctrl.packetCount = i.ReadNtohU64();
+        ctrl.byteCount = i.ReadNtohU64();
+        i.Next(8);
+        break;
+    case of10::Vendor: {
+        ctrl.type = ArpCacheUpdate;
+        m_direction = ToSwitch;
+        i.ReadNtohU32();               // vendor id
+        uint32_t count = i.ReadNtohU32();
+        uint32_t size = length;
+        for (;;) {
+            if ((count & ~kMoreBindings) > (size - of10::kHeaderSize - 8) / kArpBindingSize) {
+                ctrl.type = Error;
+                i.Next(size - of10::kHeaderSize - 8);
+                return consumed;
+            }
+            for (uint32_t b = 0; b < (count & ~kMoreBindings); b++) {
+                Ipv4Address ip(i.ReadNtohU32());
+                ctrl.arpEntries.push_back(std::make_pair(ip, ReadMac(i)));
+                i.Next(2);
+            }
+            if (!(count & kMoreBindings)) break;
+            i.Next(2);                 // version, type
+            size = i.ReadNtohU16();
+            i.ReadNtohU32();           // xid, shared by the whole update
+            if (size < of10::kHeaderSize + 8) {
+                ctrl.type = Error;
+                return consumed + std::max<uint32_t>(size, of10::kHeaderSize);
+            }
+            consumed += size;
+            i.ReadNtohU32();           // vendor id
+            count = i.ReadNtohU32();
+        }
+        break;
+    }
+    case of10::Hello:
+        ctrl.type = Hello;
+        break;
+    case of10::BarrierRequest:
+        ctrl.type = BarrierRequest;
+        m_direction = ToSwitch;
+        break;
+    case of10::BarrierReply:
+        ctrl.type = BarrierReply;
+        break;
+    default:
+        ctrl.type = Error;
+        i.Next(length - of10::kHeaderSize);   // At least kHeaderSize, checked above
+        break;
+    }
+    return consumed;
+}
+
+void SDNControlHeader::DeserializePacketIn(Buffer::Iterator& i, uint16_t length)
+{
+    controlPacket& ctrl = *m_target;
+    ctrl.bufferId = i.ReadNtohU32();
+    uint16_t frameSize = i.ReadNtohU16();
+    m_portNumber = i.ReadNtohU16();
+    m_port = GetDevice(m_portNumber);
+    uint8_t reason = i.ReadU8();
+    i.Next(1);
+
+    // Frames from elsewhere may run longer than the parts read here; length covers at least
+    // the Ethernet header (MinMessageSize)
+    uint32_t frame = std::min<uint32_t>(frameSize, length - of10::kPacketInSize);
+    uint32_t read = kEthernetSize;
+    if (frame < kEthernetSize) {
+        ctrl.type = Error;
+        i.Next(length - of10::kPacketInSize);
+        return;
+    }
+    ctrl.dstMac = ReadMac(i);
+    ctrl.srcMac = ReadMac(i);
+    uint16_t etherType = i.ReadNtohU16();
+    if (frame < (etherType == kEtherTypeArp ? kArpFrameSize : kIpFrameSize)) {
+        ctrl.type = Error;
+        i.Next(length - of10::kPacketInSize - read);
+        return;
+    }
+    if (etherType == kEtherTypeArp) {
+        Address sha, tha;
+        ctrl.type = ARPPacket;
+        ctrl.arpReply = ReadArp(i, sha, ctrl.srcIp, tha, ctrl.dstIp) == kArpReply;
+        ctrl.srcMac = sha;
+        ctrl.dstMac = ctrl.arpReply ? tha : Address();
+        read = kArpFrameSize;
+    } else {
+        ctrl.type = reason == of10::kReasonAction ? IPPacket : FlowAdd;
+        i.Next(9);
+        ctrl.protocolNumber = i.ReadU8();
+        i.Next(2);
+        ctrl.srcIp = Ipv4Address(i.ReadNtohU32());
+        ctrl.dstIp = Ipv4Address(i.ReadNtohU32());
+        ctrl.srcPort = i.ReadNtohU16();
+        ctrl.dstPort = i.ReadNtohU16();
+        read = kIpFrameSize;
+    }
+    if (frame > read) {
+        i.Next(frame - read);
+    }
+}
+
+void SDNControlHeader::DeserializePacketOut(Buffer::Iterator& i, uint16_t length)
+{
+    controlPacket& ctrl = *m_target;
+    i.Next(4 + 2);                     // buffer_id, in_port
+    uint16_t actionsSize = i.ReadNtohU16();
+    if (actionsSize > length - of10::kPacketOutSize - kArpFrameSize) {
+        ctrl.type = Error;
+        i.Next(length - of10::kPacketOutSize);
+        return;
+    }
+    uint16_t outPort = of10::kPortNone;
+    for (uint16_t done = 0; done + of10::kActionOutputSize <= actionsSize; done += of10::kActionOutputSize) {
+        uint16_t type = i.ReadNtohU16();
+        i.Next(2);
+        uint16_t port = i.ReadNtohU16();
+        i.Next(2);
+        if (type == of10::kActionOutput) outPort = port;
+    }
+
+    i.Next(kEthernetSize);
+    Address sha, tha;
+    Ipv4Address spa, tpa;
+    if (ReadArp(i, sha, spa, tha, tpa) == kArpReply) {
+        ctrl.type = ARPPacket;
+        ctrl.dstMac = sha;
+        ctrl.dstIp = spa;
+        ctrl.srcMac = tha;
+        ctrl.srcIp = tpa;
+    } else {
+        ctrl.type = PacketOut;
+        ctrl.srcMac = sha;
+        ctrl.srcIp = spa;
+        ctrl.dstIp = tpa;
+        ctrl.flowEntry.outputDevice = GetDevice(outPort);
+    }
+}
+
+uint16_t SDNControlHeader::DeserializeFlowMod(Buffer::Iterator& i, uint16_t length, FlowEntry& entry,
+                                              uint32_t& bufferId, uint16_t& command)
+{
+    entry = FlowEntry();
+    uint32_t wildcards = ReadMatch(i, entry);
+    uint64_t cookie = i.ReadNtohU64();
+    entry.srcPortMax = (cookie >> 16) & 0xffff;
+    entry.dstPortMax = cookie & 0xffff;
+    if (wildcards & of10::kWildcardTpSrc) {
+        entry.srcPort = 0;
+        entry.srcPortMax = 65535;
+    }
+    if (wildcards & of10::kWildcardTpDst) {
+        entry.dstPort = 0;
+        entry.dstPortMax = 65535;
+    }
+    command = i.ReadNtohU16();
+    entry.idleTimeout = i.ReadNtohU16();
+    entry.hardTimeout = i.ReadNtohU16();
+    entry.priority = i.ReadNtohU16();
+    bufferId = i.ReadNtohU32();
+    i.Next(2);                         // out_port
+    uint16_t flags = i.ReadNtohU16();
+
+    for (uint32_t done = of10::kFlowModSize; done + of10::kActionOutputSize <= length; done += of10::kActionOutputSize) {
+        uint16_t type = i.ReadNtohU16();
+        i.Next(2);
+        uint16_t port = i.ReadNtohU16();
+        i.Next(2);
+        if (type == of10::kActionOutput) entry.outputDevice = GetDevice(port);
+    }
+    return flags;
+}
+
+void SDNControlHeader::Print(std::ostream& os) const
+{
+    const controlPacket& ctrl = *m_ctrl;
+    os << "OFPT " << static_cast<uint32_t>(GetMessageType()) << " (type " << ctrl.type << ") xid=" << ctrl.xid
+       << " src=" << ctrl.srcIp << ":" << ctrl.srcPort << " dst=" << ctrl.dstIp << ":" << ctrl.dstPort;
+    if (!ctrl.flowMods.empty()) os << " flowMods=" << ctrl.flowMods.size();
+    if (!ctrl.arpEntries.empty()) os << " arpEntries=" << ctrl.arpEntries.size();
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,94 @@
+#ifndef SDN_CONTROL_HEADER_H
+#define SDN_CONTROL_HEADER_H
+
+#include "ns3/header.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "sdn-flow-table.h"
+#include "control-packet.h"
+
+namespace ns3 {
+namespace sdn {
+
+// Wire form of a controlPacket: one OpenFlow 1.0 message, in network byte order, with the
+// standard ofp_header (version 1, type, length, xid) and body layout.
+//
+//   PacketIn (FlowAdd, IPPacket and ARPPacket towards the controller)
+//                       ofp_packet_in; the data is the Ethernet frame rebuilt from the
+//                       message (Ethernet + IPv4 + ports, or Ethernet + ARP)
+//   FlowAdd/Modify/Delete towards the switch
+//                       ofp_flow_mod with one output action; a bulk FlowAdd is one
+//                       ofp_flow_mod per rule, back to back
+//   ARPPacket towards the switch, PacketOut
+//                       ofp_packet_out carrying the ARP reply or request frame
+//   FlowRemoved         ofp_flow_removed
+//   LinkStateUpdate     ofp_port_status (modify); SwitchJoin/Leave are add/delete of OFPP_LOCAL
+//   StatsRequest/Reply  ofp_stats_request/reply of type OFPST_AGGREGATE
+//   Barrier*, Hello     their own message types; Error is OFPET_BAD_REQUEST
+//   ArpCacheUpdate      a vendor message (no OpenFlow 1.0 equivalent), several back to back
+//                       when the bindings do not fit one message's 16-bit length
+//
+// Two things OpenFlow 1.0 cannot say ride in fields it leaves to the controller: port range
+// maxima go in the flow_mod cookie, and a "more rules follow" bit (0x8000) in the flags of
+// every flow_mod of a bulk FlowAdd but the last.
+//
+// Ports are switch port numbers (the device's interface index plus one), resolved against the
+// switch node given to the header. The header works on the caller's controlPacket instead of
+// a copy, and decoding into a reused controlPacket keeps the capacity of its lists, so neither
+// direction allocates.
+class SDNControlHeader : public Header
+{
+public:
+    enum Direction {
+        ToController,
+        ToSwitch
+    };
+
+    static TypeId GetTypeId();
+    // Decodes into a controlPacket of its own; ports stay unresolved
+    SDNControlHeader();
+    // Encodes ctrl, which must outlive the header
+    SDNControlHeader(const controlPacket& ctrl, Direction direction, Ptr<Node> switchNode);
+    // Decodes into target
+    SDNControlHeader(controlPacket& target, Ptr<Node> switchNode);
+    SDNControlHeader(const SDNControlHeader& other);
+    SDNControlHeader& operator=(const SDNControlHeader& other);
+
+    const controlPacket& GetControlPacket() const;
+    Direction GetDirection() const;
+    // Switch port the message refers to (PacketIn ingress, changed link); may be null
+    void SetPort(Ptr<NetDevice> port);
+    Ptr<NetDevice> GetPort() const;
+
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+private:
+    uint16_t GetPortNumber(Ptr<NetDevice> device) const;
+    Ptr<NetDevice> GetDevice(uint16_t port) const;
+    uint8_t GetMessageType() const;
+    void SerializePacketIn(Buffer::Iterator& i) const;
+    void SerializePacketOut(Buffer::Iterator& i) const;
+    void SerializeFlowMod(Buffer::Iterator& i, const FlowEntry& entry, uint32_t bufferId, uint16_t flags) const;
+    void DeserializePacketIn(Buffer::Iterator& i, uint16_t length);
+    void DeserializePacketOut(Buffer::Iterator& i, uint16_t length);
+    // Reads one flow_mod after its ofp_header; returns its flags
+    uint16_t DeserializeFlowMod(Buffer::Iterator& i, uint16_t length, FlowEntry& entry, uint32_t& bufferId,
+                                uint16_t& command);
+
+    controlPacket m_own;
+    const controlPacket* m_ctrl;   // Message encoded or decoded; m_own unless given one
+    controlPacket* m_target;       // Decoding target; null for a header that only encodes
+    Direction m_direction;
+    Ptr<Node> m_switchNode;
+    Ptr<NetDevice> m_port;
+    uint16_t m_portNumber;         // As decoded, for a header without a switch node
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_CONTROL_HEADER_H
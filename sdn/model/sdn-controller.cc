@@ -1,6 +1,9 @@
 #include "sdn-controller.h"
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
 extern "C" {
     #include "openflow/openflow.h"
 }
@@ -10,16 +13,145 @@ namespace sdn{
 
 NS_LOG_COMPONENT_DEFINE("SDNController");
 
+// Exact per-flow rules installed on PacketIn override proactive destination rules
+static const uint16_t kProactivePriority = 0;
+static const uint16_t kReactivePriority = 1;
+
 TypeId SDNController::GetTypeId()
 {
   static TypeId tid = TypeId("ns3::sdn::SDNController")
     .SetParent<ns3::ofi::Controller>()
     .SetGroupName("SDN")
-    .AddConstructor<SDNController>();
+    .AddConstructor<SDNController>()
+    .AddAttribute("RouteComputationThreads",
+                  "Worker threads used by PopulateRoutingTable for the per-switch shortest-path runs "
+                  "(0 = one per hardware core)",
+                  UintegerValue(1),
+                  MakeUintegerAccessor(&SDNController::m_routeThreads),
+                  MakeUintegerChecker<uint32_t>())
+    .AddAttribute("MultipathMode",
+                  "How new flows are spread over equal-cost next hops",
+                  EnumValue(SDNController::SinglePath),
+                  MakeEnumAccessor<MultipathMode>(&SDNController::m_multipathMode),
+                  MakeEnumChecker(SDNController::SinglePath, "SinglePath",
+                                  SDNController::Ecmp, "Ecmp",
+                                  SDNController::WeightedEcmp, "WeightedEcmp"))
+    .AddAttribute("ProactiveMode",
+                  "Install destination-based rules on every switch once routes are known, "
+                  "leaving the controller to handle only exceptions",
+                  BooleanValue(false),
+                  MakeBooleanAccessor(&SDNController::m_proactiveMode),
+                  MakeBooleanChecker())
+    .AddAttribute("FlowIdleTimeout",
+                  "Idle timeout in seconds given to flows installed on PacketIn (0 = never)",
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&SDNController::m_flowIdleTimeout),
+                  MakeUintegerChecker<uint16_t>())
+    .AddAttribute("FlowHardTimeout",
+                  "Hard timeout in seconds given to flows installed on PacketIn (0 = never)",
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&SDNController::m_flowHardTimeout),
+                  MakeUintegerChecker<uint16_t>())
+    .AddAttribute("InstallPath",
+                  "On a PacketIn, install the flow on every switch along its path rather than only on "
+                  "the switch that missed; over a control channel the switch that missed gets its rule "
+                  "once the others have confirmed theirs with a barrier",
+                  BooleanValue(false),
+                  MakeBooleanAccessor(&SDNController::m_installPath),
+                  MakeBooleanChecker())
+    .AddAttribute("BarrierTimeout",
+                  "Messages waiting for barriers (see InstallPath) are sent anyway if the barriers "
+                  "are not all confirmed after this long, as when the channel loses one",
+                  TimeValue(Seconds(1)),
+                  MakeTimeAccessor(&SDNController::m_barrierTimeout),
+                  MakeTimeChecker())
+    .AddAttribute("BatchWindow",
+                  "Collect PacketIns arriving over a control channel for this long and answer them "
+                  "together, one bulk FlowAdd and barrier per switch (0 = answer each at once)",
+                  TimeValue(Seconds(0)),
+                  MakeTimeAccessor(&SDNController::m_batchWindow),
+                  MakeTimeChecker())
+    .AddAttribute("ArpMissPolicy",
+                  "What to do with an ARP request for an address without a known binding",
+                  EnumValue(SDNController::ArpMissDrop),
+                  MakeEnumAccessor<ArpMissPolicy>(&SDNController::m_arpMissPolicy),
+                  MakeEnumChecker(SDNController::ArpMissDrop, "Drop",
+                                  SDNController::ArpMissFlood, "Flood"))
+    .AddAttribute("ArpCachePush",
+                  "Push every known IP -> MAC binding to the switches' ARP caches, so they answer "
+                  "ARP requests themselves. Every switch gets the whole table and every new binding, "
+                  "so the cost grows with switches x hosts; off, ARP requests are PacketIns",
+                  BooleanValue(false),
+                  MakeBooleanAccessor(&SDNController::m_arpCachePush),
+                  MakeBooleanChecker())
+    .AddAttribute("BatchSize",
+                  "Process a batch as soon as this many PacketIns are queued",
+                  UintegerValue(256),
+                  MakeUintegerAccessor(&SDNController::m_batchSize),
+                  MakeUintegerChecker<uint32_t>(1))
+    .AddAttribute("NPacketIns",
+                  "Flow PacketIns received from switches",
+                  TypeId::ATTR_GET,
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&SDNController::GetNPacketIns),
+                  MakeUintegerChecker<uint64_t>())
+    .AddAttribute("NFlowMods",
+                  "Flow rules sent to or installed on switches",
+                  TypeId::ATTR_GET,
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&SDNController::GetNFlowMods),
+                  MakeUintegerChecker<uint64_t>())
+    .AddAttribute("NArpRequests",
+                  "ARP requests received from switches",
+                  TypeId::ATTR_GET,
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&SDNController::GetNArpRequests),
+                  MakeUintegerChecker<uint64_t>())
+    .AddAttribute("NArpMisses",
+                  "ARP requests for an address without a known binding",
+                  TypeId::ATTR_GET,
+                  UintegerValue(0),
+                  MakeUintegerAccessor(&SDNController::GetNArpMisses),
+                  MakeUintegerChecker<uint64_t>())
+    .AddTraceSource("PacketIn",
+                    "A PacketIn (flow miss, ARP request or reply) arrived from a switch",
+                    MakeTraceSourceAccessor(&SDNController::m_packetInTrace),
+                    "ns3::sdn::SDNController::PacketInTracedCallback")
+    .AddTraceSource("ControlMessage",
+                    "Any message from a switch, as HandlePacketIn received it, with the port it refers to",
+                    MakeTraceSourceAccessor(&SDNController::m_controlMessageTrace),
+                    "ns3::sdn::SDNController::ControlMessageTracedCallback")
+    .AddTraceSource("Decision",
+                    "A message the controller sent to a switch, or a rule it installed on one directly "
+                    "(as a FlowAdd with xid 0); rules rewritten in place on a topology change are not reported",
+                    MakeTraceSourceAccessor(&SDNController::m_decisionTrace),
+                    "ns3::sdn::SDNController::DecisionTracedCallback");
   return tid;
 }
 
 SDNController::SDNController()
+    : m_arpMissPolicy(ArpMissDrop),
+      m_arpCachePush(false),
+      m_arpPushPending(false),
+      m_nSwitches(0),
+      m_routeThreads(1),
+      m_multipathMode(SinglePath),
+      m_proactiveMode(false),
+      m_proactivePending(false),
+      m_flowIdleTimeout(0),
+      m_flowHardTimeout(0),
+      m_installPath(false),
+      m_barrierTimeout(Seconds(1)),
+      m_batchSize(256),
+      m_nextXid(0),
+      m_detached(false),
+      m_switchAtStale(true),
+      m_packetIns(0),
+      m_flowMods(0),
+      m_arpRequests(0),
+      m_arpMisses(0),
+      m_flowsRerouted(0),
+      m_swallowed(0)
 {
     NS_LOG_INFO("Custom SDNController created");
 }
@@ -29,114 +161,86 @@ SDNController::~SDNController()
     NS_LOG_INFO("Custom SDNController destroyed");
 }
 
-// Shortest path computation using Dijkstra's algorithm
-std::map<uint32_t, uint32_t> ComputeShortestPath(const std::map<graphNode, std::vector<Link>>& graph, uint32_t sourceNode) 
-{    
-    // Priority queue for Dijkstra's algorithm
-    std::priority_queue<std::pair<int, uint32_t>,
-                        std::vector<std::pair<int, uint32_t>>,
-                        std::greater<std::pair<int, uint32_t>>> pq;
-    
-    // Distance and previous node maps
-    std::map<uint32_t, uint32_t> distance;
-    std::map<uint32_t, uint32_t> previous;
-    
-    // Initialize distances to infinity
-    for (const auto& node : graph) {
-        distance[node.first.id] = std::numeric_limits<uint32_t>::max();
-        previous[node.first.id] = 0;  // 0 means no previous node
-    }
-    
-    // Source node has distance 0
-    distance[sourceNode] = 0;
-    pq.push(std::make_pair(0, sourceNode));
-    
-    // Dijkstra's algorithm
-    while (!pq.empty()) {
-        uint32_t currentNode = pq.top().second;
-        int currentDistance = pq.top().first;
-        pq.pop();
-        
-        // Skip if we found a shorter path already
-        if (currentDistance > distance[currentNode]) continue;
-        
-        // Find currentNode inside graph
-        for (const auto& node : graph) {
-            if (node.first.id == currentNode) {
-                for (const auto& link : node.second) {
-                    uint32_t neighbor = link.neighborId;
-                    uint32_t weight = link.weight;
-                    uint32_t distanceToNeighbor = currentDistance + weight;
-                    
-                    // If we found a shorter path to neighbor
-                    if (distanceToNeighbor < distance[neighbor]) {
-                        distance[neighbor] = distanceToNeighbor;
-                        previous[neighbor] = currentNode;
-                        pq.push(std::make_pair(distanceToNeighbor, neighbor));
-                    }
-                }
-                break; // Exit once we find the matching node
-            }
-        }
+uint32_t SDNController::AddNodeIndex(uint32_t nodeId)
+{
+    auto it = m_nodeIndex.find(nodeId);
+    if (it != m_nodeIndex.end()) {
+        return it->second;
     }
-    
-    return previous;
+    uint32_t index = m_nodeIds.size();
+    m_nodeIds.push_back(nodeId);
+    m_nodeIndex[nodeId] = index;
+    return index;
 }
 
-
 // Method definition for populating the routing table
 void SDNController::PopulateRoutingTable(const NodeContainer& nodes, const NodeContainer& switches, const NetDeviceContainer& devices) 
 {
-    // Step 1: Populate nodes and switches into the graph
+    m_nodeIds.clear();
+    m_nodeIndex.clear();
+    m_deviceIndex.clear();
+    m_ipIndex.clear();
+    m_prefixes.Clear();
+
+    // Step 1: Index switches, then end nodes
     for (uint32_t i = 0; i < switches.GetN(); i++) {
         Ptr<Node> swNode = switches.Get(i);
+        uint32_t index = AddNodeIndex(swNode->GetId());
         for (uint32_t d = 0; d < swNode->GetNDevices(); d++) {
-            Ptr<NetDevice> dev = swNode->GetDevice(d);
-
-            graphNode switchGraphNode;
-            switchGraphNode.id = swNode->GetId();
-            switchGraphNode.device = dev;
-            switchGraphNode.macAddr = dev->GetAddress();
-            switchGraphNode.ipAddr = Ipv4Address("0.0.0.0");  // No IP
-
-            networkTopologyGraph[switchGraphNode] = std::vector<Link>();
+            m_deviceIndex[PeekPointer(swNode->GetDevice(d))] = index;
         }
     }
+    m_nSwitches = m_nodeIds.size();
 
+    std::map<std::pair<uint32_t, uint8_t>, uint32_t> subnets;   // subnet -> owner, kNoMatch if shared
     for (uint32_t i = 0; i < nodes.GetN(); i++) {
         Ptr<Node> n = nodes.Get(i);
+        uint32_t index = AddNodeIndex(n->GetId());
         for (uint32_t d = 0; d < n->GetNDevices(); d++) {
             Ptr<NetDevice> dev = n->GetDevice(d);
-
-            graphNode nodeGraphNode;
-            nodeGraphNode.id = n->GetId();
-            nodeGraphNode.device = dev;
-            nodeGraphNode.macAddr = dev->GetAddress();
+            m_deviceIndex[PeekPointer(dev)] = index;
+            if (dev->GetChannel() == nullptr) continue;   // Loopback: not reachable through the network
 
             Ptr<Ipv4> ipv4 = n->GetObject<Ipv4>();
             int iface = ipv4->GetInterfaceForDevice(dev);
-            nodeGraphNode.ipAddr = ipv4->GetAddress(iface, 0).GetLocal();
+            Ipv4InterfaceAddress ifAddr = ipv4->GetAddress(iface, 0);
+            Ipv4Address ipAddr = ifAddr.GetLocal();
 
-            networkTopologyGraph[nodeGraphNode] = std::vector<Link>();
-            arpTable[nodeGraphNode.ipAddr] = nodeGraphNode.macAddr;
+            arpTable[ipAddr] = dev->GetAddress();
+            m_ipIndex[ipAddr] = index;
+            m_prefixes.Insert(ipAddr.Get(), 32, index);
+
+            auto subnet = std::make_pair(ipAddr.CombineMask(ifAddr.GetMask()).Get(),
+                                         static_cast<uint8_t>(ifAddr.GetMask().GetPrefixLength()));
+            auto owner = subnets.emplace(subnet, index).first;
+            if (owner->second != index) owner->second = LpmTable::kNoMatch;
+        }
+    }
+
+    // A subnet shared by several nodes (a LAN) is reached through its host routes only
+    for (const auto& subnet : subnets) {
+        if (subnet.second != LpmTable::kNoMatch && subnet.first.second < 32) {
+            m_prefixes.Insert(subnet.first.first, subnet.first.second, subnet.second);
+        }
+    }
+    for (const auto& route : m_staticRoutes) {
+        auto index = m_nodeIndex.find(route.nodeId);
+        if (index != m_nodeIndex.end()) {
+            m_prefixes.Insert(route.prefix.Get(), route.length, index->second);
         }
     }
 
     // Step 2: Add edges (links) with NetDevice (outgoing port) info
+    std::vector<std::vector<Link>> adjacency(m_nodeIds.size());
     for (uint32_t i = 0; i < devices.GetN(); i++) {
         Ptr<NetDevice> dev = devices.Get(i);
-        Ptr<Node> node = dev->GetNode();
         Ptr<Channel> channel = dev->GetChannel();
 
         if (channel == nullptr) continue;
 
-        graphNode currentNode;
-        currentNode.id = node->GetId();
-        currentNode.device = dev;
-        currentNode.macAddr = dev->GetAddress();
-
         // Check if this node is already present (should be)
-        if (networkTopologyGraph.find(currentNode) == networkTopologyGraph.end()) {
+        auto current = m_deviceIndex.find(PeekPointer(dev));
+        if (current == m_deviceIndex.end()) {
             continue;  // Skip if not in graph
         }
 
@@ -144,89 +248,151 @@ void SDNController::PopulateRoutingTable(const NodeContainer& nodes, const NodeC
             Ptr<NetDevice> otherDev = channel->GetDevice(j);
             if (otherDev == dev) continue;
 
-            Ptr<Node> otherNode = otherDev->GetNode();
-
-            graphNode neighborNode;
-            neighborNode.id = otherNode->GetId();
-            neighborNode.device = otherDev;
-            neighborNode.macAddr = otherDev->GetAddress();
+            auto neighbor = m_nodeIndex.find(otherDev->GetNode()->GetId());
+            if (neighbor == m_nodeIndex.end()) continue;
 
             // Add the outgoing port used to reach the neighbor
-            networkTopologyGraph[currentNode].push_back({neighborNode.id, dev, 1});
+            adjacency[current->second].push_back({neighbor->second, dev, 1});
         }
     }
+    m_topology.Build(adjacency, m_nSwitches);
 
-    // Step 3: Compute shortest paths and fill routing table
-    for (const auto& source : networkTopologyGraph) {
-        uint32_t sourceId = source.first.id;
+    // Step 3: One shortest-path run per switch fills that switch's row of the routing table
+    uint32_t n = m_nodeIds.size();
+    ComputeRoutingTable(m_topology, m_nSwitches, m_routeThreads, m_routingTable, m_distances);
+    m_switchAtStale = true;
+    NS_LOG_INFO("SDNController: Routes computed for " << m_nSwitches << " switches, "
+                << n << " nodes, " << m_topology.GetNEdges() << " links");
 
-        std::map<uint32_t, uint32_t> previous = ComputeShortestPath(networkTopologyGraph, sourceId);
+    if (m_proactiveMode && !m_switches.empty() && !m_proactivePending) {
+        InstallProactiveFlows();
+    }
+    if (m_arpCachePush && !m_switches.empty() && !m_arpPushPending) {
+        PushArpCaches();
+    }
+}
 
-        for (const auto& dest : networkTopologyGraph) {
-            uint32_t destId = dest.first.id;
 
-            if (sourceId == destId) continue;
+bool SDNController::ResolveRoute(Ptr<NetDevice> currDevice, Ipv4Address dstIp, uint32_t& src, uint32_t& dst) const
+{
+    // Find node indexes corresponding to the ingress device and dstIp
+    auto srcIt = m_deviceIndex.find(PeekPointer(currDevice));
+    uint32_t dstIndex = m_prefixes.Lookup(dstIp.Get());
 
-            uint32_t nextHop = destId;
-            uint32_t current = destId;
+    if (srcIt == m_deviceIndex.end() || dstIndex == LpmTable::kNoMatch || srcIt->second >= m_nSwitches) {
+        NS_LOG_WARN("SDNController: Could not find node IDs for given IPs!");
+        return false; // Cannot find nodes
+    }
+    src = srcIt->second;
+    dst = dstIndex;
+    return true;
+}
 
-            while (previous[current] != sourceId && previous[current] != 0) {
-                nextHop = current;
-                current = previous[current];
-            }
+// An out-link of src is an equal-cost next hop if it starts a shortest path to dst
+bool SDNController::IsEqualCostHop(uint32_t src, uint32_t dst, uint32_t edge) const
+{
+    if (!m_topology.IsEdgeUsable(edge)) return false;
 
-            if (previous[current] == sourceId) {
-                nextHop = current;
-            }
+    size_t n = m_nodeIds.size();
+    uint32_t total = m_distances[src * n + dst];
+    uint32_t v = m_topology.GetTarget(edge);
+    uint32_t w = m_topology.GetWeight(edge);
+    if (v == dst) return w == total;
+    if (v >= m_nSwitches) return false;   // Hosts do not forward
 
-            // Find outgoing NetDevice (port) from source to nextHop
-            Ptr<NetDevice> outDev = nullptr;
-            for (const auto& link : source.second) {
-                if (link.neighborId == nextHop) {
-                    outDev = link.outgoingPort;
-                    break;
-                }
-            }
+    uint32_t rest = m_distances[v * n + dst];
+    return rest != kNoRoute && static_cast<uint64_t>(w) + rest == total;
+}
 
-            if (outDev) {
-                m_routingTable[std::make_pair(sourceId, destId)] = outDev;
-            } else {
-                NS_LOG_WARN("No outgoing device found from " << sourceId << " to " << nextHop);
-            }
+uint32_t SDNController::SelectRoute(uint32_t src, uint32_t dst, const FlowKey& key) const
+{
+    uint32_t best = m_routingTable[static_cast<size_t>(src) * m_nodeIds.size() + dst];
+    if (m_multipathMode == SinglePath || best == kNoRoute) return best;
+
+    // Equal-cost next hops follow from the distance matrix built during route computation
+    uint64_t total = 0;
+    for (uint32_t e = m_topology.EdgeBegin(src); e < m_topology.EdgeEnd(src); e++) {
+        if (!IsEqualCostHop(src, dst, e)) continue;
+        uint32_t share = 1;
+        if (m_multipathMode == WeightedEcmp) {
+            auto it = m_portWeights.find(PeekPointer(m_topology.GetPort(e)));
+            share = (it != m_portWeights.end()) ? it->second : 1;
         }
+        total += share;
     }
-}
+    if (total == 0) return best;
 
+    // Salt the flow hash per switch so consecutive hops do not all make the same choice
+    uint64_t h = FlowKeyHash()(key) ^ (static_cast<uint64_t>(src + 1) * 0x9e3779b97f4a7c15ULL);
+    h ^= h >> 31;
+    uint64_t pick = h % total;
+    for (uint32_t e = m_topology.EdgeBegin(src); e < m_topology.EdgeEnd(src); e++) {
+        if (!IsEqualCostHop(src, dst, e)) continue;
+        uint32_t share = 1;
+        if (m_multipathMode == WeightedEcmp) {
+            auto it = m_portWeights.find(PeekPointer(m_topology.GetPort(e)));
+            share = (it != m_portWeights.end()) ? it->second : 1;
+        }
+        if (pick < share) return e;
+        pick -= share;
+    }
+    return best;
+}
 
-// Method to look up next hop for a given source and destination
 // Method to look up next hop for a given source and destination (with logging)
 Ptr<NetDevice> SDNController::GetNextHop(Ptr<NetDevice> currDevice, Ipv4Address dstIp)
 {
-    int srcNodeId = -1;
-    int dstNodeId = -1;
+    uint32_t src, dst;
+    if (!ResolveRoute(currDevice, dstIp, src, dst)) {
+        return nullptr;
+    }
 
-    // Find node IDs corresponding to srcIp and dstIp
-    for (const auto& entry : networkTopologyGraph) {
-        if (entry.first.device == currDevice) {
-            srcNodeId = entry.first.id;
-        }
-        if (entry.first.ipAddr == dstIp) {
-            dstNodeId = entry.first.id;
-        }
+    uint32_t edge = m_routingTable[static_cast<size_t>(src) * m_nodeIds.size() + dst];
+    if (edge == kNoRoute) {
+        NS_LOG_WARN("SDNController: No route from node " << m_nodeIds[src] << " to node " << m_nodeIds[dst]);
+        return nullptr; // No route found
     }
+    return m_topology.GetPort(edge);
+}
 
-    if (srcNodeId == -1 || dstNodeId == -1) {
-        NS_LOG_WARN("SDNController: Could not find node IDs for given IPs!");
-        return nullptr; // Cannot find nodes
+// Flow-aware variant: spreads flows over equal-cost next hops according to MultipathMode
+Ptr<NetDevice> SDNController::GetNextHop(Ptr<NetDevice> currDevice, const controlPacket& ctrl)
+{
+    uint32_t src, dst;
+    if (!ResolveRoute(currDevice, ctrl.dstIp, src, dst)) {
+        return nullptr;
     }
 
-    auto key = std::make_pair(srcNodeId, dstNodeId);
-    if (m_routingTable.find(key) != m_routingTable.end()) {
-        return m_routingTable[key];
-    } else {
-        NS_LOG_WARN("SDNController: No route from node " << srcNodeId << " to node " << dstNodeId);
+    FlowKey key;
+    key.srcIp = ctrl.srcIp.Get();
+    key.dstIp = ctrl.dstIp.Get();
+    key.srcPort = ctrl.srcPort;
+    key.dstPort = ctrl.dstPort;
+    key.protocol = ctrl.protocolNumber;
+
+    uint32_t edge = SelectRoute(src, dst, key);
+    if (edge == kNoRoute) {
+        NS_LOG_WARN("SDNController: No route from node " << m_nodeIds[src] << " to node " << m_nodeIds[dst]);
         return nullptr; // No route found
     }
+    return m_topology.GetPort(edge);
+}
+
+void SDNController::SetPortWeight(Ptr<NetDevice> port, uint32_t weight)
+{
+    m_portWeights[PeekPointer(port)] = weight;
+}
+
+void SDNController::AddRoute(Ipv4Address prefix, Ipv4Mask mask, Ptr<Node> node)
+{
+    StaticRoute route{prefix.CombineMask(mask), static_cast<uint8_t>(mask.GetPrefixLength()), node->GetId()};
+    m_staticRoutes.push_back(route);
+
+    // Already populated: takes effect at once
+    auto index = m_nodeIndex.find(route.nodeId);
+    if (index != m_nodeIndex.end()) {
+        m_prefixes.Insert(route.prefix.Get(), route.length, index->second);
+    }
 }
 
 
@@ -238,18 +404,17 @@ void SDNController::DisplayDetailedRoutingTable() const {
         std::cout << "Full Routing Table (Source → Destination → Next Hop):\n";
         std::cout << "--------------------------------------------------------\n";
         
-        // Group by source for better readability
-        std::map<uint32_t, std::vector<std::pair<uint32_t, Ptr<NetDevice>>>> sourceGroups;
-        for (const auto& entry : m_routingTable) {
-            sourceGroups[entry.first.first].push_back({entry.first.second, entry.second});
-        }
-        
-        for (const auto& group : sourceGroups) {
-            std::cout << "From Node " << group.first << ":\n";
-            for (const auto& route : group.second) {
-                Ptr<Node> node = route.second->GetNode();
-                int nextHop = node->GetId();
-                std::cout << "  → To Node " << route.first 
+        // Group by source (in node id order) for better readability
+        std::map<uint32_t, uint32_t> nodesById(m_nodeIndex.begin(), m_nodeIndex.end());
+        uint32_t n = m_nodeIds.size();
+        for (const auto& source : nodesById) {
+            if (source.second >= m_nSwitches) continue;   // Only switches hold routes
+            std::cout << "From Node " << source.first << ":\n";
+            for (const auto& dest : nodesById) {
+                uint32_t edge = m_routingTable[static_cast<size_t>(source.second) * n + dest.second];
+                if (edge == kNoRoute) continue;
+                int nextHop = m_nodeIds[m_topology.GetTarget(edge)];
+                std::cout << "  → To Node " << dest.first 
                           << ": Next hop is Node " << nextHop << "\n";
             }
             std::cout << "\n";
@@ -273,40 +438,756 @@ void SDNController::AddSwitch(Ptr<SDNSwitch> swtch)
 {
     m_switches.push_back(swtch);
     swtch->m_controller = this;
+    m_switchAtStale = true;
+
+    // Switch ports are usually attached after AddSwitch; push the rules once setup is done
+    if (m_proactiveMode && !m_proactivePending) {
+        m_proactivePending = true;
+        Simulator::ScheduleNow(&SDNController::InstallProactiveFlows, this);
+    }
+    if (m_arpCachePush && !m_arpPushPending) {
+        m_arpPushPending = true;
+        Simulator::ScheduleNow(&SDNController::PushArpCaches, this);
+    }
+}
+
+void SDNController::SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl)
+{
+    m_decisionTrace(swtch, ctrl);
+    if (SwallowDecision()) return;
+    if (swtch->GetControlChannel()) {
+        swtch->GetControlChannel()->SendToSwitch(swtch, ctrl);
+    } else {
+        swtch->HandleControlMessage(ctrl);
+    }
+}
+
+// Only builds the message when something listens
+void SDNController::TraceDirectInstall(Ptr<SDNSwitch> swtch, const FlowEntry& entry)
+{
+    if (m_decisionTrace.IsEmpty()) return;
+    controlPacket flowAdd;
+    flowAdd.type = FlowAdd;
+    flowAdd.xid = 0;
+    flowAdd.bufferId = kNoBuffer;
+    flowAdd.flowEntry = entry;
+    m_decisionTrace(swtch, flowAdd);
+}
+
+FlowId SDNController::InstallDirect(Ptr<SDNSwitch> swtch, const FlowEntry& entry)
+{
+    TraceDirectInstall(swtch, entry);
+    if (SwallowDecision()) return kNoFlow;
+    return swtch->InstallFlowEntry(entry);
+}
+
+// Counts a decision that must not leave the controller
+bool SDNController::SwallowDecision()
+{
+    if (!m_detached) return false;
+    m_swallowed++;
+    return true;
+}
+
+// One ArpCacheUpdate per switch carrying the whole table, so ARP at simulation start is
+// answered at the edge instead of every request becoming a PacketIn
+void SDNController::PushArpCaches()
+{
+    m_arpPushPending = false;
+    controlPacket ctrl;
+    ctrl.type = ArpCacheUpdate;
+    ctrl.arpEntries.assign(arpTable.begin(), arpTable.end());
+    for (const auto& swtch : m_switches) {
+        SendToSwitch(swtch, ctrl);
+    }
+    NS_LOG_INFO("SDNController: Pushed " << ctrl.arpEntries.size() << " ARP bindings to "
+                << m_switches.size() << " switches");
+}
+
+void SDNController::LearnArpBinding(Ipv4Address ipAddr, const Address& mac)
+{
+    auto known = arpTable.find(ipAddr);
+    if (known != arpTable.end() && known->second == mac) return;
+    arpTable[ipAddr] = mac;
+    NS_LOG_INFO("SDNController: Learned ARP binding " << ipAddr << " -> " << mac);
+
+    if (m_arpCachePush) {
+        controlPacket ctrl;
+        ctrl.type = ArpCacheUpdate;
+        ctrl.arpEntries.push_back(std::make_pair(ipAddr, mac));
+        for (const auto& swtch : m_switches) {
+            SendToSwitch(swtch, ctrl);
+        }
+    }
+}
+
+// One PacketOut per host-facing switch port, through the switch's control channel like any
+// other message; only towards hosts, so a topology with loops cannot make the request circulate
+void SDNController::FloodArpRequest(const controlPacket& ctrl, Ptr<NetDevice> inPort)
+{
+    uint32_t ports = 0;
+    for (uint32_t s = 0; s < m_nSwitches; s++) {
+        Ptr<SDNSwitch> swtch = GetSwitchAt(s);
+        if (!swtch) continue;
+        for (uint32_t e = m_topology.EdgeBegin(s); e < m_topology.EdgeEnd(s); e++) {
+            Ptr<NetDevice> port = m_topology.GetPort(e);
+            if (m_topology.GetTarget(e) < m_nSwitches || port == inPort) continue;
+
+            controlPacket packetOut = ctrl;
+            packetOut.type = PacketOut;
+            packetOut.xid = m_nextXid++;
+            packetOut.flowEntry.outputDevice = port;
+            SendToSwitch(swtch, packetOut);
+            ports++;
+        }
+    }
+    NS_LOG_INFO("SDNController: ARP request for " << ctrl.dstIp << " flooded to " << ports << " host ports");
+}
+
+void SDNController::InstallProactiveFlows()
+{
+    m_proactivePending = false;
+    uint32_t installed = 0;
+    for (uint32_t s = 0; s < m_nSwitches; s++) {
+        installed += InstallSwitchProactiveFlows(s, nullptr);
+    }
+    NS_LOG_INFO("SDNController: Proactively installed " << installed << " destination rules");
+}
+
+// Rules towards every reachable host, or only the hosts whose flag is set in changedDst
+uint32_t SDNController::InstallSwitchProactiveFlows(uint32_t index, const std::vector<uint8_t>* changedDst)
+{
+    Ptr<SDNSwitch> swtch = GetSwitchAt(index);
+    if (!swtch) return 0;
+
+    uint32_t n = m_nodeIds.size();
+    uint32_t installed = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> hops;   // Next hop edge and its share
+
+    // In-band switches get all their rules in one bulk FlowAdd
+    bool inBand = swtch->GetControlChannel() && swtch->GetControlChannel()->IsInBand();
+    controlPacket bulk;
+    bulk.type = FlowAdd;
+    bulk.bufferId = kNoBuffer;
+
+    for (const auto& host : m_ipIndex) {
+        if (changedDst && !(*changedDst)[host.second]) continue;
+        uint32_t edge = m_routingTable[static_cast<size_t>(index) * n + host.second];
+        if (edge == kNoRoute) continue;
+
+        hops.clear();
+        uint64_t total = 0;
+        if (m_multipathMode != SinglePath) {
+            for (uint32_t e = m_topology.EdgeBegin(index); e < m_topology.EdgeEnd(index); e++) {
+                if (!IsEqualCostHop(index, host.second, e)) continue;
+                uint32_t share = 1;
+                if (m_multipathMode == WeightedEcmp) {
+                    auto it = m_portWeights.find(PeekPointer(m_topology.GetPort(e)));
+                    share = (it != m_portWeights.end()) ? it->second : 1;
+                }
+                if (share == 0) continue;
+                hops.push_back(std::make_pair(e, share));
+                total += share;
+            }
+        }
+        if (hops.empty()) {
+            hops.push_back(std::make_pair(edge, 1));
+            total = 1;
+        }
+
+        // Consecutive source port ranges, sized by share
+        uint64_t before = 0;
+        for (const auto& hop : hops) {
+            uint32_t first = before * 65536 / total;
+            before += hop.second;
+            uint32_t end = before * 65536 / total;
+            if (end == first) continue;
+
+            FlowEntry entry;
+            entry.srcIp = Ipv4Address::GetZero();
+            entry.srcMask = Ipv4Mask::GetZero();
+            entry.dstIp = host.first;
+            entry.srcPort = first;
+            entry.srcPortMax = end - 1;
+            entry.dstPort = 0;
+            entry.dstPortMax = 65535;
+            entry.protocol = 0;
+            entry.anyProtocol = true;
+            entry.priority = kProactivePriority;
+            entry.outputDevice = m_topology.GetPort(hop.first);
+            entry.packetCount = 0;
+            entry.byteCount = 0;
+            if (inBand) {
+                bulk.flowMods.push_back(FlowMod{entry, kNoBuffer});
+            } else {
+                InstallDirect(swtch, entry);
+            }
+            installed++;
+        }
+    }
+    if (inBand && !bulk.flowMods.empty()) {
+        bulk.xid = m_nextXid++;
+        SendToSwitch(swtch, bulk);
+    }
+    m_flowMods += installed;
+    return installed;
+}
+
+bool SDNController::GetSwitchIndex(Ptr<SDNSwitch> swtch, uint32_t& index) const
+{
+    for (const auto& dev : swtch->m_devices) {
+        auto it = m_deviceIndex.find(PeekPointer(dev));
+        if (it != m_deviceIndex.end() && it->second < m_nSwitches) {
+            index = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+Ptr<SDNSwitch> SDNController::GetSwitchAt(uint32_t index)
+{
+    // Switches get their devices after AddSwitch, so the mapping is resolved on first use
+    if (m_switchAtStale) {
+        m_switchAt.assign(m_nSwitches, nullptr);
+        for (const auto& swtch : m_switches) {
+            uint32_t i;
+            if (GetSwitchIndex(swtch, i)) {
+                m_switchAt[i] = swtch;
+            }
+        }
+        m_switchAtStale = false;
+    }
+    return index < m_switchAt.size() ? m_switchAt[index] : nullptr;
+}
+
+void SDNController::SetLinkState(Ptr<NetDevice> port, bool up)
+{
+    auto it = m_deviceIndex.find(PeekPointer(port));
+    if (it == m_deviceIndex.end()) {
+        NS_LOG_WARN("SDNController: Link state update for unknown port");
+        return;
+    }
+    uint32_t u = it->second;
+    Ptr<Channel> channel = port->GetChannel();
+
+    // Both directions of every link behind this port
+    std::vector<uint32_t> edges;
+    for (uint32_t e = m_topology.EdgeBegin(u); e < m_topology.EdgeEnd(u); e++) {
+        if (m_topology.GetPort(e) != port) continue;
+        edges.push_back(e);
+        uint32_t v = m_topology.GetTarget(e);
+        for (uint32_t f = m_topology.EdgeBegin(v); f < m_topology.EdgeEnd(v); f++) {
+            if (m_topology.GetTarget(f) == u && m_topology.GetPort(f)->GetChannel() == channel) {
+                edges.push_back(f);
+            }
+        }
+    }
+
+    NS_LOG_INFO("SDNController: Link at node " << m_nodeIds[u] << " is " << (up ? "up" : "down"));
+    ApplyTopologyChange(edges, [&]() {
+        for (uint32_t e : edges) {
+            m_topology.SetLinkUp(e, up);
+        }
+    });
+}
+
+void SDNController::SetSwitchState(Ptr<SDNSwitch> swtch, bool up)
+{
+    uint32_t x;
+    if (!GetSwitchIndex(swtch, x)) {
+        NS_LOG_WARN("SDNController: Switch state update for unknown switch");
+        return;
+    }
+
+    // Every link into and out of the switch
+    std::vector<uint32_t> edges;
+    for (uint32_t e = m_topology.EdgeBegin(x); e < m_topology.EdgeEnd(x); e++) {
+        edges.push_back(e);
+        uint32_t v = m_topology.GetTarget(e);
+        for (uint32_t f = m_topology.EdgeBegin(v); f < m_topology.EdgeEnd(v); f++) {
+            if (m_topology.GetTarget(f) == x) {
+                edges.push_back(f);
+            }
+        }
+    }
+
+    NS_LOG_INFO("SDNController: Switch node " << m_nodeIds[x] << (up ? " joined" : " left"));
+    ApplyTopologyChange(edges, [&]() { m_topology.SetNodeUp(x, up); });
+}
+
+void SDNController::ApplyTopologyChange(const std::vector<uint32_t>& edges, const std::function<void()>& change)
+{
+    std::vector<uint8_t> before(edges.size());
+    for (size_t i = 0; i < edges.size(); i++) {
+        before[i] = m_topology.IsEdgeUsable(edges[i]);
+    }
+    change();
+
+    // A switch's routes can only change if a lost edge was tight on one of its shortest paths
+    // (dist[u] + w == dist[v]) or a new edge is at least as short as what it had (dist[u] + w <= dist[v])
+    uint32_t n = m_nodeIds.size();
+    std::vector<uint32_t> affected;
+    for (uint32_t s = 0; s < m_nSwitches; s++) {
+        size_t row = static_cast<size_t>(s) * n;
+        for (size_t i = 0; i < edges.size(); i++) {
+            uint32_t e = edges[i];
+            bool usable = m_topology.IsEdgeUsable(e);
+            if (usable == static_cast<bool>(before[i])) continue;
+
+            uint32_t u = m_topology.GetSource(e);
+            if (u != s && u >= m_nSwitches) continue;   // Hosts never carry transit traffic
+            // A switch that was down has an empty row, but its own links still start at distance 0
+            uint32_t du = (u == s) ? 0 : m_distances[row + u];
+            if (du == kNoRoute) continue;
+
+            uint64_t via = static_cast<uint64_t>(du) + m_topology.GetWeight(e);
+            uint32_t dv = m_distances[row + m_topology.GetTarget(e)];
+            if (usable ? via <= dv : via == dv) {
+                affected.push_back(s);
+                break;
+            }
+        }
+    }
+
+    if (affected.empty()) {
+        NS_LOG_INFO("SDNController: Topology change affects no routes");
+        return;
+    }
+
+    std::vector<uint32_t> oldRows(affected.size() * n);
+    for (size_t i = 0; i < affected.size(); i++) {
+        auto row = m_routingTable.begin() + static_cast<size_t>(affected[i]) * n;
+        std::copy(row, row + n, oldRows.begin() + i * n);
+    }
+
+    ComputeRoutingRows(m_topology, affected, m_routeThreads, m_routingTable, m_distances);
+
+    // With multipath the equal-cost set can change while the primary next hop stays the same,
+    // so every flow on an affected switch is re-hashed (unchanged sets give the same choice)
+    bool multipath = m_multipathMode != SinglePath;
+    std::vector<uint8_t> changedDst(n, multipath);
+    for (size_t i = 0; i < affected.size(); i++) {
+        size_t row = static_cast<size_t>(affected[i]) * n;
+        bool any = multipath;
+        for (uint32_t d = 0; d < n && !multipath; d++) {
+            changedDst[d] = m_routingTable[row + d] != oldRows[i * n + d];
+            any = any || changedDst[d];
+        }
+        if (any) {
+            UpdateSwitchFlows(affected[i], changedDst);
+        }
+    }
+    NS_LOG_INFO("SDNController: Recomputed routes for " << affected.size() << " of " << m_nSwitches << " switches");
+}
+
+void SDNController::UpdateSwitchFlows(uint32_t index, const std::vector<uint8_t>& changedDst)
+{
+    Ptr<SDNSwitch> swtch = GetSwitchAt(index);
+    if (!swtch) return;
+
+    // The table of an in-band switch may live on another rank: have the switch drop the rules
+    // towards changed destinations, so their next packets ask for the new route
+    if (swtch->GetControlChannel() && swtch->GetControlChannel()->IsInBand()) {
+        uint32_t deletes = 0;
+        for (const auto& host : m_ipIndex) {
+            if (!changedDst[host.second]) continue;
+            controlPacket flowDelete;
+            flowDelete.type = FlowDelete;
+            flowDelete.xid = m_nextXid++;
+            flowDelete.flowEntry.dstIp = host.first;
+            SendToSwitch(swtch, flowDelete);
+            deletes++;
+        }
+        NS_LOG_INFO("SDNController: Switch node " << m_nodeIds[index] << ": FlowDelete sent for "
+                    << deletes << " destinations");
+        if (m_proactiveMode) {
+            // The deletes took the proactive rules too; a bulk FlowAdd after them restores those
+            uint32_t installed = InstallSwitchProactiveFlows(index, &changedDst);
+            NS_LOG_INFO("SDNController: Switch node " << m_nodeIds[index] << ": " << installed
+                        << " proactive rules reinstalled");
+        }
+        return;
+    }
+    if (!swtch->GetFlowTable()) return;
+
+    uint32_t rerouted = 0;
+    uint32_t removed = swtch->GetFlowTable()->UpdateEntries([&](FlowEntry& entry) {
+        // Aggregate destinations may span changed and unchanged nodes; let the switch ask again
+        if (entry.dstMask != Ipv4Mask::GetOnes()) return false;
+
+        uint32_t dst = m_prefixes.Lookup(entry.dstIp.Get());
+        if (dst == LpmTable::kNoMatch || !changedDst[dst]) return true;
+        // Proactive port-range rules split the hops between them; they are rebuilt below
+        if (m_proactiveMode && entry.priority == kProactivePriority) return false;
+
+        uint32_t edge = SelectRoute(index, dst, SDNFlowTable::MakeFlowKey(entry));
+        if (edge == kNoRoute) return false;
+        if (entry.outputDevice != m_topology.GetPort(edge)) {
+            entry.outputDevice = m_topology.GetPort(edge);
+            rerouted++;
+        }
+        return true;
+    });
+    m_flowsRerouted += rerouted;
+    NS_LOG_INFO("SDNController: Switch node " << m_nodeIds[index] << ": " << rerouted
+                << " flows rerouted, " << removed << " removed");
+    if (m_proactiveMode) {
+        uint32_t installed = InstallSwitchProactiveFlows(index, &changedDst);
+        NS_LOG_INFO("SDNController: Switch node " << m_nodeIds[index] << ": " << installed
+                    << " proactive rules rebuilt");
+    }
 }
 
-Address SDNController::AddressResolution(Ipv4Address ipAddr)
+bool SDNController::AddressResolution(Ipv4Address ipAddr, Address& mac) const
 {
-    return arpTable[ipAddr];
+    auto binding = arpTable.find(ipAddr);
+    if (binding == arpTable.end()) return false;
+    mac = binding->second;
+    return true;
 }
 
 void SDNController::HandlePacketIn (Ptr<SDNSwitch> swtch, controlPacket* ctrl, Ptr<NetDevice> device)
 {
+    m_controlMessageTrace(swtch, *ctrl, device);
+    if (ctrl->type == ARPPacket || ctrl->type == FlowAdd) {
+        m_packetInTrace(swtch, *ctrl);
+    }
+
     if (ctrl->type == ARPPacket)
     {
-        ctrl->dstMac = AddressResolution(ctrl->dstIp);
+        if (ctrl->arpReply) {
+            LearnArpBinding(ctrl->srcIp, ctrl->srcMac);
+            return;
+        }
+        m_arpRequests++;
+        if (!AddressResolution(ctrl->dstIp, ctrl->dstMac)) {
+            m_arpMisses++;
+            // An invalid MAC tells the switch there is no answer
+            ctrl->dstMac = Address();
+            NS_LOG_INFO("SDNController: No ARP binding for " << ctrl->dstIp);
+            if (m_arpMissPolicy == ArpMissFlood) {
+                FloodArpRequest(*ctrl, device);
+            }
+        }
         NS_LOG_INFO("SDNController: Control packet updated for ARP handling");
+        m_decisionTrace(swtch, *ctrl);
+        if (!SwallowDecision() && swtch->GetControlChannel()) {
+            swtch->GetControlChannel()->SendToSwitch(swtch, *ctrl);
+        }
+    }
+    else if (ctrl->type == LinkStateUpdate)
+    {
+        SetLinkState(device, ctrl->linkUp);
+    }
+    else if (ctrl->type == SwitchJoin || ctrl->type == SwitchLeave)
+    {
+        SetSwitchState(swtch, ctrl->type == SwitchJoin);
+    }
+    else if (ctrl->type == FlowRemoved)
+    {
+        const char* reason = ctrl->removedReason == IdleTimeoutExpired ? "idle timeout"
+                           : ctrl->removedReason == HardTimeoutExpired ? "hard timeout" : "evicted";
+        NS_LOG_INFO("SDNController: Flow src=" << ctrl->srcIp << ":" << ctrl->srcPort
+                    << " dst=" << ctrl->dstIp << ":" << ctrl->dstPort << " removed ("
+                    << reason << ") after " << ctrl->packetCount << " packets, " << ctrl->byteCount << " bytes");
+    }
+    else if (ctrl->type == BarrierReply)
+    {
+        NS_LOG_INFO("SDNController: Barrier " << ctrl->xid << " confirmed by switch");
+        ConfirmBarrier(ctrl->xid);
     }
     else if (ctrl->type == FlowAdd)
     {
-        FlowEntry entry;
-        entry.srcIp = ctrl->srcIp;
-        entry.dstIp = ctrl->dstIp;
-        entry.srcPort = ctrl->srcPort;
-        entry.dstPort = ctrl->dstPort;
-        entry.protocol = ctrl->protocolNumber;
-        entry.outputDevice = GetNextHop(device, ctrl->dstIp);  // Change appropriately
-        entry.packetCount = 0;
-        entry.byteCount = 0;
-
-        NS_LOG_INFO(entry.outputDevice->GetAddress());
-        FlowEntry* newFlow = swtch->InstallFlowEntry(entry);
+        m_packetIns++;
+        Ptr<SDNControlChannel> channel = swtch->GetControlChannel();
+        if (channel && m_batchWindow.IsStrictlyPositive()) {
+            m_packetInQueue.push_back(QueuedPacketIn{swtch, *ctrl, device, Simulator::Now()});
+            if (m_packetInQueue.size() >= m_batchSize) {
+                ProcessPacketInBatch();
+            } else if (!m_batchEvent.IsPending()) {
+                m_batchEvent = Simulator::Schedule(m_batchWindow, &SDNController::ProcessPacketInBatch, this);
+            }
+            return;
+        }
+
+        FlowEntry entry = BuildFlowEntry(device, *ctrl);
+        std::vector<Ptr<SDNSwitch>> fenced;
+        if (m_installPath) {
+            PathEntries hops;
+            BuildPathEntries(device, *ctrl, entry, hops);
+            InstallPathEntries(hops, fenced);
+        }
+        if (entry.outputDevice) {
+            m_flowMods++;
+        }
+        // Over a channel the switch installs the entry when the reply arrives; an entry
+        // without an output port tells it to drop the buffered packet
+        ctrl->flowEntry = entry;
+        if (channel) {
+            SendAfterBarriers(fenced, SwitchMessages{std::make_pair(swtch, *ctrl)});
+            NS_LOG_INFO("SDNController: Flow entry sent for src=" << ctrl->srcIp << " dst=" << ctrl->dstIp);
+            return;
+        }
+        // Path switches behind a channel must confirm their entries first. This switch has no
+        // buffer to hold the packet meanwhile, so its entry waits with them and the packet is lost.
+        if (!fenced.empty()) {
+            SendAfterBarriers(fenced, SwitchMessages{std::make_pair(swtch, *ctrl)});
+            NS_LOG_INFO("SDNController: Flow entry held for src=" << ctrl->srcIp << " dst=" << ctrl->dstIp);
+            return;
+        }
+        m_decisionTrace(swtch, *ctrl);
+        if (SwallowDecision()) return;
+
+        FlowId newFlow = entry.outputDevice ? swtch->InstallFlowEntry(entry) : kNoFlow;
         NS_LOG_INFO("SDNController: Flow entry installed for src=" << ctrl->srcIp << " dst=" << ctrl->dstIp);
         ctrl->flow = newFlow;
         NS_LOG_INFO("SDNController: Control packet updated for flow");
     }
 }
 
+FlowEntry SDNController::BuildFlowEntry(Ptr<NetDevice> inPort, const controlPacket& ctrl)
+{
+    FlowEntry entry;
+    entry.srcIp = ctrl.srcIp;
+    entry.dstIp = ctrl.dstIp;
+    entry.srcPort = ctrl.srcPort;
+    entry.dstPort = ctrl.dstPort;
+    entry.protocol = ctrl.protocolNumber;
+    entry.outputDevice = GetNextHop(inPort, ctrl);
+    entry.packetCount = 0;
+    entry.byteCount = 0;
+    entry.priority = kReactivePriority;
+    entry.idleTimeout = m_flowIdleTimeout;
+    entry.hardTimeout = m_flowHardTimeout;
+
+    if (!entry.outputDevice) {
+        NS_LOG_WARN("SDNController: No route from switch to " << ctrl.dstIp);
+    }
+    return entry;
+}
+
+// The switches after the ingress on the flow's path, in path order, each with the entry
+// that forwards the flow on. Uses the same next-hop choice as GetNextHop at every hop.
+void SDNController::BuildPathEntries(Ptr<NetDevice> inPort, const controlPacket& ctrl, const FlowEntry& ingress,
+                                     PathEntries& hops)
+{
+    hops.clear();
+    uint32_t src, dst;
+    if (!ingress.outputDevice || !ResolveRoute(inPort, ctrl.dstIp, src, dst)) return;
+
+    FlowKey key;
+    key.srcIp = ctrl.srcIp.Get();
+    key.dstIp = ctrl.dstIp.Get();
+    key.srcPort = ctrl.srcPort;
+    key.dstPort = ctrl.dstPort;
+    key.protocol = ctrl.protocolNumber;
+
+    uint32_t edge = SelectRoute(src, dst, key);
+    uint32_t node = m_topology.GetTarget(edge);
+    while (node < m_nSwitches && hops.size() < m_nSwitches) {
+        edge = SelectRoute(node, dst, key);
+        if (edge == kNoRoute) break;
+
+        Ptr<SDNSwitch> swtch = GetSwitchAt(node);
+        if (swtch) {
+            FlowEntry entry = ingress;
+            entry.outputDevice = m_topology.GetPort(edge);
+            hops.push_back(std::make_pair(swtch, entry));
+        }
+        node = m_topology.GetTarget(edge);
+    }
+}
+
+// Egress first. Direct installs are done on return; switches sent a FlowAdd over a channel
+// are added to fenced, and the caller must hold back the ingress rule until they confirm
+void SDNController::InstallPathEntries(const PathEntries& hops, std::vector<Ptr<SDNSwitch>>& fenced)
+{
+    for (auto hop = hops.rbegin(); hop != hops.rend(); ++hop) {
+        if (hop->first->GetControlChannel()) {
+            controlPacket flowAdd;
+            flowAdd.type = FlowAdd;
+            flowAdd.xid = m_nextXid++;
+            flowAdd.bufferId = kNoBuffer;
+            flowAdd.flowEntry = hop->second;
+            SendToSwitch(hop->first, flowAdd);
+            fenced.push_back(hop->first);
+        } else {
+            InstallDirect(hop->first, hop->second);
+        }
+    }
+    m_flowMods += hops.size();
+    NS_LOG_INFO("SDNController: Flow installed on " << hops.size() << " downstream switches");
+}
+
+// Sends messages once every switch in fenced has confirmed, with a barrier, all it was sent
+// before; at once if fenced is empty, and after BarrierTimeout if a barrier is lost.
+void SDNController::SendAfterBarriers(const std::vector<Ptr<SDNSwitch>>& fenced, const SwitchMessages& messages)
+{
+    if (fenced.empty()) {
+        for (const auto& message : messages) {
+            SendToSwitch(message.first, message.second);
+        }
+        return;
+    }
+    uint32_t id = m_nextXid;
+    Fence& fence = m_fences[id];
+    fence.messages = messages;
+    fence.size = fenced.size();
+    fence.barriers = fenced.size();
+    for (const auto& swtch : fenced) {
+        controlPacket barrier;
+        barrier.type = BarrierRequest;
+        barrier.xid = m_nextXid++;
+        m_fenceOf[barrier.xid] = id;
+        SendToSwitch(swtch, barrier);
+    }
+    Simulator::Schedule(m_barrierTimeout, &SDNController::ExpireFence, this, id);
+}
+
+void SDNController::ConfirmBarrier(uint32_t xid)
+{
+    auto of = m_fenceOf.find(xid);
+    if (of == m_fenceOf.end()) return;
+    uint32_t id = of->second;
+    m_fenceOf.erase(of);
+    if (--m_fences[id].barriers == 0) {
+        ReleaseFence(id);
+    }
+}
+
+void SDNController::ExpireFence(uint32_t id)
+{
+    auto fence = m_fences.find(id);
+    if (fence == m_fences.end()) return;
+    NS_LOG_WARN("SDNController: " << fence->second.barriers << " barriers unconfirmed, sending held messages");
+    for (uint32_t b = 0; b < fence->second.size; b++) {
+        m_fenceOf.erase(id + b);
+    }
+    ReleaseFence(id);
+}
+
+void SDNController::ReleaseFence(uint32_t id)
+{
+    auto fence = m_fences.find(id);
+    SwitchMessages messages;
+    messages.swap(fence->second.messages);
+    m_fences.erase(fence);
+    for (const auto& message : messages) {
+        SendToSwitch(message.first, message.second);
+    }
+}
+
+// Resolves every queued PacketIn. Switches along the paths get one bulk FlowAdd each, then
+// the switches that missed get theirs, followed by a barrier, once the path switches have
+// confirmed (see SendAfterBarriers). Switches are served in the order they first appear.
+void SDNController::ProcessPacketInBatch()
+{
+    m_batchEvent.Cancel();
+    std::vector<QueuedPacketIn> batch;
+    batch.swap(m_packetInQueue);
+
+    SwitchMessages path;
+    SwitchMessages replies;
+    std::unordered_map<const SDNSwitch*, size_t> pathIndex;
+    std::unordered_map<const SDNSwitch*, size_t> replyIndex;
+    auto addFlowMod = [](SwitchMessages& bulks, std::unordered_map<const SDNSwitch*, size_t>& index,
+                         Ptr<SDNSwitch> swtch, const FlowEntry& entry, uint32_t bufferId) {
+        auto found = index.find(PeekPointer(swtch));
+        if (found == index.end()) {
+            found = index.emplace(PeekPointer(swtch), bulks.size()).first;
+            controlPacket bulk;
+            bulk.type = FlowAdd;
+            bulk.bufferId = kNoBuffer;
+            bulks.push_back(std::make_pair(swtch, bulk));
+        }
+        FlowMod mod;
+        mod.entry = entry;
+        mod.bufferId = bufferId;
+        bulks[found->second].second.flowMods.push_back(mod);
+    };
+
+    PathEntries hops;
+    for (const auto& packetIn : batch) {
+        m_batchDelay.Add(Simulator::Now() - packetIn.queued);
+        FlowEntry entry = BuildFlowEntry(packetIn.inPort, packetIn.ctrl);
+        if (entry.outputDevice) {
+            m_flowMods++;
+        }
+        if (m_installPath) {
+            BuildPathEntries(packetIn.inPort, packetIn.ctrl, entry, hops);
+            m_flowMods += hops.size();
+            for (auto hop = hops.rbegin(); hop != hops.rend(); ++hop) {
+                if (hop->first->GetControlChannel()) {
+                    addFlowMod(path, pathIndex, hop->first, hop->second, kNoBuffer);
+                } else {
+                    InstallDirect(hop->first, hop->second);
+                }
+            }
+        }
+        addFlowMod(replies, replyIndex, packetIn.swtch, entry, packetIn.ctrl.bufferId);
+    }
+
+    std::vector<Ptr<SDNSwitch>> fenced;
+    for (auto& bulk : path) {
+        bulk.second.xid = m_nextXid++;
+        SendToSwitch(bulk.first, bulk.second);
+        fenced.push_back(bulk.first);
+    }
+    SwitchMessages held;
+    for (auto& reply : replies) {
+        reply.second.xid = m_nextXid++;
+        held.push_back(reply);
+
+        controlPacket barrier;
+        barrier.type = BarrierRequest;
+        barrier.xid = m_nextXid++;
+        held.push_back(std::make_pair(reply.first, barrier));
+    }
+    SendAfterBarriers(fenced, held);
+    NS_LOG_INFO("SDNController: Batch of " << batch.size() << " PacketIns answered with "
+                << path.size() + replies.size() << " bulk FlowAdds");
+}
+
+uint64_t SDNController::GetNPacketIns() const
+{
+    return m_packetIns;
+}
+
+uint64_t SDNController::GetNFlowMods() const
+{
+    return m_flowMods;
+}
+
+uint64_t SDNController::GetNArpRequests() const
+{
+    return m_arpRequests;
+}
+
+uint64_t SDNController::GetNArpMisses() const
+{
+    return m_arpMisses;
+}
+
+uint64_t SDNController::GetNFlowsRerouted() const
+{
+    return m_flowsRerouted;
+}
+
+const LatencyHistogram& SDNController::GetBatchDelay() const
+{
+    return m_batchDelay;
+}
+
+void SDNController::SetDetached(bool detached)
+{
+    m_detached = detached;
+}
+
+uint64_t SDNController::GetNSwallowed() const
+{
+    return m_swallowed;
+}
 
 void SDNController::SendPacketOut(Ptr<SDNSwitch> swtch, Ptr<Packet> packet, Ptr<NetDevice> dev)
 {
@@ -314,20 +1195,9 @@ void SDNController::SendPacketOut(Ptr<SDNSwitch> swtch, Ptr<Packet> packet, Ptr<
     {
         Address addr = dev->GetAddress();
  
-        Ipv4Header ipv4Header;
-        TcpHeader tcpHeader;
-        UdpHeader udpHeader;
-        uint16_t protocol;
- 
-        // Copy the packet to avoid modifying the original
-        Ptr<Packet> copy = packet->Copy();
- 
-        // Extract the IP header
-        if (!copy->RemoveHeader(ipv4Header)) return;
-        protocol = ipv4Header.GetProtocol();
-       
+        // Re-inject as an IPv4 packet; the switch parses the headers itself
         NS_LOG_INFO("SDNController: Sending packet to switch");
-        swtch->ReceivePacket(dev, packet, protocol, addr, addr, ns3::NetDevice::PacketType::PACKET_HOST); // Or ReceiveControlMessage if separate
+        swtch->ReceivePacket(dev, packet, 0x0800, addr, addr, ns3::NetDevice::PacketType::PACKET_HOST); // Or ReceiveControlMessage if separate
     }
 }
 
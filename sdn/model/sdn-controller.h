@@ -4,60 +4,202 @@
 #include "ns3/openflow-switch-net-device.h"
 #include "ns3/sdn-switch.h"
 #include "control-packet.h"
+#include "sdn-topology-graph.h"
+#include "sdn-lpm-table.h"
+#include "sdn-latency-histogram.h"
 #include "ns3/node-container.h"
 #include "ns3/net-device-container.h"
 #include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
 #include <vector>
 #include <map>
 #include <queue>
+#include <unordered_map>
+#include <functional>
 namespace ns3 {
 namespace sdn {
 
 class SDNSwitch;
 
-// Structure to represent network links
-struct Link {
-    uint32_t neighborId;
-    Ptr<NetDevice> outgoingPort;
-    uint32_t weight;  // Can be hop count (1) or another metric
-};
-
-struct graphNode {
-    uint32_t id;
-    Ptr<NetDevice> device;  // Device on source node for this link
-    Address macAddr;
-    Ipv4Address ipAddr;
-
-    bool operator<(const graphNode& other) const {
-        return id < other.id;  // Compare by node ID (extend if needed)
-    }
-};
-
 class SDNController : public Object //public ns3::ofi::Controller
 {
 public:
+    // How FlowAdd picks among equal-cost next hops
+    enum MultipathMode {
+        SinglePath,     // Always the one path chosen during route computation
+        Ecmp,           // Hash the flow 5-tuple over all equal-cost next hops
+        WeightedEcmp    // As Ecmp, with each next hop weighted by SetPortWeight
+    };
+
+    // What happens to an ARP request for an address the controller has no binding for
+    enum ArpMissPolicy {
+        ArpMissDrop,    // Leave it unanswered
+        ArpMissFlood    // Send it out of every host-facing switch port; the reply is learned
+    };
+
     SDNController();
     virtual ~SDNController();
 
     void PopulateRoutingTable(const NodeContainer& nodes, const NodeContainer& switches, const NetDeviceContainer& devices);
     Ptr<NetDevice> GetNextHop(Ptr<NetDevice> currDevice, Ipv4Address dstIp);
+    Ptr<NetDevice> GetNextHop(Ptr<NetDevice> currDevice, const controlPacket& ctrl);
+    void SetPortWeight(Ptr<NetDevice> port, uint32_t weight);
+    // Routes a destination prefix to a node (a gateway or border host, say). Host addresses and
+    // longer prefixes take precedence; routes persist across PopulateRoutingTable calls.
+    void AddRoute(Ipv4Address prefix, Ipv4Mask mask, Ptr<Node> node);
+
+    // Pushes a destination-based rule (any source, port and protocol) for every reachable host
+    // to every registered switch, so new flows are forwarded without a PacketIn. Under Ecmp and
+    // WeightedEcmp a destination gets one rule per equal-cost next hop instead, each covering
+    // a share of the source port range, since a rule cannot hash the 5-tuple.
+    void InstallProactiveFlows();
     
     void DisplayDetailedRoutingTable() const;
     void DisplayARPResolution();
 
     void AddSwitch(Ptr<SDNSwitch> swtch);
 
-    Address AddressResolution(Ipv4Address ipAddr);
+    // Topology events; only switches whose shortest paths use a changed link are recomputed
+    void SetLinkState(Ptr<NetDevice> port, bool up);
+    void SetSwitchState(Ptr<SDNSwitch> swtch, bool up);
+
+    // False (and mac untouched) if ipAddr has no binding
+    bool AddressResolution(Ipv4Address ipAddr, Address& mac) const;
     void HandlePacketIn (Ptr<SDNSwitch> m_switch, controlPacket* ctrl, Ptr<NetDevice> device);
     void SendPacketOut (Ptr<SDNSwitch> swtch, Ptr<Packet> packet, Ptr<NetDevice> dev);
 
+    // Control-plane counters. FlowMods count the flow rules sent or installed, whether in
+    // answer to a PacketIn, along a path or proactively.
+    uint64_t GetNPacketIns() const;
+    uint64_t GetNFlowMods() const;
+    uint64_t GetNArpRequests() const;
+    uint64_t GetNArpMisses() const;
+    uint64_t GetNFlowsRerouted() const;
+    // Time PacketIns spend queued for their batch (BatchWindow)
+    const LatencyHistogram& GetBatchDelay() const;
+
+    // While detached, decisions are still made and traced but none reaches a switch: nothing
+    // is sent over a channel or installed directly. SDNTraceReplay detaches the controller so
+    // only replayed inputs drive it.
+    void SetDetached(bool detached);
+    uint64_t GetNSwallowed() const;   // Decisions dropped while detached
+
     static ns3::TypeId GetTypeId();
+    typedef void (*PacketInTracedCallback)(Ptr<SDNSwitch> swtch, const controlPacket& ctrl);
+    typedef void (*ControlMessageTracedCallback)(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port);
+    typedef void (*DecisionTracedCallback)(Ptr<SDNSwitch> swtch, const controlPacket& ctrl);
     
 private:
+    // A PacketIn waiting for the next batch
+    struct QueuedPacketIn {
+        Ptr<SDNSwitch> swtch;
+        controlPacket ctrl;
+        Ptr<NetDevice> inPort;
+        Time queued;
+    };
+
+    typedef std::vector<std::pair<Ptr<SDNSwitch>, FlowEntry>> PathEntries;
+    typedef std::vector<std::pair<Ptr<SDNSwitch>, controlPacket>> SwitchMessages;
+
+    // Messages held until every barrier of their fence is confirmed
+    struct Fence {
+        SwitchMessages messages;
+        uint32_t size;        // Barriers sent, with consecutive xids from the fence's id
+        uint32_t barriers;    // Of those, not confirmed yet
+    };
+
+    struct StaticRoute {
+        Ipv4Address prefix;
+        uint8_t length;
+        uint32_t nodeId;
+    };
+
+    FlowEntry BuildFlowEntry(Ptr<NetDevice> inPort, const controlPacket& ctrl);
+    void BuildPathEntries(Ptr<NetDevice> inPort, const controlPacket& ctrl, const FlowEntry& ingress, PathEntries& hops);
+    void InstallPathEntries(const PathEntries& hops, std::vector<Ptr<SDNSwitch>>& fenced);
+    void SendAfterBarriers(const std::vector<Ptr<SDNSwitch>>& fenced, const SwitchMessages& messages);
+    void ConfirmBarrier(uint32_t xid);
+    void ExpireFence(uint32_t id);
+    void ReleaseFence(uint32_t id);
+    void ProcessPacketInBatch();
+    void SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl);
+    void TraceDirectInstall(Ptr<SDNSwitch> swtch, const FlowEntry& entry);
+    FlowId InstallDirect(Ptr<SDNSwitch> swtch, const FlowEntry& entry);
+    bool SwallowDecision();
+    void PushArpCaches();
+    void LearnArpBinding(Ipv4Address ipAddr, const Address& mac);
+    void FloodArpRequest(const controlPacket& ctrl, Ptr<NetDevice> inPort);
+
+    uint32_t AddNodeIndex(uint32_t nodeId);
+    bool ResolveRoute(Ptr<NetDevice> currDevice, Ipv4Address dstIp, uint32_t& src, uint32_t& dst) const;
+    uint32_t SelectRoute(uint32_t src, uint32_t dst, const FlowKey& key) const;
+    bool IsEqualCostHop(uint32_t src, uint32_t dst, uint32_t edge) const;
+    bool GetSwitchIndex(Ptr<SDNSwitch> swtch, uint32_t& index) const;
+    Ptr<SDNSwitch> GetSwitchAt(uint32_t index);
+    void ApplyTopologyChange(const std::vector<uint32_t>& edges, const std::function<void()>& change);
+    void UpdateSwitchFlows(uint32_t index, const std::vector<uint8_t>& changedDst);
+    uint32_t InstallSwitchProactiveFlows(uint32_t index, const std::vector<uint8_t>* changedDst);
+
     std::vector<Ptr<SDNSwitch>> m_switches;
-    std::map<graphNode, std::vector<Link>> networkTopologyGraph;
-    std::map<std::pair<uint32_t, uint32_t>, Ptr<NetDevice>> m_routingTable;
-    std::map<Ipv4Address, Address> arpTable;
+    std::unordered_map<Ipv4Address, Address, Ipv4AddressHash> arpTable;
+    ArpMissPolicy m_arpMissPolicy;
+    bool m_arpCachePush;         // Keep every switch's ARP cache filled from arpTable
+    bool m_arpPushPending;
+
+    // Resolution indexes built by PopulateRoutingTable; nodes are renumbered densely (0..N-1),
+    // switches first, so indexes [0, m_nSwitches) are the nodes that forward traffic
+    std::vector<uint32_t> m_nodeIds;                                  // dense index -> ns-3 node id
+    std::unordered_map<uint32_t, uint32_t> m_nodeIndex;               // ns-3 node id -> dense index
+    std::unordered_map<const NetDevice*, uint32_t> m_deviceIndex;     // any device -> dense index of its node
+    std::unordered_map<Ipv4Address, uint32_t, Ipv4AddressHash> m_ipIndex;  // host IP -> dense index
+    // Destination resolution: host addresses (/32), subnets owned by a single node and
+    // static routes, longest prefix wins
+    LpmTable m_prefixes;
+    std::vector<StaticRoute> m_staticRoutes;
+
+    uint32_t m_nSwitches;
+    uint32_t m_routeThreads;     // Worker threads for route computation (0 = one per core)
+    MultipathMode m_multipathMode;
+    bool m_proactiveMode;
+    bool m_proactivePending;     // Proactive install scheduled for simulation start
+    uint16_t m_flowIdleTimeout;  // Timeouts (seconds) for flows installed on PacketIn
+    uint16_t m_flowHardTimeout;
+    bool m_installPath;          // Install each new flow on every switch along its path
+    Time m_barrierTimeout;       // Held messages are sent anyway after this long
+
+    // Batched PacketIn handling (switches with a control channel only)
+    Time m_batchWindow;          // Zero disables batching
+    uint32_t m_batchSize;
+    std::vector<QueuedPacketIn> m_packetInQueue;
+    EventId m_batchEvent;
+    std::unordered_map<uint32_t, uint32_t> m_fenceOf;   // Outstanding barrier xid -> its fence
+    std::unordered_map<uint32_t, Fence> m_fences;       // By the xid of the fence's first barrier
+    uint32_t m_nextXid;
+    bool m_detached;
+    std::unordered_map<const NetDevice*, uint32_t> m_portWeights;   // WeightedEcmp share per port (default 1)
+    TopologyGraph m_topology;
+
+    // Next-hop matrix: entry [switch * N + dst] is the topology edge (outgoing port) on the switch
+    // towards dst, kNoRoute if unreachable. m_distances holds the matching path costs.
+    std::vector<uint32_t> m_routingTable;
+    std::vector<uint32_t> m_distances;
+
+    std::vector<Ptr<SDNSwitch>> m_switchAt;   // dense switch index -> registered switch (built lazily)
+    bool m_switchAtStale;
+
+    // Metrics, exported by SDNMetricsExporter
+    uint64_t m_packetIns;
+    uint64_t m_flowMods;
+    uint64_t m_arpRequests;
+    uint64_t m_arpMisses;
+    uint64_t m_flowsRerouted;
+    uint64_t m_swallowed;
+    LatencyHistogram m_batchDelay;
+    TracedCallback<Ptr<SDNSwitch>, const controlPacket&> m_packetInTrace;
+    TracedCallback<Ptr<SDNSwitch>, const controlPacket&, Ptr<NetDevice>> m_controlMessageTrace;
+    TracedCallback<Ptr<SDNSwitch>, const controlPacket&> m_decisionTrace;
 };
 
 }
@@ -66,4 +208,4 @@ private:
 
 
 // the graph will have node and its links information
-// the routing table maps the src and dest ip to the net dev
\ No newline at end of file
+// the routing table maps the src switch and dest node to the net dev
\ No newline at end of file
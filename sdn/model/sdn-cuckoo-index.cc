@@ -0,0 +1,249 @@
+#include "sdn-cuckoo-index.h"
+
+#include <algorithm>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SDN_CUCKOO_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+namespace sdn {
+
+static uint32_t MatchScalar(const uint16_t* first, const uint16_t* second, uint16_t sig)
+{
+    uint32_t mask = 0;
+    for (uint32_t way = 0; way < 8; way++) {
+        if (first[way] == sig) mask |= 3u << (2 * way);
+        if (second[way] == sig) mask |= 3u << (16 + 2 * way);
+    }
+    return mask;
+}
+
+#ifdef SDN_CUCKOO_X86
+// Compiled for the target ISA regardless of the build flags; only called once the CPU is known to have it
+__attribute__((target("sse2")))
+static uint32_t MatchSse2(const uint16_t* first, const uint16_t* second, uint16_t sig)
+{
+    __m128i needle = _mm_set1_epi16(static_cast<short>(sig));
+    uint32_t lo = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(first)), needle));
+    uint32_t hi = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(second)), needle));
+    return lo | (hi << 16);
+}
+
+__attribute__((target("avx2")))
+static uint32_t MatchAvx2(const uint16_t* first, const uint16_t* second, uint16_t sig)
+{
+    __m256i rows = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(first))),
+        _mm_load_si128(reinterpret_cast<const __m128i*>(second)), 1);
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi16(rows, _mm256_set1_epi16(static_cast<short>(sig))));
+}
+#endif
+
+CuckooIndex::SimdLevel CuckooIndex::GetSupportedSimdLevel()
+{
+#ifdef SDN_CUCKOO_X86
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Avx2;
+        if (__builtin_cpu_supports("sse2")) return Sse2;
+        return Scalar;
+    }();
+    return level;
+#else
+    return Scalar;
+#endif
+}
+
+CuckooIndex::CuckooIndex()
+    : m_buckets(16),
+      m_keys(16 * kWays),
+      m_mask(15),
+      m_size(0),
+      m_kick(0)
+{
+    SetSimdLevel(Avx2);
+}
+
+void CuckooIndex::SetSimdLevel(SimdLevel level)
+{
+    m_simdLevel = std::min(level, GetSupportedSimdLevel());
+    switch (m_simdLevel) {
+#ifdef SDN_CUCKOO_X86
+    case Avx2:
+        m_match = &MatchAvx2;
+        break;
+    case Sse2:
+        m_match = &MatchSse2;
+        break;
+#endif
+    default:
+        m_match = &MatchScalar;
+        break;
+    }
+}
+
+// Partial-key cuckoo hashing: the alternate bucket depends only on the current one and the
+// signature, so an entry can be displaced without rehashing its key
+uint32_t CuckooIndex::AltBucket(uint32_t bucket, uint16_t sig) const
+{
+    return (bucket ^ (sig * 0x5bd1e995u)) & m_mask;
+}
+
+CuckooIndex::Probe CuckooIndex::MakeProbe(const FlowKey& key) const
+{
+    uint64_t hash = FlowKeyHash()(key);
+    Probe probe;
+    probe.sig = static_cast<uint16_t>(hash >> 48);
+    probe.sig |= probe.sig == 0;   // 0 marks an empty way
+    probe.first = static_cast<uint32_t>(hash) & m_mask;
+    probe.second = AltBucket(probe.first, probe.sig);
+    return probe;
+}
+
+FlowId CuckooIndex::Resolve(const FlowKey& key, const Probe& probe) const
+{
+    uint32_t mask = m_match(m_buckets[probe.first].sigs, m_buckets[probe.second].sigs, probe.sig);
+    while (mask) {
+        uint32_t bit = __builtin_ctz(mask);
+        uint32_t bucket = bit < 16 ? probe.first : probe.second;
+        uint32_t way = (bit & 15) >> 1;
+        if (m_keys[bucket * kWays + way] == key) {
+            return m_buckets[bucket].ids[way];
+        }
+        mask &= ~(3u << bit);
+    }
+    return kNoFlow;
+}
+
+bool CuckooIndex::Locate(const FlowKey& key, const Probe& probe, uint32_t& bucket, uint32_t& way) const
+{
+    for (uint32_t candidate : {probe.first, probe.second}) {
+        for (uint32_t w = 0; w < kWays; w++) {
+            if (m_buckets[candidate].sigs[w] == probe.sig && m_keys[candidate * kWays + w] == key) {
+                bucket = candidate;
+                way = w;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+uint32_t CuckooIndex::FreeWay(uint32_t bucket) const
+{
+    for (uint32_t way = 0; way < kWays; way++) {
+        if (m_buckets[bucket].sigs[way] == 0) return way;
+    }
+    return kWays;
+}
+
+// Puts the entry in 'bucket' or its alternate, displacing residents along a random-ish walk.
+// On failure the arguments hold whichever entry was left without a way.
+bool CuckooIndex::Place(FlowKey& key, uint16_t& sig, FlowId& id, uint32_t bucket)
+{
+    uint32_t way = FreeWay(bucket);
+    if (way == kWays) {
+        bucket = AltBucket(bucket, sig);
+        way = FreeWay(bucket);
+    }
+    for (uint32_t kick = 0; kick <= kMaxKicks; kick++) {
+        if (way < kWays) {
+            m_buckets[bucket].sigs[way] = sig;
+            m_buckets[bucket].ids[way] = id;
+            m_keys[bucket * kWays + way] = key;
+            return true;
+        }
+
+        // Full: take the place of a resident, which then tries its own alternate bucket
+        way = m_kick++ % kWays;
+        std::swap(m_buckets[bucket].sigs[way], sig);
+        std::swap(m_buckets[bucket].ids[way], id);
+        std::swap(m_keys[bucket * kWays + way], key);
+        bucket = AltBucket(bucket, sig);
+        way = FreeWay(bucket);
+    }
+    return false;
+}
+
+void CuckooIndex::Add(FlowKey key, FlowId id)
+{
+    Probe probe = MakeProbe(key);
+    uint16_t sig = probe.sig;
+    while (!Place(key, sig, id, probe.first)) {
+        Grow();
+        probe = MakeProbe(key);
+    }
+}
+
+void CuckooIndex::Grow()
+{
+    std::vector<Bucket> buckets(2 * (m_mask + 1));
+    std::vector<FlowKey> keys(buckets.size() * kWays);
+    buckets.swap(m_buckets);
+    keys.swap(m_keys);
+    m_mask = m_buckets.size() - 1;
+
+    for (uint32_t bucket = 0; bucket < buckets.size(); bucket++) {
+        for (uint32_t way = 0; way < kWays; way++) {
+            if (buckets[bucket].sigs[way] != 0) {
+                Add(keys[bucket * kWays + way], buckets[bucket].ids[way]);
+            }
+        }
+    }
+}
+
+void CuckooIndex::Insert(const FlowKey& key, FlowId id)
+{
+    Probe probe = MakeProbe(key);
+    uint32_t bucket;
+    uint32_t way;
+    if (Locate(key, probe, bucket, way)) {
+        m_buckets[bucket].ids[way] = id;
+        return;
+    }
+    Add(key, id);
+    m_size++;
+}
+
+void CuckooIndex::Erase(const FlowKey& key)
+{
+    uint32_t bucket;
+    uint32_t way;
+    if (Locate(key, MakeProbe(key), bucket, way)) {
+        m_buckets[bucket].sigs[way] = 0;
+        m_buckets[bucket].ids[way] = kNoFlow;
+        m_size--;
+    }
+}
+
+FlowId CuckooIndex::Find(const FlowKey& key) const
+{
+    if (m_size == 0) return kNoFlow;
+    return Resolve(key, MakeProbe(key));
+}
+
+void CuckooIndex::FindBatch(const FlowKey* keys, uint32_t count, FlowId* ids) const
+{
+    if (m_size == 0) {
+        std::fill(ids, ids + count, kNoFlow);
+        return;
+    }
+
+    Probe probes[kGroup];
+    for (uint32_t base = 0; base < count; base += kGroup) {
+        uint32_t n = std::min(kGroup, count - base);
+        for (uint32_t i = 0; i < n; i++) {
+            probes[i] = MakeProbe(keys[base + i]);
+            __builtin_prefetch(&m_buckets[probes[i].first]);
+            __builtin_prefetch(&m_buckets[probes[i].second]);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            ids[base + i] = Resolve(keys[base + i], probes[i]);
+        }
+    }
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,87 @@
+#ifndef SDN_CUCKOO_INDEX_H
+#define SDN_CUCKOO_INDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "sdn-flow-key.h"
+
+namespace ns3 {
+namespace sdn {
+
+// Exact-match FlowKey -> FlowId index built for burst lookups.
+// Bucketized cuckoo hash: every key lives in one of two buckets of eight ways, and each
+// bucket keeps the 16-bit signatures of its ways in one 16-byte row. A lookup compares the
+// key's signature against both rows at once (SSE2: two compares, AVX2: one) and reads a full
+// key only for the matching ways. FindBatch hashes and prefetches a group of keys before
+// probing any of them, so the bucket misses of a burst overlap.
+// The SIMD width is picked at runtime; the scalar path is always available.
+class CuckooIndex
+{
+public:
+    enum SimdLevel {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    // Widest path this CPU (and build) supports
+    static SimdLevel GetSupportedSimdLevel();
+
+    CuckooIndex();
+
+    // Clamped to GetSupportedSimdLevel()
+    void SetSimdLevel(SimdLevel level);
+    SimdLevel GetSimdLevel() const { return m_simdLevel; }
+
+    // Adds the key, or points it at a new id if already present
+    void Insert(const FlowKey& key, FlowId id);
+    void Erase(const FlowKey& key);
+    FlowId Find(const FlowKey& key) const;
+    // ids[i] = Find(keys[i]), kNoFlow for a miss
+    void FindBatch(const FlowKey* keys, uint32_t count, FlowId* ids) const;
+
+    uint32_t GetSize() const { return m_size; }
+    uint32_t GetNBuckets() const { return m_mask + 1; }
+
+private:
+    static constexpr uint32_t kWays = 8;
+    static constexpr uint32_t kGroup = 16;      // Keys hashed and prefetched ahead in FindBatch
+    static constexpr uint32_t kMaxKicks = 256;  // Displacements before the table grows
+
+    // Signatures first: the row a probe compares is the bucket's first 16 bytes
+    struct alignas(64) Bucket {
+        uint16_t sigs[kWays];      // 0 = empty way
+        FlowId ids[kWays];
+    };
+
+    struct Probe {
+        uint32_t first;
+        uint32_t second;
+        uint16_t sig;
+    };
+
+    // Bit 2*w (and 2*w+1) set when way w matches: bits 0-15 for the first bucket, 16-31 for the second
+    typedef uint32_t (*MatchFunction)(const uint16_t* first, const uint16_t* second, uint16_t sig);
+
+    Probe MakeProbe(const FlowKey& key) const;
+    uint32_t AltBucket(uint32_t bucket, uint16_t sig) const;
+    FlowId Resolve(const FlowKey& key, const Probe& probe) const;
+    bool Locate(const FlowKey& key, const Probe& probe, uint32_t& bucket, uint32_t& way) const;
+    uint32_t FreeWay(uint32_t bucket) const;
+    bool Place(FlowKey& key, uint16_t& sig, FlowId& id, uint32_t bucket);
+    void Add(FlowKey key, FlowId id);
+    void Grow();
+
+    std::vector<Bucket> m_buckets;
+    std::vector<FlowKey> m_keys;     // kWays per bucket, read only to confirm a signature match
+    uint32_t m_mask;                 // Buckets - 1 (a power of two)
+    uint32_t m_size;
+    uint32_t m_kick;                 // Rotates the displaced way
+    SimdLevel m_simdLevel;
+    MatchFunction m_match;
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_CUCKOO_INDEX_H
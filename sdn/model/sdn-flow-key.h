@@ -0,0 +1,44 @@
+#ifndef SDN_FLOW_KEY_H
+#define SDN_FLOW_KEY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ns3 {
+namespace sdn {
+
+// Handle of an installed rule, valid until the rule is removed
+typedef uint32_t FlowId;
+const FlowId kNoFlow = 0xffffffff;
+
+// Exact-match key used to index installed flows: (srcIp, dstIp, srcPort, dstPort, protocol)
+struct FlowKey {
+  uint32_t srcIp;
+  uint32_t dstIp;
+  uint16_t srcPort;
+  uint16_t dstPort;
+  uint8_t protocol;
+
+  bool operator==(const FlowKey& other) const {
+    return srcIp == other.srcIp && dstIp == other.dstIp &&
+           srcPort == other.srcPort && dstPort == other.dstPort &&
+           protocol == other.protocol;
+  }
+};
+
+struct FlowKeyHash {
+  size_t operator()(const FlowKey& key) const {
+    // Fold the tuple into two 64-bit words and mix them (splitmix64 finalizer)
+    uint64_t h = (static_cast<uint64_t>(key.srcIp) << 32) | key.dstIp;
+    h ^= ((static_cast<uint64_t>(key.srcPort) << 24) | (static_cast<uint64_t>(key.dstPort) << 8) | key.protocol)
+         * 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<size_t>(h ^ (h >> 31));
+  }
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_FLOW_KEY_H
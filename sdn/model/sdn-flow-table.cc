@@ -1,85 +1,812 @@
 #include "sdn-flow-table.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+
+#include <algorithm>
 
 namespace ns3 {
 namespace sdn {
 
 NS_LOG_COMPONENT_DEFINE("SDNFlowTable");
 
+TypeId SDNFlowTable::GetTypeId()
+{
+	static TypeId tid = TypeId("ns3::sdn::SDNFlowTable")
+		.SetParent<Object>()
+		.SetGroupName("SDN")
+		.AddConstructor<SDNFlowTable>()
+		.AddAttribute("MaxEntries",
+					  "Capacity of the table; a new entry beyond it evicts one (0 = unbounded)",
+					  UintegerValue(0),
+					  MakeUintegerAccessor(&SDNFlowTable::m_maxEntries),
+					  MakeUintegerChecker<uint32_t>())
+		.AddAttribute("EvictionPolicy",
+					  "Which entry to drop when the table is full",
+					  EnumValue(SDNFlowTable::Lru),
+					  MakeEnumAccessor<EvictionPolicy>(&SDNFlowTable::m_evictionPolicy),
+					  MakeEnumChecker(SDNFlowTable::Lru, "Lru",
+									  SDNFlowTable::Lfu, "Lfu",
+									  SDNFlowTable::Random, "Random"))
+		.AddAttribute("EvictionSamples",
+					  "Entries sampled by the Lfu policy; the one with the fewest packets is evicted",
+					  UintegerValue(8),
+					  MakeUintegerAccessor(&SDNFlowTable::m_evictionSamples),
+					  MakeUintegerChecker<uint32_t>(1))
+		.AddAttribute("LookupSimd",
+					  "Widest SIMD path used by burst lookups; lowered to what the CPU supports",
+					  EnumValue(CuckooIndex::Avx2),
+					  MakeEnumAccessor<CuckooIndex::SimdLevel>(&SDNFlowTable::SetLookupSimd,
+															   &SDNFlowTable::GetLookupSimd),
+					  MakeEnumChecker(CuckooIndex::Scalar, "Scalar",
+									  CuckooIndex::Sse2, "Sse2",
+									  CuckooIndex::Avx2, "Avx2"));
+	return tid;
+}
+
 SDNFlowTable::SDNFlowTable() 
+	: m_tickLength(MilliSeconds(100)),
+	  m_maxEntries(0),
+	  m_evictionPolicy(Lru),
+	  m_evictionSamples(8),
+	  m_evictions(0),
+	  m_generation(0)
 {
+	m_freeIds = kNoFlow;
+	m_head = kNoFlow;
+	m_tail = kNoFlow;
+	m_random = CreateObject<UniformRandomVariable>();
 	NS_LOG_INFO("SDNFlowTable: SDNFlowTable created");
 }
 
 SDNFlowTable::~SDNFlowTable()
 {
+	m_tickEvent.Cancel();
 	NS_LOG_INFO("SDNFlowTable: SDNFlowTable destroyed");
 }
 
-FlowEntry* SDNFlowTable::AddFlowEntry(const FlowEntry& entry) 
+void SDNFlowTable::SetFlowRemovedCallback(FlowRemovedCallback callback)
 {
-	// Store internal NS3 flow
-	m_flowTable.push_back(entry);
+	m_flowRemoved = callback;
+}
 
-	return &m_flowTable.back();
+void SDNFlowTable::SetTimeoutGranularity(Time granularity)
+{
+	NS_ASSERT_MSG(m_timers.GetSize() == 0, "SDNFlowTable: Granularity must be set before timeouts are armed");
+	m_tickLength = granularity;
 }
 
-bool SDNFlowTable::RemoveFlowEntry(const FlowEntry& entry) 
+FlowKey SDNFlowTable::MakeFlowKey(const FlowEntry& entry)
+{
+	FlowKey key;
+	key.srcIp = entry.srcIp.Get();
+	key.dstIp = entry.dstIp.Get();
+	key.srcPort = entry.srcPort;
+	key.dstPort = entry.dstPort;
+	key.protocol = entry.protocol;
+	return key;
+}
+
+FlowMask SDNFlowTable::MakeFlowMask(const FlowEntry& entry)
+{
+	FlowMask mask;
+	mask.srcMask = entry.srcMask.Get();
+	mask.dstMask = entry.dstMask.Get();
+	mask.srcPortRange = entry.srcPortMax > entry.srcPort;
+	mask.dstPortRange = entry.dstPortMax > entry.dstPort;
+	mask.anyProtocol = entry.anyProtocol;
+	return mask;
+}
+
+FlowKey SDNFlowTable::ApplyMask(const FlowKey& key, const FlowMask& mask)
+{
+	// Ranged ports are hashed as 0 and checked against the range inside the bucket
+	FlowKey masked;
+	masked.srcIp = key.srcIp & mask.srcMask;
+	masked.dstIp = key.dstIp & mask.dstMask;
+	masked.srcPort = mask.srcPortRange ? 0 : key.srcPort;
+	masked.dstPort = mask.dstPortRange ? 0 : key.dstPort;
+	masked.protocol = mask.anyProtocol ? 0 : key.protocol;
+	return masked;
+}
+
+bool SDNFlowTable::IsExactMask(const FlowMask& mask)
+{
+	return mask.srcMask == 0xffffffff && mask.dstMask == 0xffffffff &&
+		!mask.srcPortRange && !mask.dstPortRange && !mask.anyProtocol;
+}
+
+// Port ranges are the only part of a match the masked hash key cannot express
+static bool PortsMatch(uint16_t portMin, uint16_t portMax, uint16_t port)
+{
+	return portMax <= portMin || (port >= portMin && port <= portMax);
+}
+
+uint16_t SDNFlowTable::AddPort(Ptr<NetDevice> device)
 {
-	for (auto it = m_flowTable.begin(); it != m_flowTable.end(); ++it) 
+	for (uint16_t i = 0; i < m_ports.size(); i++)
 	{
-		if (it->srcIp == entry.srcIp && it->dstIp == entry.dstIp &&
-			it->srcPort == entry.srcPort && it->dstPort == entry.dstPort &&
-			it->protocol == entry.protocol) 
+		if (m_ports[i] == device)
 		{
-			m_flowTable.erase(it);
-			return true;
+			return i;
 		}
 	}
-  	return false;
+	m_ports.push_back(device);
+	return m_ports.size() - 1;
 }
 
-FlowEntry* SDNFlowTable::FindMatchingFlow(const Ipv4Address& srcIp, const Ipv4Address& dstIp,
-											  uint16_t srcPort, uint16_t dstPort) 
+uint16_t SDNFlowTable::GetNPorts() const
 {
-	for (auto& entry : m_flowTable) 
+	return m_ports.size();
+}
+
+const Ptr<NetDevice>& SDNFlowTable::GetPort(uint16_t port) const
+{
+	return m_ports[port];
+}
+
+SDNFlowTable::FlowTuple* SDNFlowTable::FindTuple(const FlowMask& mask)
+{
+	for (auto& tuple : m_tuples)
 	{
-		if (entry.srcIp == srcIp && entry.dstIp == dstIp &&
-			entry.srcPort == srcPort && entry.dstPort == dstPort) 
+		if (tuple->mask == mask)
 		{
-			return &entry;
+			return tuple.get();
 		}
 	}
 	return nullptr;
 }
 
-void SDNFlowTable::UpdateFlowStats(FlowEntry* entry, uint64_t packets, uint64_t bytes) 
+SDNFlowTable::FlowTuple* SDNFlowTable::GetOrCreateTuple(const FlowMask& mask)
+{
+	FlowTuple* tuple = FindTuple(mask);
+	if (tuple)
+	{
+		return tuple;
+	}
+	m_tuples.emplace_back(new FlowTuple());
+	tuple = m_tuples.back().get();
+	tuple->mask = mask;
+	tuple->maxPriority = 0;
+	return tuple;
+}
+
+void SDNFlowTable::SortTuples()
+{
+	std::stable_sort(m_tuples.begin(), m_tuples.end(),
+		[](const std::unique_ptr<FlowTuple>& a, const std::unique_ptr<FlowTuple>& b) {
+			return a->maxPriority > b->maxPriority;
+		});
+}
+
+FlowMask SDNFlowTable::GetFlowMask(FlowId flow) const
+{
+	const FlowMatch& match = m_matches[flow];
+	FlowMask mask;
+	mask.srcMask = m_meta[flow].srcMask;
+	mask.dstMask = m_meta[flow].dstMask;
+	mask.srcPortRange = match.srcPortMax > match.srcPort;
+	mask.dstPortRange = match.dstPortMax > match.dstPort;
+	mask.anyProtocol = match.anyProtocol;
+	return mask;
+}
+
+FlowKey SDNFlowTable::GetFlowKey(FlowId flow) const
+{
+	const FlowMatch& match = m_matches[flow];
+	FlowKey key;
+	key.srcIp = match.srcIp;
+	key.dstIp = match.dstIp;
+	key.srcPort = match.srcPort;
+	key.dstPort = match.dstPort;
+	key.protocol = match.protocol;
+	return key;
+}
+
+// Within one bucket the mask and masked key already agree; the rule is the same when the
+// priority and any port ranges do too
+bool SDNFlowTable::IsSameRule(FlowId flow, const FlowEntry& entry) const
+{
+	const FlowMatch& match = m_matches[flow];
+	if (match.priority != entry.priority)
+	{
+		return false;
+	}
+	if (match.srcPortMax > match.srcPort &&
+		(match.srcPort != entry.srcPort || match.srcPortMax != entry.srcPortMax))
+	{
+		return false;
+	}
+	if (match.dstPortMax > match.dstPort &&
+		(match.dstPort != entry.dstPort || match.dstPortMax != entry.dstPortMax))
+	{
+		return false;
+	}
+	return true;
+}
+
+FlowId SDNFlowTable::FindRule(const FlowEntry& entry)
+{
+	FlowMask mask = MakeFlowMask(entry);
+	FlowTuple* tuple = FindTuple(mask);
+	if (!tuple)
+	{
+		return kNoFlow;
+	}
+	auto found = tuple->buckets.find(ApplyMask(MakeFlowKey(entry), mask));
+	if (found == tuple->buckets.end())
+	{
+		return kNoFlow;
+	}
+	for (FlowId flow = found->second; flow != kNoFlow; flow = m_matches[flow].nextInBucket)
+	{
+		if (IsSameRule(flow, entry))
+		{
+			return flow;
+		}
+	}
+	return kNoFlow;
+}
+
+FlowId SDNFlowTable::AllocateId()
+{
+	if (m_freeIds != kNoFlow)
+	{
+		FlowId flow = m_freeIds;
+		m_freeIds = m_meta[flow].next;
+		return flow;
+	}
+	m_matches.emplace_back();
+	m_stats.emplace_back();
+	m_meta.emplace_back();
+	return m_matches.size() - 1;
+}
+
+void SDNFlowTable::LinkLast(FlowId flow)
+{
+	m_meta[flow].prev = m_tail;
+	m_meta[flow].next = kNoFlow;
+	if (m_tail != kNoFlow)
+	{
+		m_meta[m_tail].next = flow;
+	}
+	else
+	{
+		m_head = flow;
+	}
+	m_tail = flow;
+}
+
+void SDNFlowTable::Unlink(FlowId flow)
+{
+	FlowMeta& meta = m_meta[flow];
+	if (meta.prev != kNoFlow)
+	{
+		m_meta[meta.prev].next = meta.next;
+	}
+	else
+	{
+		m_head = meta.next;
+	}
+	if (meta.next != kNoFlow)
+	{
+		m_meta[meta.next].prev = meta.prev;
+	}
+	else
+	{
+		m_tail = meta.prev;
+	}
+}
+
+FlowId SDNFlowTable::AddFlowEntry(const FlowEntry& entry) 
+{
+	FlowId flow = FindRule(entry);
+	bool evicted = false;
+	FlowEntry victim;
+	m_generation++;
+
+	if (flow != kNoFlow)
+	{
+		// Same match already installed: overwrite it in place so its id stays valid
+		m_timers.Cancel(m_meta[flow].timer);
+	}
+	else
+	{
+		// Make room before touching the tuples, since removing the victim may drop a tuple or bucket
+		if (m_maxEntries && m_slots.size() >= m_maxEntries)
+		{
+			FlowId victimId = SelectVictim();
+			victim = GetEntry(victimId);
+			Erase(victimId);
+			m_evictions++;
+			evicted = true;
+		}
+
+		flow = AllocateId();
+		FlowMask mask = MakeFlowMask(entry);
+		FlowTuple* tuple = GetOrCreateTuple(mask);
+		auto bucket = tuple->buckets.emplace(ApplyMask(MakeFlowKey(entry), mask), kNoFlow).first;
+
+		// Keep the chain ordered by priority so the first port-range hit is the best one
+		FlowId* link = &bucket->second;
+		while (*link != kNoFlow && m_matches[*link].priority >= entry.priority)
+		{
+			link = &m_matches[*link].nextInBucket;
+		}
+		m_matches[flow].nextInBucket = *link;
+		*link = flow;
+		if (IsExactMask(mask))
+		{
+			m_exactIndex.Insert(bucket->first, bucket->second);
+		}
+
+		if (entry.priority > tuple->maxPriority)
+		{
+			tuple->maxPriority = entry.priority;
+			SortTuples();
+		}
+
+		m_meta[flow].slot = m_slots.size();
+		m_slots.push_back(flow);
+		LinkLast(flow);
+	}
+
+	FlowMatch& match = m_matches[flow];
+	match.srcIp = entry.srcIp.Get();
+	match.dstIp = entry.dstIp.Get();
+	match.srcPort = entry.srcPort;
+	match.srcPortMax = entry.srcPortMax;
+	match.dstPort = entry.dstPort;
+	match.dstPortMax = entry.dstPortMax;
+	match.priority = entry.priority;
+	match.outPort = AddPort(entry.outputDevice);
+	match.protocol = entry.protocol;
+	match.anyProtocol = entry.anyProtocol;
+
+	FlowMeta& meta = m_meta[flow];
+	meta.srcMask = entry.srcMask.Get();
+	meta.dstMask = entry.dstMask.Get();
+	meta.installTime = Simulator::Now();
+	meta.idleTimeout = entry.idleTimeout;
+	meta.hardTimeout = entry.hardTimeout;
+
+	FlowStats& stats = m_stats[flow];
+	stats.packetCount = entry.packetCount;
+	stats.byteCount = entry.byteCount;
+	stats.lastUsed = meta.installTime;
+	ArmTimer(flow);
+
+	if (evicted)
+	{
+		NS_LOG_INFO("SDNFlowTable: Table full (" << m_maxEntries << "), evicted " << victim.srcIp << ":" << victim.srcPort
+			<< " -> " << victim.dstIp << ":" << victim.dstPort);
+		if (!m_flowRemoved.IsNull())
+		{
+			m_flowRemoved(victim, FlowEvicted);
+		}
+	}
+
+	return flow;
+}
+
+FlowId SDNFlowTable::SelectVictim()
+{
+	uint32_t last = m_slots.size() - 1;
+	switch (m_evictionPolicy)
+	{
+	case Lfu:
+	{
+		FlowId victim = m_slots[m_random->GetInteger(0, last)];
+		for (uint32_t i = 1; i < m_evictionSamples; i++)
+		{
+			FlowId candidate = m_slots[m_random->GetInteger(0, last)];
+			if (m_stats[candidate].packetCount < m_stats[victim].packetCount)
+			{
+				victim = candidate;
+			}
+		}
+		return victim;
+	}
+	case Random:
+		return m_slots[m_random->GetInteger(0, last)];
+	case Lru:
+	default:
+		return m_head;
+	}
+}
+
+// Drops a rule from its tuple, the table order, the eviction index and the timer wheel,
+// and recycles its id
+void SDNFlowTable::Erase(FlowId flow)
+{
+	FlowMask mask = GetFlowMask(flow);
+	for (auto t = m_tuples.begin(); t != m_tuples.end(); ++t)
+	{
+		FlowTuple* tuple = t->get();
+		if (!(tuple->mask == mask))
+		{
+			continue;
+		}
+		auto bucket = tuple->buckets.find(ApplyMask(GetFlowKey(flow), mask));
+		FlowId* link = &bucket->second;
+		while (*link != flow)
+		{
+			link = &m_matches[*link].nextInBucket;
+		}
+		*link = m_matches[flow].nextInBucket;
+		if (IsExactMask(mask))
+		{
+			if (bucket->second == kNoFlow)
+			{
+				m_exactIndex.Erase(bucket->first);
+			}
+			else
+			{
+				m_exactIndex.Insert(bucket->first, bucket->second);
+			}
+		}
+		if (bucket->second == kNoFlow)
+		{
+			tuple->buckets.erase(bucket);
+		}
+		// maxPriority is left as an upper bound; an empty tuple is dropped altogether
+		if (tuple->buckets.empty())
+		{
+			m_tuples.erase(t);
+		}
+		break;
+	}
+
+	FlowMeta& meta = m_meta[flow];
+	m_timers.Cancel(meta.timer);
+	meta.timer = TimerWheel::kNoTimer;
+	Unlink(flow);
+
+	// Swap-remove from the dense eviction index
+	FlowId moved = m_slots.back();
+	m_slots[meta.slot] = moved;
+	m_meta[moved].slot = meta.slot;
+	m_slots.pop_back();
+
+	meta.slot = kNoFlow;
+	meta.next = m_freeIds;
+	m_freeIds = flow;
+	m_generation++;
+}
+
+bool SDNFlowTable::RemoveFlowEntry(const FlowEntry& entry) 
+{
+	FlowId flow = FindRule(entry);
+	if (flow == kNoFlow)
+	{
+		return false;
+	}
+	Erase(flow);
+	return true;
+}
+
+FlowId SDNFlowTable::FindMatchingFlow(const Ipv4Address& srcIp, const Ipv4Address& dstIp,
+									 uint16_t srcPort, uint16_t dstPort, uint8_t protocol) 
+{
+	FlowKey key;
+	key.srcIp = srcIp.Get();
+	key.dstIp = dstIp.Get();
+	key.srcPort = srcPort;
+	key.dstPort = dstPort;
+	key.protocol = protocol;
+	return FindMatchingFlow(key);
+}
+
+FlowId SDNFlowTable::FindMatchingFlow(const FlowKey& key)
+{
+	FlowId best = kNoFlow;
+	uint16_t bestPriority = 0;
+	for (const auto& tuple : m_tuples)
+	{
+		// Tuples are sorted by their highest priority, so nothing further down can win
+		if (best != kNoFlow && tuple->maxPriority <= bestPriority)
+		{
+			break;
+		}
+
+		auto found = tuple->buckets.find(ApplyMask(key, tuple->mask));
+		if (found == tuple->buckets.end())
+		{
+			continue;
+		}
+		for (FlowId flow = found->second; flow != kNoFlow; flow = m_matches[flow].nextInBucket)
+		{
+			const FlowMatch& match = m_matches[flow];
+			if (PortsMatch(match.srcPort, match.srcPortMax, key.srcPort) &&
+				PortsMatch(match.dstPort, match.dstPortMax, key.dstPort))
+			{
+				if (best == kNoFlow || match.priority > bestPriority)
+				{
+					best = flow;
+					bestPriority = match.priority;
+				}
+				break;
+			}
+		}
+	}
+
+	if (best != kNoFlow)
+	{
+		Touch(best);
+	}
+	return best;
+}
+
+void SDNFlowTable::FindMatchingFlows(const FlowKey* keys, uint32_t count, FlowId* flows)
+{
+	m_exactIndex.FindBatch(keys, count, flows);
+
+	// An exact hit is final unless some wildcard rule could outrank it
+	bool wildcards = false;
+	uint16_t wildcardPriority = 0;
+	for (const auto& tuple : m_tuples)
+	{
+		if (!IsExactMask(tuple->mask))
+		{
+			wildcards = true;
+			wildcardPriority = tuple->maxPriority;   // Sorted: the first one is the highest
+			break;
+		}
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (flows[i] != kNoFlow && (!wildcards || m_matches[flows[i]].priority > wildcardPriority))
+		{
+			Touch(flows[i]);
+		}
+		else if (wildcards)
+		{
+			flows[i] = FindMatchingFlow(keys[i]);
+		}
+	}
+}
+
+// Most recently used at the tail
+void SDNFlowTable::Touch(FlowId flow)
+{
+	if (m_maxEntries && m_evictionPolicy == Lru && flow != m_tail)
+	{
+		Unlink(flow);
+		LinkLast(flow);
+	}
+}
+
+void SDNFlowTable::UpdateFlowStats(FlowId flow, uint64_t packets, uint64_t bytes) 
+{
+	if (flow != kNoFlow) 
+	{
+		FlowStats& stats = m_stats[flow];
+		stats.packetCount += packets;
+		stats.byteCount += bytes;
+		stats.lastUsed = Simulator::Now();
+	}
+}
+
+const Ptr<NetDevice>& SDNFlowTable::GetOutputDevice(FlowId flow) const
+{
+	return m_ports[m_matches[flow].outPort];
+}
+
+uint16_t SDNFlowTable::GetOutputPort(FlowId flow) const
+{
+	return m_matches[flow].outPort;
+}
+
+FlowEntry SDNFlowTable::GetEntry(FlowId flow) const
+{
+	const FlowMatch& match = m_matches[flow];
+	const FlowMeta& meta = m_meta[flow];
+	const FlowStats& stats = m_stats[flow];
+
+	FlowEntry entry;
+	entry.srcIp = Ipv4Address(match.srcIp);
+	entry.dstIp = Ipv4Address(match.dstIp);
+	entry.srcMask = Ipv4Mask(meta.srcMask);
+	entry.dstMask = Ipv4Mask(meta.dstMask);
+	entry.srcPort = match.srcPort;
+	entry.dstPort = match.dstPort;
+	entry.srcPortMax = match.srcPortMax;
+	entry.dstPortMax = match.dstPortMax;
+	entry.protocol = match.protocol;
+	entry.anyProtocol = match.anyProtocol;
+	entry.priority = match.priority;
+	entry.idleTimeout = meta.idleTimeout;
+	entry.hardTimeout = meta.hardTimeout;
+	entry.outputDevice = m_ports[match.outPort];
+	entry.packetCount = stats.packetCount;
+	entry.byteCount = stats.byteCount;
+	entry.installTime = meta.installTime;
+	entry.lastUsed = stats.lastUsed;
+	return entry;
+}
+
+// Earliest moment either timeout can fire, given the current lastUsed
+Time SDNFlowTable::GetExpiry(FlowId flow, FlowRemovedReason& reason) const
+{
+	const FlowMeta& meta = m_meta[flow];
+	Time expiry = Time::Max();
+	if (meta.hardTimeout)
+	{
+		expiry = meta.installTime + Seconds(meta.hardTimeout);
+		reason = HardTimeoutExpired;
+	}
+	if (meta.idleTimeout)
+	{
+		Time idleExpiry = m_stats[flow].lastUsed + Seconds(meta.idleTimeout);
+		if (idleExpiry < expiry)
+		{
+			expiry = idleExpiry;
+			reason = IdleTimeoutExpired;
+		}
+	}
+	return expiry;
+}
+
+// Rounded up, so a timer never fires before its deadline
+uint64_t SDNFlowTable::ToTick(Time time) const
+{
+	int64_t length = m_tickLength.GetTimeStep();
+	return static_cast<uint64_t>((time.GetTimeStep() + length - 1) / length);
+}
+
+void SDNFlowTable::ArmTimer(FlowId flow)
+{
+	FlowMeta& meta = m_meta[flow];
+	meta.timer = TimerWheel::kNoTimer;
+	if (!meta.idleTimeout && !meta.hardTimeout)
+	{
+		return;
+	}
+
+	if (m_timers.GetSize() == 0)
+	{
+		m_timers.Reset(Simulator::Now().GetTimeStep() / m_tickLength.GetTimeStep());
+	}
+	FlowRemovedReason reason;
+	meta.timer = m_timers.Schedule(ToTick(GetExpiry(flow, reason)), flow);
+
+	if (!m_tickEvent.IsPending())
+	{
+		m_tickEvent = Simulator::Schedule(m_tickLength, &SDNFlowTable::ExpireTimers, this);
+	}
+}
+
+void SDNFlowTable::ExpireTimers()
+{
+	m_expired.clear();
+	m_timers.Advance(Simulator::Now().GetTimeStep() / m_tickLength.GetTimeStep(), m_expired);
+
+	// Remove everything first: the callback may touch the table, and the remaining
+	// expired ids must still be valid while they are processed
+	std::vector<std::pair<FlowEntry, FlowRemovedReason>> removed;
+	for (FlowId flow : m_expired)
+	{
+		m_meta[flow].timer = TimerWheel::kNoTimer;
+
+		FlowRemovedReason reason;
+		Time expiry = GetExpiry(flow, reason);
+		if (expiry > Simulator::Now())
+		{
+			// Matched since the timer was armed: push the idle deadline out
+			m_meta[flow].timer = m_timers.Schedule(ToTick(expiry), flow);
+			continue;
+		}
+
+		removed.push_back(std::make_pair(GetEntry(flow), reason));
+		Erase(flow);
+	}
+
+	if (m_timers.GetSize() > 0)
+	{
+		m_tickEvent = Simulator::Schedule(m_tickLength, &SDNFlowTable::ExpireTimers, this);
+	}
+
+	if (!removed.empty())
+	{
+		NS_LOG_INFO("SDNFlowTable: " << removed.size() << " flows timed out, " << m_slots.size() << " left");
+	}
+	if (!m_flowRemoved.IsNull())
+	{
+		for (const auto& flow : removed)
+		{
+			m_flowRemoved(flow.first, flow.second);
+		}
+	}
+}
+
+uint32_t SDNFlowTable::UpdateEntries(const std::function<bool(FlowEntry&)>& visitor)
 {
-	if (entry) 
+	std::vector<FlowId> removed;
+	for (FlowId flow = m_head; flow != kNoFlow; flow = m_meta[flow].next)
 	{
-		entry->packetCount += packets;
-		entry->byteCount += bytes;
+		FlowEntry entry = GetEntry(flow);
+		if (!visitor(entry))
+		{
+			removed.push_back(flow);
+		}
+		else if (entry.outputDevice != m_ports[m_matches[flow].outPort])
+		{
+			m_matches[flow].outPort = AddPort(entry.outputDevice);
+		}
 	}
+	for (FlowId flow : removed)
+	{
+		Erase(flow);
+	}
+	return removed.size();
 }
 
 void SDNFlowTable::PrintFlowStats() const 
 {
   std::cout << "=== SDN Flow Table Statistics ===\n";
-  for (const auto& flow : m_flowTable) 
+  for (FlowId flow = m_head; flow != kNoFlow; flow = m_meta[flow].next) 
   {
+    const FlowMatch& match = m_matches[flow];
+    const Ptr<NetDevice>& device = m_ports[match.outPort];
     std::cout << "Flow: " 
-              << flow.srcIp << ":" << flow.srcPort 
+              << Ipv4Address(match.srcIp) << ":" << match.srcPort 
               << " -> " 
-              << flow.dstIp << ":" << flow.dstPort 
-			  << " through port device " << flow.outputDevice->GetAddress()
-              << "\n  Packets: " << flow.packetCount 
-              << "\n  Bytes:   " << flow.byteCount 
+              << Ipv4Address(match.dstIp) << ":" << match.dstPort;
+    if (device)
+    {
+      std::cout << " through port device " << device->GetAddress();
+    }
+    std::cout << "\n  Packets: " << m_stats[flow].packetCount 
+              << "\n  Bytes:   " << m_stats[flow].byteCount 
               << std::endl;
   }
 }
 
 std::vector<FlowEntry> SDNFlowTable::GetAllEntries() const 
 {
-  	return m_flowTable;
+	std::vector<FlowEntry> entries;
+	entries.reserve(m_slots.size());
+	for (FlowId flow = m_head; flow != kNoFlow; flow = m_meta[flow].next)
+	{
+		entries.push_back(GetEntry(flow));
+	}
+  	return entries;
+}
+
+size_t SDNFlowTable::GetNEntries() const
+{
+	return m_slots.size();
+}
+
+size_t SDNFlowTable::GetNTuples() const
+{
+	return m_tuples.size();
+}
+
+uint32_t SDNFlowTable::GetMaxEntries() const
+{
+	return m_maxEntries;
+}
+
+uint64_t SDNFlowTable::GetNEvictions() const
+{
+	return m_evictions;
+}
+
+uint64_t SDNFlowTable::GetGeneration() const
+{
+	return m_generation;
+}
+
+void SDNFlowTable::SetLookupSimd(CuckooIndex::SimdLevel level)
+{
+	m_exactIndex.SetSimdLevel(level);
+}
+
+CuckooIndex::SimdLevel SDNFlowTable::GetLookupSimd() const
+{
+	return m_exactIndex.GetSimdLevel();
 }
 
 } // namespace sdn
@@ -2,43 +2,228 @@
 #define SDN_FLOW_TABLE_H
 
 #include <map>
+#include <functional>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include "ns3/ipv4-address.h"
 #include "ns3/net-device.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+#include "ns3/random-variable-stream.h"
+#include "sdn-timer-wheel.h"
+#include "sdn-flow-key.h"
+#include "sdn-cuckoo-index.h"
 
 
 namespace ns3 {
 namespace sdn {
 
+// A flow rule as installed and reported. The table does not keep FlowEntry objects; it splits
+// each rule into the compact per-id arrays described in SDNFlowTable.
 struct FlowEntry {
   Ipv4Address srcIp;
   Ipv4Address dstIp;
-  uint16_t srcPort;
-  uint16_t dstPort;
-  uint8_t protocol;
+
+  // Wildcard match fields; the defaults make the entry an exact 5-tuple match
+  Ipv4Mask srcMask = Ipv4Mask::GetOnes();   // Prefix applied to srcIp (GetZero() matches any source)
+  Ipv4Mask dstMask = Ipv4Mask::GetOnes();   // Prefix applied to dstIp
+  uint16_t srcPort = 0;
+  uint16_t dstPort = 0;
+  uint16_t srcPortMax = 0;                  // srcPort..srcPortMax is a port range when greater than srcPort
+  uint16_t dstPortMax = 0;                  // dstPort..dstPortMax is a port range when greater than dstPort
+  uint8_t protocol = 0;
+  bool anyProtocol = false;                 // Ignore protocol when matching
+  uint16_t priority = 0;                    // Highest priority wins when several entries match
+
+  // OpenFlow-style timeouts in seconds (0 = never)
+  uint16_t idleTimeout = 0;                 // Removed after this long without a matching packet
+  uint16_t hardTimeout = 0;                 // Removed this long after installation
+
   Ptr<NetDevice> outputDevice;
+
+  // Reported by the table; ignored on install except for the initial counters
   uint64_t packetCount = 0;
-  uint64_t byteCount;
+  uint64_t byteCount = 0;
+  Time installTime;
+  Time lastUsed;                            // Last matching packet
+};
+
+// Why a flow table dropped an entry on its own
+enum FlowRemovedReason {
+  IdleTimeoutExpired,
+  HardTimeoutExpired,
+  FlowEvicted           // Made room for a new entry in a full table
+};
+
+// Which parts of the 5-tuple an entry matches on. Entries sharing a mask share one hash table.
+struct FlowMask {
+  uint32_t srcMask;
+  uint32_t dstMask;
+  bool srcPortRange;
+  bool dstPortRange;
+  bool anyProtocol;
+
+  bool operator==(const FlowMask& other) const {
+    return srcMask == other.srcMask && dstMask == other.dstMask &&
+           srcPortRange == other.srcPortRange && dstPortRange == other.dstPortRange &&
+           anyProtocol == other.anyProtocol;
+  }
 };
 
 class SDNFlowTable : public Object
 {
 public:
+  // Which entry a full table drops to make room for a new one
+  enum EvictionPolicy {
+    Lru,      // Least recently matched
+    Lfu,      // Lowest packetCount among a few randomly sampled entries
+    Random    // Uniformly random entry
+  };
+
+  static TypeId GetTypeId();
   SDNFlowTable();
   ~SDNFlowTable();
 
-  FlowEntry* AddFlowEntry(const FlowEntry& entry);
+  // Called with the final state of every entry that times out, once it has been removed
+  typedef Callback<void, const FlowEntry&, FlowRemovedReason> FlowRemovedCallback;
+  void SetFlowRemovedCallback(FlowRemovedCallback callback);
+  // Resolution of timeout expiry; one scheduler event per tick while any timeout is pending
+  void SetTimeoutGranularity(Time granularity);
+
+  // Registers an output port; the returned index is the action stored with rules sent to it.
+  // Devices first seen as a rule's outputDevice are registered on the fly.
+  uint16_t AddPort(Ptr<NetDevice> device);
+  uint16_t GetNPorts() const;
+  const Ptr<NetDevice>& GetPort(uint16_t port) const;
+
+  FlowId AddFlowEntry(const FlowEntry& entry);
   bool RemoveFlowEntry(const FlowEntry& entry);
-  FlowEntry* FindMatchingFlow(const Ipv4Address& srcIp, const Ipv4Address& dstIp,
-                               uint16_t srcPort, uint16_t dstPort);
-  void UpdateFlowStats(FlowEntry* entry, uint64_t packets, uint64_t bytes);
+  FlowId FindMatchingFlow(const FlowKey& key);
+  FlowId FindMatchingFlow(const Ipv4Address& srcIp, const Ipv4Address& dstIp,
+                          uint16_t srcPort, uint16_t dstPort, uint8_t protocol);
+  // Burst lookup: flows[i] is FindMatchingFlow(keys[i]). Exact-match rules are probed for the
+  // whole burst at once through a SIMD signature index; only keys it cannot settle take the
+  // per-key tuple search.
+  void FindMatchingFlows(const FlowKey* keys, uint32_t count, FlowId* flows);
+  void UpdateFlowStats(FlowId flow, uint64_t packets, uint64_t bytes);
+  const Ptr<NetDevice>& GetOutputDevice(FlowId flow) const;
+  uint16_t GetOutputPort(FlowId flow) const;
+  FlowEntry GetEntry(FlowId flow) const;
+  // Visits every entry in insertion order; the visitor may change the action (outputDevice)
+  // and returns false to have the entry removed. Returns the number of entries removed.
+  uint32_t UpdateEntries(const std::function<bool(FlowEntry&)>& visitor);
   void PrintFlowStats() const;
   std::vector<FlowEntry> GetAllEntries() const;
+  size_t GetNEntries() const;
+  size_t GetNTuples() const;
+  uint32_t GetMaxEntries() const;
+  uint64_t GetNEvictions() const;
+  // Changes whenever a rule is added, overwritten or removed: FlowIds found before a change
+  // may have been freed and reused by another rule
+  uint64_t GetGeneration() const;
+  void SetLookupSimd(CuckooIndex::SimdLevel level);
+  CuckooIndex::SimdLevel GetLookupSimd() const;
+
+  static FlowKey MakeFlowKey(const FlowEntry& entry);
+  static FlowMask MakeFlowMask(const FlowEntry& entry);
+  static FlowKey ApplyMask(const FlowKey& key, const FlowMask& mask);
+  static bool IsExactMask(const FlowMask& mask);
   
 private:
-  std::vector<FlowEntry> m_flowTable;
-  
+  // Rules are stored as structure-of-arrays indexed by FlowId. A lookup reads the hash bucket
+  // and then only FlowMatch records (28 bytes, match key plus action); a hit also writes
+  // FlowStats. Everything else (masks, timers, bookkeeping) sits apart in FlowMeta.
+  struct FlowMatch {
+    uint32_t srcIp;
+    uint32_t dstIp;
+    uint16_t srcPort;
+    uint16_t srcPortMax;
+    uint16_t dstPort;
+    uint16_t dstPortMax;
+    uint16_t priority;
+    uint16_t outPort;          // Action: index into m_ports
+    uint8_t protocol;
+    uint8_t anyProtocol;
+    FlowId nextInBucket;       // Next rule with the same masked key, priority descending
+  };
+
+  struct FlowStats {
+    uint64_t packetCount;
+    uint64_t byteCount;
+    Time lastUsed;
+  };
+
+  struct FlowMeta {
+    uint32_t srcMask;
+    uint32_t dstMask;
+    Time installTime;
+    uint16_t idleTimeout;
+    uint16_t hardTimeout;
+    TimerWheel::TimerId timer;
+    uint32_t slot;             // Position in m_slots, kNoFlow while the id is free
+    FlowId prev;               // Table order: insertion, or recency under Lru
+    FlowId next;               // (also links the free list)
+  };
+
+  // Tuple-space search: one hash table per distinct mask, keyed on the masked 5-tuple.
+  // Each bucket is the head of a chain (FlowMatch::nextInBucket) of the rules sharing that key.
+  struct FlowTuple {
+    FlowMask mask;
+    uint16_t maxPriority;
+    std::unordered_map<FlowKey, FlowId, FlowKeyHash> buckets;
+  };
+
+  FlowTuple* FindTuple(const FlowMask& mask);
+  FlowTuple* GetOrCreateTuple(const FlowMask& mask);
+  void SortTuples();
+  FlowMask GetFlowMask(FlowId flow) const;
+  FlowKey GetFlowKey(FlowId flow) const;
+  bool IsSameRule(FlowId flow, const FlowEntry& entry) const;
+  FlowId FindRule(const FlowEntry& entry);
+  FlowId AllocateId();
+  void Erase(FlowId flow);
+  void LinkLast(FlowId flow);
+  void Unlink(FlowId flow);
+  void Touch(FlowId flow);
+
+  Time GetExpiry(FlowId flow, FlowRemovedReason& reason) const;
+  uint64_t ToTick(Time time) const;
+  void ArmTimer(FlowId flow);
+  void ExpireTimers();
+  FlowId SelectVictim();
+
+  std::vector<FlowMatch> m_matches;
+  std::vector<FlowStats> m_stats;
+  std::vector<FlowMeta> m_meta;
+  FlowId m_freeIds;                  // Free list through FlowMeta::next
+  FlowId m_head;                     // Oldest (least recently used) rule
+  FlowId m_tail;
+  std::vector<Ptr<NetDevice>> m_ports;
+  std::vector<std::unique_ptr<FlowTuple>> m_tuples;   // Sorted by maxPriority, highest first
+  // Mirrors the heads of the exact-match tuple's buckets (its highest-priority rule per key)
+  CuckooIndex m_exactIndex;
+
+  // Timeouts: one wheel timer per entry with a timeout, advanced by a single periodic event.
+  // An idle timer is not moved on every packet; when it fires early it is re-armed from lastUsed.
+  TimerWheel m_timers;
+  Time m_tickLength;
+  EventId m_tickEvent;
+  FlowRemovedCallback m_flowRemoved;
+  std::vector<uint32_t> m_expired;
+
+  // Capacity: with Lru, a matched rule moves to the tail of the table order, so the head is
+  // the victim; Lfu and Random pick from m_slots, a dense array of every live id.
+  // All of it is O(1) per lookup and per insert/remove.
+  uint32_t m_maxEntries;            // 0 = unbounded
+  EvictionPolicy m_evictionPolicy;
+  uint32_t m_evictionSamples;
+  uint64_t m_evictions;
+  uint64_t m_generation;
+  std::vector<FlowId> m_slots;
+  Ptr<UniformRandomVariable> m_random;
 };
 
 }
@@ -0,0 +1,123 @@
+#include "sdn-inband-control-channel.h"
+#include "sdn-control-header.h"
+#include "sdn-switch.h"
+#include "sdn-controller.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/point-to-point-helper.h"
+
+#include <string>
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNInBandControlChannel");
+
+// Point-to-point devices only frame IPv4 and IPv6. Neither end has an IP stack, and both
+// devices deliver straight to the channel, so the IPv4 number is free to carry control messages.
+static const uint16_t kControlProtocol = 0x0800;
+
+TypeId SDNInBandControlChannel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::sdn::SDNInBandControlChannel")
+        .SetParent<SDNControlChannel>()
+        .SetGroupName("SDN")
+        .AddConstructor<SDNInBandControlChannel>();
+    return tid;
+}
+
+SDNInBandControlChannel::SDNInBandControlChannel()
+{
+    NS_LOG_INFO("SDNInBandControlChannel created");
+}
+
+SDNInBandControlChannel::~SDNInBandControlChannel()
+{
+}
+
+NetDeviceContainer SDNInBandControlChannel::Install(Ptr<SDNSwitch> swtch, Ptr<Node> switchNode, Ptr<Node> controllerNode)
+{
+    PointToPointHelper link;
+    link.SetDeviceAttribute("DataRate", DataRateValue(m_dataRate));
+    link.SetChannelAttribute("Delay", TimeValue(m_delay));
+    link.SetQueue("ns3::DropTailQueue<Packet>", "MaxSize", StringValue(std::to_string(m_maxQueueSize) + "p"));
+    NetDeviceContainer devices = link.Install(switchNode, controllerNode);
+
+    m_switch = swtch;
+    m_switchEnd = devices.Get(0);
+    m_controllerEnd = devices.Get(1);
+    m_switchEnd->SetReceiveCallback(MakeCallback(&SDNInBandControlChannel::ReceiveFromController, this));
+    m_controllerEnd->SetReceiveCallback(MakeCallback(&SDNInBandControlChannel::ReceiveFromSwitch, this));
+    swtch->SetControlChannel(this);
+    return devices;
+}
+
+bool SDNInBandControlChannel::IsInBand() const
+{
+    return true;
+}
+
+bool SDNInBandControlChannel::IsLocal(Ptr<NetDevice> device)
+{
+    return device->GetNode()->GetSystemId() == Simulator::GetSystemId();
+}
+
+bool SDNInBandControlChannel::SendToController(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port)
+{
+    NS_ASSERT_MSG(swtch == m_switch, "SDNInBandControlChannel: Message from a switch the channel is not attached to");
+    return Send(m_switchEnd, ctrl, port);
+}
+
+bool SDNInBandControlChannel::SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl)
+{
+    NS_ASSERT_MSG(swtch == m_switch, "SDNInBandControlChannel: Message to a switch the channel is not attached to");
+    return Send(m_controllerEnd, ctrl, nullptr);
+}
+
+bool SDNInBandControlChannel::Send(Ptr<NetDevice> from, const controlPacket& ctrl, Ptr<NetDevice> port)
+{
+    // The rank simulating this end sends the message; every other rank's copy stays silent
+    if (!IsLocal(from)) return true;
+
+    bool up = from == m_switchEnd;
+    SDNControlHeader header(ctrl, up ? SDNControlHeader::ToController : SDNControlHeader::ToSwitch, m_switchEnd->GetNode());
+    header.SetPort(port);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+
+    Ptr<NetDevice> to = up ? m_controllerEnd : m_switchEnd;
+    if (!from->Send(packet, to->GetAddress(), kControlProtocol)) {
+        m_dropped++;
+        NS_LOG_WARN("SDNInBandControlChannel: Link queue full, dropping message type " << ctrl.type);
+        return false;
+    }
+    m_sent++;
+    m_bytesSent += packet->GetSize();
+    return true;
+}
+
+// Both ends decode into m_received, which keeps the capacity of its lists between messages.
+// The handlers get it by reference and are done with it when they return.
+
+bool SDNInBandControlChannel::ReceiveFromSwitch(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                                const Address& from)
+{
+    SDNControlHeader header(m_received, m_switchEnd->GetNode());
+    packet->PeekHeader(header);
+    m_switch->m_controller->HandlePacketIn(m_switch, &m_received, header.GetPort());
+    return true;
+}
+
+bool SDNInBandControlChannel::ReceiveFromController(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                                    const Address& from)
+{
+    SDNControlHeader header(m_received, m_switchEnd->GetNode());
+    packet->PeekHeader(header);
+    m_switch->HandleControlMessage(m_received);
+    return true;
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,53 @@
+#ifndef SDN_INBAND_CONTROL_CHANNEL_H
+#define SDN_INBAND_CONTROL_CHANNEL_H
+
+#include "ns3/node.h"
+#include "ns3/net-device-container.h"
+#include "sdn-control-channel.h"
+
+namespace ns3 {
+namespace sdn {
+
+// Control channel carried as real packets on a point-to-point link between a switch node and
+// the controller node. Messages are encoded as OpenFlow 1.0 by SDNControlHeader and queued by
+// the link's devices, so Delay, DataRate and MaxQueueSize configure the link itself, and
+// MessageSize and FlowModSize are unused: every message costs its encoded size.
+//
+// This is what lets a network run under ns-3's distributed simulator: when the switch and
+// the controller nodes have different system ids, the link becomes a remote channel and each
+// message crosses ranks as an MPI packet. The lookahead is the smallest delay of any link
+// between ranks, data links included, so a Delay above theirs does not raise it. Every rank
+// builds the whole network; each end only sends while its own node is simulated locally.
+//
+// One channel per switch. The link's devices are not switch ports.
+class SDNInBandControlChannel : public SDNControlChannel
+{
+public:
+    static TypeId GetTypeId();
+    SDNInBandControlChannel();
+    virtual ~SDNInBandControlChannel();
+
+    // Links switchNode to controllerNode and attaches the channel to swtch; returns the
+    // devices, switch end first
+    NetDeviceContainer Install(Ptr<SDNSwitch> swtch, Ptr<Node> switchNode, Ptr<Node> controllerNode);
+
+    bool SendToController(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port) override;
+    bool SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl) override;
+    bool IsInBand() const override;
+
+private:
+    bool Send(Ptr<NetDevice> from, const controlPacket& ctrl, Ptr<NetDevice> port);
+    static bool IsLocal(Ptr<NetDevice> device);
+    bool ReceiveFromSwitch(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address& from);
+    bool ReceiveFromController(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address& from);
+
+    Ptr<SDNSwitch> m_switch;
+    Ptr<NetDevice> m_switchEnd;
+    Ptr<NetDevice> m_controllerEnd;
+    controlPacket m_received;      // Decoding target of both ends
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_INBAND_CONTROL_CHANNEL_H
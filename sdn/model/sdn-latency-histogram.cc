@@ -0,0 +1,76 @@
+#include "sdn-latency-histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace sdn {
+
+LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+void LatencyHistogram::Reset()
+{
+    std::fill(m_buckets, m_buckets + kBuckets, 0);
+    m_count = 0;
+    m_sumNs = 0;
+    m_maxNs = 0;
+}
+
+void LatencyHistogram::Add(Time value)
+{
+    int64_t ns = std::max<int64_t>(value.GetNanoSeconds(), 0);
+    uint32_t bucket = ns == 0 ? 0 : 64 - __builtin_clzll(static_cast<uint64_t>(ns));
+    m_buckets[std::min(bucket, kBuckets - 1)]++;
+    m_count++;
+    m_sumNs += ns;
+    m_maxNs = std::max(m_maxNs, ns);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other)
+{
+    for (uint32_t bucket = 0; bucket < kBuckets; bucket++) {
+        m_buckets[bucket] += other.m_buckets[bucket];
+    }
+    m_count += other.m_count;
+    m_sumNs += other.m_sumNs;
+    m_maxNs = std::max(m_maxNs, other.m_maxNs);
+}
+
+Time LatencyHistogram::GetBucketLimit(uint32_t bucket)
+{
+    if (bucket == 0) return NanoSeconds(0);
+    if (bucket >= kBuckets - 1) return Time::Max();
+    return NanoSeconds((uint64_t(1) << bucket) - 1);
+}
+
+Time LatencyHistogram::GetMean() const
+{
+    return m_count == 0 ? NanoSeconds(0) : NanoSeconds(m_sumNs / m_count);
+}
+
+Time LatencyHistogram::GetMax() const
+{
+    return NanoSeconds(m_maxNs);
+}
+
+Time LatencyHistogram::GetQuantile(double q) const
+{
+    if (m_count == 0) return NanoSeconds(0);
+
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * m_count)));
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < kBuckets; bucket++) {
+        seen += m_buckets[bucket];
+        if (seen >= rank) {
+            // The recorded maximum is a tighter bound for the top bucket in use
+            return std::min(GetBucketLimit(bucket), GetMax());
+        }
+    }
+    return GetMax();
+}
+
+} // namespace sdn
+} // namespace ns3
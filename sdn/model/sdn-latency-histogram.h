@@ -0,0 +1,47 @@
+#ifndef SDN_LATENCY_HISTOGRAM_H
+#define SDN_LATENCY_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+
+#include <cstdint>
+
+namespace ns3 {
+namespace sdn {
+
+// Histogram of durations over fixed power-of-two nanosecond buckets: bucket 0 holds 0 ns,
+// bucket b holds [2^(b-1), 2^b) ns, and the last bucket everything from 2^46 ns (about 19.5
+// hours) up. Add is a bit scan and three increments; nothing is ever allocated, so it can sit
+// on the datapath. Quantiles are reported as the upper bound of the bucket they fall in.
+class LatencyHistogram
+{
+public:
+    static constexpr uint32_t kBuckets = 48;
+
+    LatencyHistogram();
+
+    void Add(Time value);
+    // Adds every sample of 'other' (across switches, say)
+    void Merge(const LatencyHistogram& other);
+    void Reset();
+
+    uint64_t GetCount() const { return m_count; }
+    uint64_t GetBucketCount(uint32_t bucket) const { return m_buckets[bucket]; }
+    // Largest duration bucket 'bucket' can hold
+    static Time GetBucketLimit(uint32_t bucket);
+
+    Time GetMean() const;
+    Time GetMax() const;
+    // Upper bound of the bucket holding the q-quantile (0 <= q <= 1); zero when empty
+    Time GetQuantile(double q) const;
+
+private:
+    uint64_t m_buckets[kBuckets];
+    uint64_t m_count;
+    int64_t m_sumNs;
+    int64_t m_maxNs;
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_LATENCY_HISTOGRAM_H
@@ -0,0 +1,185 @@
+#include "sdn-lpm-table.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace sdn {
+
+LpmTable::LpmTable()
+    : m_rules(33),
+      m_nPrefixes(0)
+{
+    Clear();
+}
+
+void LpmTable::Clear()
+{
+    m_tbl16.assign(1u << 16, Entry{kMaxValue, 0, 0});
+    m_groups.clear();
+    m_freeGroups.clear();
+    for (auto& rules : m_rules) {
+        rules.clear();
+    }
+    m_nPrefixes = 0;
+}
+
+uint32_t LpmTable::Mask(uint8_t length)
+{
+    return length == 0 ? 0 : 0xffffffffu << (32 - length);
+}
+
+// Turns a plain slot into a group of 256 copies of it, so part of its range can differ
+uint32_t LpmTable::Expand(bool top, uint32_t index)
+{
+    Entry fill = Slot(top, index);
+    if (fill.group) return fill.value * kGroupSize;
+
+    uint32_t group;
+    if (!m_freeGroups.empty()) {
+        group = m_freeGroups.back();
+        m_freeGroups.pop_back();
+    } else {
+        group = m_groups.size() / kGroupSize;
+        m_groups.resize(m_groups.size() + kGroupSize);
+    }
+    std::fill(m_groups.begin() + group * kGroupSize, m_groups.begin() + (group + 1) * kGroupSize, fill);
+    Slot(top, index) = Entry{group, 0, 1};   // Re-fetched: the resize may have moved m_groups
+    return group * kGroupSize;
+}
+
+// Folds a group whose slots all agree back into its parent slot
+void LpmTable::Collapse(bool top, uint32_t index)
+{
+    Entry entry = Slot(top, index);
+    if (!entry.group) return;
+
+    uint32_t base = entry.value * kGroupSize;
+    const Entry& first = m_groups[base];
+    if (first.group) return;
+    for (uint32_t i = 1; i < kGroupSize; i++) {
+        const Entry& other = m_groups[base + i];
+        if (other.group || other.value != first.value || other.depth != first.depth) return;
+    }
+    Slot(top, index) = first;
+    m_freeGroups.push_back(entry.value);
+}
+
+void LpmTable::Write(bool top, uint32_t index, uint32_t value, uint8_t depth)
+{
+    Entry& entry = Slot(top, index);
+    if (entry.group) {
+        uint32_t base = entry.value * kGroupSize;
+        for (uint32_t i = 0; i < kGroupSize; i++) {
+            Write(false, base + i, value, depth);
+        }
+    } else if (entry.depth <= depth) {
+        entry.value = value;
+        entry.depth = depth;
+    }
+}
+
+void LpmTable::Restore(bool top, uint32_t index, uint8_t removed, uint32_t value, uint8_t depth)
+{
+    Entry& entry = Slot(top, index);
+    if (entry.group) {
+        uint32_t base = entry.value * kGroupSize;
+        for (uint32_t i = 0; i < kGroupSize; i++) {
+            Restore(false, base + i, removed, value, depth);
+        }
+        Collapse(top, index);
+    } else if (entry.depth == removed) {
+        // Within the removed prefix's range, only that prefix writes slots of its length
+        entry.value = value;
+        entry.depth = depth;
+    }
+}
+
+// Visits the slots covering prefix/length, at the level where the length ends, and either
+// writes the new prefix into them or replaces the removed one with (value, depth)
+void LpmTable::Apply(uint32_t prefix, uint8_t length, bool insert, uint32_t value, uint8_t depth)
+{
+    uint32_t path[2];
+    uint32_t levels = length <= 16 ? 0 : (length <= 24 ? 1 : 2);
+    uint32_t first;
+    uint32_t count;
+    if (levels == 0) {
+        first = prefix >> 16;
+        count = 1u << (16 - length);
+    } else {
+        path[0] = prefix >> 16;
+        uint32_t base = Expand(true, path[0]);
+        if (levels == 1) {
+            first = base + ((prefix >> 8) & 0xff);
+            count = 1u << (24 - length);
+        } else {
+            path[1] = base + ((prefix >> 8) & 0xff);
+            base = Expand(false, path[1]);
+            first = base + (prefix & 0xff);
+            count = 1u << (32 - length);
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (insert) {
+            Write(levels == 0, first + i, value, depth);
+        } else {
+            Restore(levels == 0, first + i, length, value, depth);
+        }
+    }
+    if (!insert) {
+        for (uint32_t level = levels; level > 0; level--) {
+            Collapse(level == 1, path[level - 1]);
+        }
+    }
+}
+
+void LpmTable::Insert(uint32_t prefix, uint8_t length, uint32_t value)
+{
+    NS_ASSERT_MSG(length <= 32 && value < kMaxValue, "LpmTable: Bad prefix length or value");
+    prefix &= Mask(length);
+    auto inserted = m_rules[length].emplace(prefix, value);
+    if (inserted.second) {
+        m_nPrefixes++;
+    } else {
+        inserted.first->second = value;
+    }
+    Apply(prefix, length, true, value, length);
+}
+
+bool LpmTable::Remove(uint32_t prefix, uint8_t length)
+{
+    prefix &= Mask(length);
+    if (m_rules[length].erase(prefix) == 0) return false;
+    m_nPrefixes--;
+
+    // The slots fall back to the longest remaining prefix that covers this one
+    uint32_t value = kMaxValue;
+    uint8_t depth = 0;
+    for (int shorter = length - 1; shorter >= 0; shorter--) {
+        auto covering = m_rules[shorter].find(prefix & Mask(shorter));
+        if (covering != m_rules[shorter].end()) {
+            value = covering->second;
+            depth = shorter;
+            break;
+        }
+    }
+    Apply(prefix, length, false, value, depth);
+    return true;
+}
+
+uint32_t LpmTable::Lookup(uint32_t address) const
+{
+    Entry entry = m_tbl16[address >> 16];
+    if (entry.group) {
+        entry = m_groups[entry.value * kGroupSize + ((address >> 8) & 0xff)];
+        if (entry.group) {
+            entry = m_groups[entry.value * kGroupSize + (address & 0xff)];
+        }
+    }
+    return entry.value == kMaxValue ? kNoMatch : entry.value;
+}
+
+} // namespace sdn
+} // namespace ns3
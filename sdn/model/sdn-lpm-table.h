@@ -0,0 +1,65 @@
+#ifndef SDN_LPM_TABLE_H
+#define SDN_LPM_TABLE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+namespace sdn {
+
+// Longest-prefix-match table for IPv4, DIR-16-8-8 layout.
+// The first 16 address bits index a 64K-entry array directly; a slot covered by a prefix
+// longer than /16 instead points to a group of 256 entries for the next 8 bits, and a group
+// slot covered by a prefix longer than /24 to a group for the last 8. A lookup is at most
+// three dependent reads whatever the number of prefixes. Every slot records the length of
+// the prefix that wrote it, so a shorter prefix never overwrites a longer one and a removed
+// prefix is replaced by the longest remaining one that covers it.
+class LpmTable
+{
+public:
+    static constexpr uint32_t kNoMatch = 0xffffffffu;
+    static constexpr uint32_t kMaxValue = 0xffffffu;
+
+    LpmTable();
+
+    // Maps prefix/length to value (below kMaxValue), replacing the value of an existing identical prefix
+    void Insert(uint32_t prefix, uint8_t length, uint32_t value);
+    bool Remove(uint32_t prefix, uint8_t length);
+    // Value of the longest prefix containing address, kNoMatch if none does
+    uint32_t Lookup(uint32_t address) const;
+    void Clear();
+
+    uint32_t GetNPrefixes() const { return m_nPrefixes; }
+    uint32_t GetNGroups() const { return m_groups.size() / kGroupSize - m_freeGroups.size(); }
+
+private:
+    static constexpr uint32_t kGroupSize = 256;
+
+    // Four bytes per slot
+    struct Entry {
+        uint32_t value : 24;   // Group index when 'group' is set; kMaxValue in an empty slot
+        uint32_t depth : 6;    // Length of the prefix that wrote this slot
+        uint32_t group : 1;
+    };
+
+    static uint32_t Mask(uint8_t length);
+    // Slots are addressed as (top, index): m_tbl16[index] or m_groups[index]
+    Entry& Slot(bool top, uint32_t index) { return top ? m_tbl16[index] : m_groups[index]; }
+    uint32_t Expand(bool top, uint32_t index);
+    void Collapse(bool top, uint32_t index);
+    void Write(bool top, uint32_t index, uint32_t value, uint8_t depth);
+    void Restore(bool top, uint32_t index, uint8_t removed, uint32_t value, uint8_t depth);
+    void Apply(uint32_t prefix, uint8_t length, bool insert, uint32_t value, uint8_t depth);
+
+    std::vector<Entry> m_tbl16;
+    std::vector<Entry> m_groups;            // kGroupSize entries per group
+    std::vector<uint32_t> m_freeGroups;
+    std::vector<std::unordered_map<uint32_t, uint32_t>> m_rules;   // Per length: prefix -> value
+    uint32_t m_nPrefixes;
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_LPM_TABLE_H
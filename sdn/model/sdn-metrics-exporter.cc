@@ -0,0 +1,185 @@
+#include "sdn-metrics-exporter.h"
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNMetricsExporter");
+
+TypeId SDNMetricsExporter::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::sdn::SDNMetricsExporter")
+        .SetParent<Object>()
+        .SetGroupName("SDN")
+        .AddConstructor<SDNMetricsExporter>()
+        .AddAttribute("Interval",
+                      "Simulated time between samples",
+                      TimeValue(Seconds(1)),
+                      MakeTimeAccessor(&SDNMetricsExporter::m_interval),
+                      MakeTimeChecker())
+        .AddAttribute("FileName",
+                      "File the samples are written to (truncated by Start)",
+                      StringValue("sdn-metrics.csv"),
+                      MakeStringAccessor(&SDNMetricsExporter::m_fileName),
+                      MakeStringChecker())
+        .AddAttribute("Format",
+                      "Csv (time,source,metric,value rows) or Json (one object per source and sample)",
+                      EnumValue(SDNMetricsExporter::Csv),
+                      MakeEnumAccessor<Format>(&SDNMetricsExporter::m_format),
+                      MakeEnumChecker(SDNMetricsExporter::Csv, "Csv",
+                                      SDNMetricsExporter::Json, "Json"));
+    return tid;
+}
+
+SDNMetricsExporter::SDNMetricsExporter()
+    : m_interval(Seconds(1)),
+      m_fileName("sdn-metrics.csv"),
+      m_format(Csv)
+{
+}
+
+SDNMetricsExporter::~SDNMetricsExporter()
+{
+}
+
+void SDNMetricsExporter::DoDispose()
+{
+    m_event.Cancel();
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_switches.clear();
+    m_controllers.clear();
+    m_channels.clear();
+    Object::DoDispose();
+}
+
+void SDNMetricsExporter::AddSwitch(Ptr<SDNSwitch> swtch, const std::string& name)
+{
+    m_switches.push_back(std::make_pair(name.empty() ? "switch" + std::to_string(m_switches.size()) : name, swtch));
+}
+
+void SDNMetricsExporter::AddController(Ptr<SDNController> controller, const std::string& name)
+{
+    m_controllers.push_back(
+        std::make_pair(name.empty() ? "controller" + std::to_string(m_controllers.size()) : name, controller));
+}
+
+void SDNMetricsExporter::AddControlChannel(Ptr<SDNControlChannel> channel, const std::string& name)
+{
+    m_channels.push_back(std::make_pair(name.empty() ? "channel" + std::to_string(m_channels.size()) : name, channel));
+}
+
+void SDNMetricsExporter::Start()
+{
+    m_event.Cancel();
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_file.open(m_fileName, std::ios::out | std::ios::trunc);
+    if (!m_file) {
+        NS_LOG_WARN("SDNMetricsExporter: Cannot open " << m_fileName);
+        return;
+    }
+    if (m_format == Csv) {
+        m_file << "time,source,metric,value\n";
+    }
+    Tick();
+}
+
+void SDNMetricsExporter::Stop()
+{
+    m_event.Cancel();
+    if (!m_file.is_open()) return;
+    Sample();
+    m_file.close();
+}
+
+void SDNMetricsExporter::Tick()
+{
+    Sample();
+    if (m_interval.IsStrictlyPositive()) {
+        m_event = Simulator::Schedule(m_interval, &SDNMetricsExporter::Tick, this);
+    }
+}
+
+void SDNMetricsExporter::AddHistogram(Metrics& metrics, const std::string& name, const LatencyHistogram& histogram)
+{
+    metrics.emplace_back(name + "Count", histogram.GetCount());
+    metrics.emplace_back(name + "MeanNs", histogram.GetMean().GetNanoSeconds());
+    metrics.emplace_back(name + "P50Ns", histogram.GetQuantile(0.5).GetNanoSeconds());
+    metrics.emplace_back(name + "P99Ns", histogram.GetQuantile(0.99).GetNanoSeconds());
+    metrics.emplace_back(name + "MaxNs", histogram.GetMax().GetNanoSeconds());
+}
+
+void SDNMetricsExporter::Sample()
+{
+    if (!m_file.is_open()) return;
+
+    for (const auto& entry : m_switches) {
+        const Ptr<SDNSwitch>& swtch = entry.second;
+        m_metrics.clear();
+        m_metrics.emplace_back("lookups", swtch->GetNLookups());
+        m_metrics.emplace_back("hits", swtch->GetNHits());
+        m_metrics.emplace_back("misses", swtch->GetNMisses());
+        m_metrics.emplace_back("packetIns", swtch->GetNPacketIns());
+        m_metrics.emplace_back("flowInstalls", swtch->GetNFlowInstalls());
+        m_metrics.emplace_back("evictions", swtch->GetNEvictions());
+        m_metrics.emplace_back("flows", swtch->GetFlowTable() ? swtch->GetFlowTable()->GetNEntries() : 0);
+        m_metrics.emplace_back("bufferedPackets", swtch->GetNBufferedPackets());
+        m_metrics.emplace_back("missDrops", swtch->GetNMissDrops());
+        m_metrics.emplace_back("arpCacheHits", swtch->GetNArpCacheHits());
+        AddHistogram(m_metrics, "flowSetup", swtch->GetFlowSetupLatency());
+        for (uint16_t port = 0; port < swtch->GetNPorts(); port++) {
+            std::string prefix = "port" + std::to_string(port);
+            m_metrics.emplace_back(prefix + ".txPackets", swtch->GetPortTxPackets(port));
+            m_metrics.emplace_back(prefix + ".txBytes", swtch->GetPortTxBytes(port));
+        }
+        Write(entry.first, m_metrics);
+    }
+
+    for (const auto& entry : m_controllers) {
+        const Ptr<SDNController>& controller = entry.second;
+        m_metrics.clear();
+        m_metrics.emplace_back("packetIns", controller->GetNPacketIns());
+        m_metrics.emplace_back("flowMods", controller->GetNFlowMods());
+        m_metrics.emplace_back("arpRequests", controller->GetNArpRequests());
+        m_metrics.emplace_back("arpMisses", controller->GetNArpMisses());
+        m_metrics.emplace_back("flowsRerouted", controller->GetNFlowsRerouted());
+        AddHistogram(m_metrics, "batchDelay", controller->GetBatchDelay());
+        Write(entry.first, m_metrics);
+    }
+
+    for (const auto& entry : m_channels) {
+        m_metrics.clear();
+        m_metrics.emplace_back("sent", entry.second->GetNSent());
+        m_metrics.emplace_back("dropped", entry.second->GetNDropped());
+        m_metrics.emplace_back("bytes", entry.second->GetNBytesSent());
+        Write(entry.first, m_metrics);
+    }
+    m_file.flush();
+}
+
+void SDNMetricsExporter::Write(const std::string& source, const Metrics& metrics)
+{
+    double now = Simulator::Now().GetSeconds();
+    if (m_format == Csv) {
+        for (const auto& metric : metrics) {
+            m_file << now << ',' << source << ',' << metric.first << ',' << metric.second << '\n';
+        }
+        return;
+    }
+
+    // Source and metric names are generated or chosen by the script, so they need no escaping
+    m_file << "{\"time\":" << now << ",\"source\":\"" << source << '"';
+    for (const auto& metric : metrics) {
+        m_file << ",\"" << metric.first << "\":" << metric.second;
+    }
+    m_file << "}\n";
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,74 @@
+#ifndef SDN_METRICS_EXPORTER_H
+#define SDN_METRICS_EXPORTER_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "sdn-switch.h"
+#include "sdn-controller.h"
+#include "sdn-control-channel.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace sdn {
+
+// Samples the counters and histograms of registered switches, controllers and control
+// channels every Interval of simulated time and appends them to a file. The datapath only
+// increments plain counters; everything here runs in the sampling event.
+//
+// Csv writes one row per metric: time,source,metric,value. Json writes one object per
+// source and sample, one per line: {"time":..,"source":"..",<metric>:<value>,...}.
+// Counters are cumulative; latencies are in nanoseconds.
+class SDNMetricsExporter : public Object
+{
+public:
+    enum Format {
+        Csv,
+        Json
+    };
+
+    static TypeId GetTypeId();
+    SDNMetricsExporter();
+    virtual ~SDNMetricsExporter();
+
+    // An empty name becomes "switch<N>" / "controller<N>" / "channel<N>" in registration order
+    void AddSwitch(Ptr<SDNSwitch> swtch, const std::string& name = "");
+    void AddController(Ptr<SDNController> controller, const std::string& name = "");
+    void AddControlChannel(Ptr<SDNControlChannel> channel, const std::string& name = "");
+
+    // Opens FileName and samples at Now, then every Interval until Stop
+    void Start();
+    // Takes a last sample and closes the file
+    void Stop();
+    void Sample();
+
+protected:
+    virtual void DoDispose() override;
+
+private:
+    typedef std::vector<std::pair<std::string, uint64_t>> Metrics;
+
+    void Tick();
+    void Write(const std::string& source, const Metrics& metrics);
+    static void AddHistogram(Metrics& metrics, const std::string& name, const LatencyHistogram& histogram);
+
+    Time m_interval;
+    std::string m_fileName;
+    Format m_format;
+    std::ofstream m_file;
+    EventId m_event;
+
+    std::vector<std::pair<std::string, Ptr<SDNSwitch>>> m_switches;
+    std::vector<std::pair<std::string, Ptr<SDNController>>> m_controllers;
+    std::vector<std::pair<std::string, Ptr<SDNControlChannel>>> m_channels;
+    Metrics m_metrics;    // Reused by every source and sample
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_METRICS_EXPORTER_H
@@ -1,5 +1,9 @@
 #include "sdn-switch.h"
 #include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
 
 namespace ns3 {
 namespace sdn {
@@ -11,41 +15,242 @@ TypeId SDNSwitch::GetTypeId(void)
 	static TypeId tid = TypeId("ns3::sdn::SDNSwitch")
 		.SetParent<Object>()
 		.SetGroupName("SDN")
-		.AddConstructor<SDNSwitch>();
+		.AddConstructor<SDNSwitch>()
+		.AddAttribute("FlowTimeoutGranularity",
+					  "Resolution of flow idle/hard timeout expiry in the switch's flow table",
+					  TimeValue(MilliSeconds(100)),
+					  MakeTimeAccessor(&SDNSwitch::m_timeoutGranularity),
+					  MakeTimeChecker())
+		.AddAttribute("MissBufferSize",
+					  "Packets held while waiting for FlowAdds over a control channel; further misses are dropped",
+					  UintegerValue(1024),
+					  MakeUintegerAccessor(&SDNSwitch::m_missBufferSize),
+					  MakeUintegerChecker<uint32_t>())
+		.AddAttribute("PacketInRetry",
+					  "A pending flow whose FlowAdd has not arrived after this long raises a new PacketIn on its next packet, "
+					  "or has its buffered packets dropped if none comes; an ARP request unanswered this long is forgotten "
+					  "(the host asks again)",
+					  TimeValue(Seconds(1)),
+					  MakeTimeAccessor(&SDNSwitch::m_packetInRetry),
+					  MakeTimeChecker())
+		.AddAttribute("LookupBurst",
+					  "IPv4 packets arriving at the same instant are looked up together, up to this many at a time (1 = one by one)",
+					  UintegerValue(32),
+					  MakeUintegerAccessor(&SDNSwitch::m_lookupBurst),
+					  MakeUintegerChecker<uint32_t>(1))
+		.AddAttribute("ArpCache",
+					  "Answer ARP requests from the bindings the controller pushes, without a PacketIn (see the controller's ArpCachePush)",
+					  BooleanValue(true),
+					  MakeBooleanAccessor(&SDNSwitch::m_arpCacheEnabled),
+					  MakeBooleanChecker())
+		.AddAttribute("NLookups",
+					  "IPv4 flow table lookups made by the datapath",
+					  TypeId::ATTR_GET,
+					  UintegerValue(0),
+					  MakeUintegerAccessor(&SDNSwitch::GetNLookups),
+					  MakeUintegerChecker<uint64_t>())
+		.AddAttribute("NHits",
+					  "Lookups that matched a flow rule",
+					  TypeId::ATTR_GET,
+					  UintegerValue(0),
+					  MakeUintegerAccessor(&SDNSwitch::GetNHits),
+					  MakeUintegerChecker<uint64_t>())
+		.AddAttribute("NMisses",
+					  "Lookups that matched no flow rule",
+					  TypeId::ATTR_GET,
+					  UintegerValue(0),
+					  MakeUintegerAccessor(&SDNSwitch::GetNMisses),
+					  MakeUintegerChecker<uint64_t>())
+		.AddAttribute("NPacketIns",
+					  "Flow misses and ARP requests sent to the controller",
+					  TypeId::ATTR_GET,
+					  UintegerValue(0),
+					  MakeUintegerAccessor(&SDNSwitch::GetNPacketIns),
+					  MakeUintegerChecker<uint64_t>())
+		.AddAttribute("NFlowInstalls",
+					  "Flow rules installed in the switch's flow table",
+					  TypeId::ATTR_GET,
+					  UintegerValue(0),
+					  MakeUintegerAccessor(&SDNSwitch::GetNFlowInstalls),
+					  MakeUintegerChecker<uint64_t>())
+		.AddTraceSource("PacketIn",
+						"A flow miss or ARP request is sent to the controller",
+						MakeTraceSourceAccessor(&SDNSwitch::m_packetInTrace),
+						"ns3::sdn::SDNSwitch::PacketInTracedCallback")
+		.AddTraceSource("FlowInstalled",
+						"A flow rule was added to the flow table",
+						MakeTraceSourceAccessor(&SDNSwitch::m_flowInstalledTrace),
+						"ns3::sdn::SDNSwitch::FlowInstalledTracedCallback")
+		.AddTraceSource("FlowSetup",
+						"A pending flow's FlowAdd arrived; reports the time since its first miss",
+						MakeTraceSourceAccessor(&SDNSwitch::m_flowSetupTrace),
+						"ns3::Time::TracedCallback");
 	return tid;
 }
 
 SDNSwitch::SDNSwitch() 
+	: m_nextXid(0),
+	  m_nextBufferId(0),
+	  m_bufferedPackets(0),
+	  m_missBufferSize(1024),
+	  m_missDrops(0),
+	  m_arpCacheEnabled(true),
+	  m_arpCacheHits(0),
+	  m_lookupBurst(32),
+	  m_lookups(0),
+	  m_hits(0),
+	  m_misses(0),
+	  m_packetIns(0),
+	  m_flowInstalls(0)
 {
 	NS_LOG_INFO("SDNSwitch: SDNSwitch created");
 }
 
 SDNSwitch::~SDNSwitch() 
 {
+	m_burstEvent.Cancel();
 	NS_LOG_INFO("SDNSwitch: Custom SDNSwitch destroyed");
 }
 
 void SDNSwitch::SetFlowTable(Ptr<SDNFlowTable> table)
 {
 	m_flowTable = table;
+	for (const auto& device : m_devices)
+	{
+		m_flowTable->AddPort(device);
+	}
+	m_flowTable->SetTimeoutGranularity(m_timeoutGranularity);
+	m_flowTable->SetFlowRemovedCallback(MakeCallback(&SDNSwitch::NotifyFlowRemoved, this));
+}
+
+Ptr<SDNFlowTable> SDNSwitch::GetFlowTable() const
+{
+	return m_flowTable;
+}
+
+void SDNSwitch::SetControlChannel(Ptr<SDNControlChannel> channel)
+{
+	m_channel = channel;
+}
+
+Ptr<SDNControlChannel> SDNSwitch::GetControlChannel() const
+{
+	return m_channel;
+}
+
+// Synchronously, the controller fills in its answer before this returns; over a channel
+// the message gets a fresh xid and the answer comes back later through HandleControlMessage.
+// Returns false if the channel dropped the message.
+bool SDNSwitch::SendToController(controlPacket& ctrl, Ptr<NetDevice> port)
+{
+	if (ctrl.type == FlowAdd || (ctrl.type == ARPPacket && !ctrl.arpReply))
+	{
+		m_packetIns++;
+		m_packetInTrace(ctrl);
+	}
+	if (!m_channel)
+	{
+		m_controller->HandlePacketIn(this, &ctrl, port);
+		return true;
+	}
+	ctrl.xid = m_nextXid++;
+	return m_channel->SendToController(this, ctrl, port);
+}
+
+void SDNSwitch::SendArpReply(Ptr<NetDevice> device, const controlPacket& ctrl, const Address& senderMac)
+{
+	ArpHeader replyArp;
+	replyArp.SetReply(ctrl.dstMac, ctrl.dstIp, ctrl.srcMac, ctrl.srcIp);
+	EthernetHeader ethHeader;
+	ethHeader.SetSource(Mac48Address::ConvertFrom(ctrl.dstMac));
+	ethHeader.SetDestination(Mac48Address::ConvertFrom(ctrl.srcMac));
+	ethHeader.SetLengthType(0x0806);
+
+	Ptr<Packet> replyPacket = Create<Packet>();
+	replyPacket->AddHeader(ethHeader);
+	replyPacket->AddHeader(replyArp);
+	
+	device->Send(replyPacket, senderMac, 0x0806);
+	NS_LOG_INFO("SDNSwitch: ARP Reply (" << ctrl.dstMac << ") sent to " << ctrl.srcIp << " for target " << ctrl.dstIp);
+}
+
+void SDNSwitch::ExpireArpRequest(uint32_t xid)
+{
+	if (m_pending.erase(xid))
+	{
+		NS_LOG_INFO("SDNSwitch: No answer to ARP request " << xid << ", forgotten");
+	}
+}
+
+void SDNSwitch::ReportArpReply(Ptr<const Packet> packet, Ptr<NetDevice> device)
+{
+	ArpHeader arpHeader;
+	if (!m_controller || !packet->PeekHeader(arpHeader) || !arpHeader.IsReply())
+	{
+		return;
+	}
+	controlPacket ctrl;
+	ctrl.type = ARPPacket;
+	ctrl.arpReply = true;
+	ctrl.srcIp = arpHeader.GetSourceIpv4Address();
+	ctrl.srcMac = arpHeader.GetSourceHardwareAddress();
+	SendToController(ctrl, device);
 }
 
 void SDNSwitch::AddDevice(Ptr<NetDevice> device) {
     m_devices.push_back(device);
+	if (m_flowTable)
+	{
+		m_flowTable->AddPort(device);
+	}
 	device->SetPromiscReceiveCallback(MakeCallback(&SDNSwitch::ReceivePacket, this));
 }
 
-controlPacket SDNSwitch::GenerateControlPacket(Ptr<Packet> packet, controlType type)
+// Reads the 5-tuple straight out of the packet buffer: one CopyData into a stack buffer,
+// no packet copies and no header objects. Non TCP/UDP packets get ports 0.
+bool SDNSwitch::ExtractFlowKey(Ptr<const Packet> packet, FlowKey& key)
+{
+	// Largest IPv4 header (60 bytes) plus the two L4 port fields
+	uint8_t buf[64];
+	uint32_t len = packet->CopyData(buf, sizeof(buf));
+	if (len < 20 || (buf[0] >> 4) != 4)
+	{
+		return false;
+	}
+	uint32_t ihl = (buf[0] & 0x0f) * 4u;
+	if (ihl < 20 || len < ihl)
+	{
+		return false;
+	}
+
+	key.protocol = buf[9];
+	key.srcIp = (uint32_t(buf[12]) << 24) | (uint32_t(buf[13]) << 16) | (uint32_t(buf[14]) << 8) | buf[15];
+	key.dstIp = (uint32_t(buf[16]) << 24) | (uint32_t(buf[17]) << 16) | (uint32_t(buf[18]) << 8) | buf[19];
+	key.srcPort = 0;
+	key.dstPort = 0;
+
+	if (key.protocol == 6 || key.protocol == 17) // TCP, UDP
+	{
+		if (len < ihl + 4)
+		{
+			return false;
+		}
+		key.srcPort = static_cast<uint16_t>((buf[ihl] << 8) | buf[ihl + 1]);
+		key.dstPort = static_cast<uint16_t>((buf[ihl + 2] << 8) | buf[ihl + 3]);
+	}
+	return true;
+}
+
+controlPacket SDNSwitch::GenerateControlPacket(Ptr<const Packet> packet, controlType type)
 {
 	controlPacket ctrl;
+	ctrl.type = Error;
 	if (type == ARPPacket)
 	{
-		Ptr<Packet> copy = packet->Copy();
 		ArpHeader arpHeader;
-		if (!copy->RemoveHeader(arpHeader))
+		if (!packet->PeekHeader(arpHeader))
 		{
-			NS_LOG_WARN("SDNSwitch: Failed to remove ARP header");
-			ctrl.type = Error;
+			NS_LOG_WARN("SDNSwitch: Failed to read ARP header");
 			return ctrl;
 		}
 		if (arpHeader.IsRequest())
@@ -57,57 +262,31 @@ controlPacket SDNSwitch::GenerateControlPacket(Ptr<Packet> packet, controlType t
 	}
 	else if (type == FlowAdd)
 	{
-		Ipv4Header ipv4Header;
-		if (!packet->RemoveHeader(ipv4Header))
+		FlowKey key;
+		if (!ExtractFlowKey(packet, key))
 		{
-			NS_LOG_WARN("SDNSwitch: Failed to remove IPv4 header");
-			ctrl.type = Error;
+			NS_LOG_WARN("SDNSwitch: Failed to parse IPv4 5-tuple");
 			return ctrl;
 		}
-
-		Ipv4Address srcIp = ipv4Header.GetSource();
-		Ipv4Address dstIp = ipv4Header.GetDestination();
-		uint8_t protocolNumber = ipv4Header.GetProtocol();
-
-		uint16_t srcPort = 0;
-		uint16_t dstPort = 0;
-
-		if (protocolNumber == 6) // TCP
-		{
-			TcpHeader tcpHeader;
-			if (!packet->RemoveHeader(tcpHeader))
-			{
-				NS_LOG_WARN("SDNController: Failed to remove TCP header");
-				ctrl.type = Error;
-				return ctrl;
-			}
-			srcPort = tcpHeader.GetSourcePort();
-			dstPort = tcpHeader.GetDestinationPort();
-		}
-		else if (protocolNumber == 17) // UDP
-		{
-			UdpHeader udpHeader;
-			if (!packet->RemoveHeader(udpHeader))
-			{
-				NS_LOG_WARN("SDNController: Failed to remove UDP header");
-				ctrl.type = Error;
-				return ctrl;
-			}
-			srcPort = udpHeader.GetSourcePort();
-			dstPort = udpHeader.GetDestinationPort();
-		}
-
-		ctrl.type = type;
-		ctrl.srcIp = srcIp;
-		ctrl.dstIp = dstIp;
-		ctrl.protocolNumber = protocolNumber;
-		ctrl.srcPort = srcPort;
-		ctrl.dstPort = dstPort;
+		ctrl = GenerateControlPacket(key, type);
 	}
 
 	return ctrl;
 }
 
+controlPacket SDNSwitch::GenerateControlPacket(const FlowKey& key, controlType type)
+{
+	controlPacket ctrl;
+	ctrl.type = type;
+	ctrl.srcIp = Ipv4Address(key.srcIp);
+	ctrl.dstIp = Ipv4Address(key.dstIp);
+	ctrl.protocolNumber = key.protocol;
+	ctrl.srcPort = key.srcPort;
+	ctrl.dstPort = key.dstPort;
+	ctrl.flow = kNoFlow;
+	return ctrl;
+}
+
 
 bool SDNSwitch::ReceivePacket(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &src, const Address &dst,
 	ns3::NetDevice::PacketType packetType)
@@ -115,140 +294,471 @@ bool SDNSwitch::ReceivePacket(Ptr<NetDevice> device, Ptr<const Packet> packet, u
 	NS_LOG_INFO("SDNSwitch: Packet received at SDN switch");
 	if (protocol == 0x0806)		// ARP handling
 	{
-		Ptr<Packet> copy = packet->Copy();
-		ArpHeader arpHeader;
-		if (!copy->RemoveHeader(arpHeader))
+		controlPacket ctrl = GenerateControlPacket(packet, ARPPacket);
+		if (ctrl.type == Error)
 		{
-			NS_LOG_WARN("SDNSwitch: Failed to remove ARP header");
+			// Not a request: nothing to resolve, but a reply teaches the controller a binding
+			ReportArpReply(packet, device);
 			return true;
 		}
-		if (arpHeader.IsRequest())
-    	{
-			
-			Ipv4Address senderIp = arpHeader.GetSourceIpv4Address();
-			Ipv4Address targetIp = arpHeader.GetDestinationIpv4Address();
-			Address senderMac = src;
-
-			NS_LOG_INFO("SDNSwitch: ARP Request from IP " << senderIp << " asking for " << targetIp);
-
-			controlPacket ctrl = GenerateControlPacket(packet->Copy(), ARPPacket);
-			if (ctrl.type == Error)
-				exit(1);
-			ctrl.srcMac = src;
-			m_controller->HandlePacketIn(this, &ctrl, device);
-			
-			ArpHeader replyArp;
-			replyArp.SetReply(ctrl.dstMac, targetIp, ctrl.srcMac, senderIp);
-			EthernetHeader ethHeader;
-			ethHeader.SetSource(Mac48Address::ConvertFrom(ctrl.dstMac));
-			ethHeader.SetDestination(Mac48Address::ConvertFrom(ctrl.srcMac));
-			ethHeader.SetLengthType(0x0806);
-
-			Ptr<Packet> replyPacket = Create<Packet>();
-			replyPacket->AddHeader(ethHeader);
-			replyPacket->AddHeader(replyArp);
-			
-			device->Send(replyPacket, senderMac, protocol);
-			NS_LOG_INFO("SDNSwitch: ARP Reply (" << ctrl.dstMac << ") sent to " << senderIp << " for target " << targetIp);
+
+		NS_LOG_INFO("SDNSwitch: ARP Request from IP " << ctrl.srcIp << " asking for " << ctrl.dstIp);
+
+		ctrl.srcMac = src;
+		if (m_arpCacheEnabled)
+		{
+			auto cached = m_arpCache.find(ctrl.dstIp);
+			if (cached != m_arpCache.end())
+			{
+				ctrl.dstMac = cached->second;
+				m_arpCacheHits++;
+				SendArpReply(device, ctrl, src);
+				return true;
+			}
+		}
+		if (!SendToController(ctrl, device))
+		{
+			return true;
+		}
+		if (m_channel)
+		{
+			// The request or its reply may be lost on the channel
+			m_pending[ctrl.xid] = PendingRequest{device, src};
+			Simulator::Schedule(m_packetInRetry, &SDNSwitch::ExpireArpRequest, this, ctrl.xid);
+		}
+		else if (!ctrl.dstMac.IsInvalid())
+		{
+			SendArpReply(device, ctrl, src);
 		}
 		return true;
 	}
 	else		// FLow handling
 	{
-		FlowEntry *flow;
-		if (LookupFlow(packet->Copy(), flow)) {
+		// Parse once; the lookup and the PacketIn share the key
+		FlowKey key;
+		if (!ExtractFlowKey(packet, key))
+		{
+			NS_LOG_WARN("SDNSwitch: Dropping packet without a readable IPv4 header");
+			return true;
+		}
+
+		if (m_lookupBurst > 1 && m_flowTable)
+		{
+			// Defer to the end of this instant so packets arriving together share one lookup pass
+			m_burstKeys.push_back(key);
+			m_burstPackets.push_back(BurstPacket{packet, device});
+			if (m_burstKeys.size() >= m_lookupBurst)
+			{
+				m_burstEvent.Cancel();
+				ProcessBurst();
+			}
+			else if (!m_burstEvent.IsPending())
+			{
+				m_burstEvent = Simulator::ScheduleNow(&SDNSwitch::ProcessBurst, this);
+			}
+			return true;
+		}
+
+		FlowId flow;
+		if (LookupFlow(key, flow)) {
 			NS_LOG_INFO("SDNSwitch: Flow matched. Forwarding...");
 			ForwardPacket(packet->Copy(), flow);
 		} else {
-			NS_LOG_INFO("SDNSwitch: No flow match");
-			controlPacket ctrl = GenerateControlPacket(packet->Copy(), FlowAdd);
-			if (ctrl.type == Error)
-				exit(1);
-			m_controller->HandlePacketIn(this, &ctrl, device);
-			ForwardPacket(packet->Copy(), ctrl.flow);
+			HandleMiss(key, packet, device);
 		}
 	}
 	
 	return true;
 }
 
-FlowEntry* SDNSwitch::InstallFlowEntry(FlowEntry entry)
+void SDNSwitch::HandleMiss(const FlowKey& key, Ptr<const Packet> packet, Ptr<NetDevice> device)
+{
+	NS_LOG_INFO("SDNSwitch: No flow match");
+	if (m_channel)
+	{
+		BufferMiss(key, packet, device);
+		return;
+	}
+	controlPacket ctrl = GenerateControlPacket(key, FlowAdd);
+	SendToController(ctrl, device);
+	if (ctrl.flow != kNoFlow)
+	{
+		ForwardPacket(packet->Copy(), ctrl.flow);
+	}
+}
+
+void SDNSwitch::ProcessBurst()
+{
+	// Swap out first: forwarding can deliver packets back to this switch
+	std::vector<FlowKey> keys;
+	std::vector<BurstPacket> packets;
+	keys.swap(m_burstKeys);
+	packets.swap(m_burstPackets);
+	m_burstFlows.resize(keys.size());
+	m_flowTable->FindMatchingFlows(keys.data(), keys.size(), m_burstFlows.data());
+	NS_LOG_INFO("SDNSwitch: Burst of " << keys.size() << " packets looked up");
+
+	m_lookups += keys.size();
+	uint64_t generation = m_flowTable->GetGeneration();
+	for (uint32_t i = 0; i < keys.size(); i++)
+	{
+		// A miss earlier in the burst may have installed a rule since the batch lookup, and an
+		// install into a full table evicts one and hands its id to the new rule: redo the rest
+		if (m_flowTable->GetGeneration() != generation)
+		{
+			m_flowTable->FindMatchingFlows(keys.data() + i, keys.size() - i, m_burstFlows.data() + i);
+			generation = m_flowTable->GetGeneration();
+		}
+		FlowId flow = m_burstFlows[i];
+		if (flow != kNoFlow)
+		{
+			m_hits++;
+			ForwardPacket(packets[i].packet->Copy(), flow);
+		}
+		else
+		{
+			m_misses++;
+			HandleMiss(keys[i], packets[i].packet, packets[i].device);
+		}
+	}
+
+	// Hand the storage back for the next burst
+	if (m_burstKeys.empty())
+	{
+		keys.clear();
+		packets.clear();
+		m_burstKeys.swap(keys);
+		m_burstPackets.swap(packets);
+	}
+}
+
+FlowId SDNSwitch::InstallFlowEntry(const FlowEntry& entry)
 {
-	FlowEntry *ptr = nullptr;
+	FlowId flow = kNoFlow;
 	if (m_flowTable) {
-		ptr = m_flowTable->AddFlowEntry(entry);
+		flow = m_flowTable->AddFlowEntry(entry);
+	}
+	if (flow != kNoFlow)
+	{
+		m_flowInstalls++;
+		m_flowInstalledTrace(entry);
 	}
-	return ptr;
+	return flow;
 }
 
-bool SDNSwitch::LookupFlow(Ptr<Packet> packet, FlowEntry*& matched)
+bool SDNSwitch::LookupFlow(const FlowKey& key, FlowId& matched)
 {
 	if (!m_flowTable) return false;
 
-	Ipv4Header ipv4Header;
-	TcpHeader tcpHeader;
-	UdpHeader udpHeader;
-	std::string protocol;
-
-	// Copy the packet to avoid modifying the original
-	Ptr<Packet> copy = packet->Copy();
-
-	// Extract the IP header
-	if (!copy->RemoveHeader(ipv4Header)) return false;
-
-	Ipv4Address srcIp = ipv4Header.GetSource();
-	Ipv4Address dstIp = ipv4Header.GetDestination();
-
-	uint16_t srcPort = 0;
-	uint16_t dstPort = 0;
-
-	switch (ipv4Header.GetProtocol()) {
-		case 6: // TCP
-			if (!copy->RemoveHeader(tcpHeader)) return false;
-			srcPort = tcpHeader.GetSourcePort();
-			dstPort = tcpHeader.GetDestinationPort();
-			protocol = "TCP";
-			break;
-		case 17: // UDP
-			if (!copy->RemoveHeader(udpHeader)) return false;
-			srcPort = udpHeader.GetSourcePort();
-			dstPort = udpHeader.GetDestinationPort();
-			protocol = "UDP";
-			break;
-		default:
-			return false; // Unsupported protocol
-	}
-	NS_LOG_INFO("SDNSwitch: Looking up: " << srcIp << ":" << srcPort << " -> " << dstIp << ":" << dstPort);
-	FlowEntry* entry = m_flowTable->FindMatchingFlow(srcIp, dstIp, srcPort, dstPort);
-	if (entry) {
-		matched = entry;
+	NS_LOG_INFO("SDNSwitch: Looking up: " << Ipv4Address(key.srcIp) << ":" << key.srcPort << " -> " << Ipv4Address(key.dstIp) << ":" << key.dstPort);
+	FlowId flow = m_flowTable->FindMatchingFlow(key);
+	m_lookups++;
+	if (flow != kNoFlow) {
+		m_hits++;
+		matched = flow;
 		return true;
 	}
 
+	m_misses++;
 	return false;
 }
 
-void SDNSwitch::ForwardPacket(Ptr<Packet> packet, FlowEntry* flow)
+void SDNSwitch::ForwardPacket(Ptr<Packet> packet, FlowId flow)
 {
-	Ptr<NetDevice> device = flow->outputDevice;
+	uint16_t port = m_flowTable->GetOutputPort(flow);
+	const Ptr<NetDevice>& device = m_flowTable->GetPort(port);
+	uint32_t size = packet->GetSize();
 	Address addr = device->GetAddress();
 	device->Send(packet, addr, 0x0800);
-	m_flowTable->UpdateFlowStats(flow, 1, packet->GetSize());
-	NS_LOG_INFO("SDNSwitch: Forwarding from " << flow->srcIp 
-			<< " to " << flow->dstIp 
+	m_flowTable->UpdateFlowStats(flow, 1, size);
+	if (port >= m_portTx.size())
+	{
+		m_portTx.resize(port + 1, PortCounters{0, 0});
+	}
+	m_portTx[port].txPackets++;
+	m_portTx[port].txBytes += size;
+	NS_LOG_INFO("SDNSwitch: Forwarding from " << m_flowTable->GetEntry(flow).srcIp 
+			<< " to " << m_flowTable->GetEntry(flow).dstIp 
 			<< " at output port " << addr);
 }
 
+void SDNSwitch::BufferMiss(const FlowKey& key, Ptr<const Packet> packet, Ptr<NetDevice> device)
+{
+	if (m_bufferedPackets >= m_missBufferSize)
+	{
+		m_missDrops++;
+		NS_LOG_WARN("SDNSwitch: Miss buffer full, dropping packet");
+		return;
+	}
 
+	auto pending = m_missBufferIds.find(key);
+	if (pending != m_missBufferIds.end())
+	{
+		// PacketIn already outstanding for this flow: just queue behind it
+		MissBuffer& buffer = m_missBuffers[pending->second];
+		buffer.packets.push_back(packet->Copy());
+		m_bufferedPackets++;
+		if (Simulator::Now() - buffer.packetInSent < m_packetInRetry)
+		{
+			return;
+		}
+		controlPacket ctrl = GenerateControlPacket(key, FlowAdd);
+		ctrl.bufferId = pending->second;
+		if (SendToController(ctrl, device))
+		{
+			buffer.packetInSent = Simulator::Now();
+		}
+		return;
+	}
 
+	controlPacket ctrl = GenerateControlPacket(key, FlowAdd);
+	ctrl.bufferId = m_nextBufferId++;
+	if (!SendToController(ctrl, device))
+	{
+		NS_LOG_WARN("SDNSwitch: PacketIn dropped by the control channel");
+		return;
+	}
+	MissBuffer& buffer = m_missBuffers[ctrl.bufferId];
+	buffer.key = key;
+	buffer.packets.push_back(packet->Copy());
+	buffer.packetInSent = Simulator::Now();
+	buffer.firstMiss = buffer.packetInSent;
+	m_missBufferIds[key] = ctrl.bufferId;
+	m_bufferedPackets++;
+	Simulator::Schedule(m_packetInRetry, &SDNSwitch::ExpireMissBuffer, this, ctrl.bufferId);
+}
 
+// Without this a buffer whose PacketIn or reply was lost would hold its packets, and its share
+// of MissBufferSize, until the flow's next packet
+void SDNSwitch::ExpireMissBuffer(uint32_t bufferId)
+{
+	auto buffer = m_missBuffers.find(bufferId);
+	if (buffer == m_missBuffers.end())
+	{
+		return;
+	}
+	Time due = buffer->second.packetInSent + m_packetInRetry;
+	if (due > Simulator::Now())
+	{
+		// Re-sent since: wait for that one
+		Simulator::Schedule(due - Simulator::Now(), &SDNSwitch::ExpireMissBuffer, this, bufferId);
+		return;
+	}
+	uint32_t dropped = buffer->second.packets.size();
+	m_missBufferIds.erase(buffer->second.key);
+	m_missBuffers.erase(buffer);
+	m_bufferedPackets -= dropped;
+	m_missDrops += dropped;
+	NS_LOG_WARN("SDNSwitch: No FlowAdd for buffer " << bufferId << ", dropping " << dropped << " packets");
+}
 
+void SDNSwitch::DrainMissBuffer(uint32_t bufferId, FlowId flow)
+{
+	auto buffer = m_missBuffers.find(bufferId);
+	if (buffer == m_missBuffers.end())
+	{
+		return;   // Already drained by an earlier reply
+	}
 
+	std::vector<Ptr<Packet>> packets;
+	packets.swap(buffer->second.packets);
+	Time setup = Simulator::Now() - buffer->second.firstMiss;
+	m_missBufferIds.erase(buffer->second.key);
+	m_missBuffers.erase(buffer);
+	m_bufferedPackets -= packets.size();
 
+	if (flow == kNoFlow)
+	{
+		NS_LOG_INFO("SDNSwitch: No route, dropping " << packets.size() << " buffered packets");
+		return;
+	}
+	m_flowSetupLatency.Add(setup);
+	m_flowSetupTrace(setup);
+	for (auto& packet : packets)
+	{
+		ForwardPacket(packet, flow);
+	}
+}
 
+void SDNSwitch::HandleControlMessage(const controlPacket& ctrl)
+{
+	if (ctrl.type == FlowAdd && !ctrl.flowMods.empty())
+	{
+		NS_LOG_INFO("SDNSwitch: Bulk FlowAdd with " << ctrl.flowMods.size() << " entries");
+		for (const auto& mod : ctrl.flowMods)
+		{
+			FlowId flow = mod.entry.outputDevice ? InstallFlowEntry(mod.entry) : kNoFlow;
+			DrainMissBuffer(mod.bufferId, flow);
+		}
+	}
+	else if (ctrl.type == FlowAdd)
+	{
+		FlowId flow = kNoFlow;
+		if (ctrl.flowEntry.outputDevice)
+		{
+			flow = InstallFlowEntry(ctrl.flowEntry);
+			NS_LOG_INFO("SDNSwitch: Flow entry received for src=" << ctrl.srcIp << " dst=" << ctrl.dstIp);
+		}
+		DrainMissBuffer(ctrl.bufferId, flow);
+	}
+	else if (ctrl.type == BarrierRequest)
+	{
+		// Messages are handled in arrival order, so everything before the barrier is done
+		controlPacket reply;
+		reply.type = BarrierReply;
+		reply.xid = ctrl.xid;
+		if (m_channel)
+		{
+			m_channel->SendToController(this, reply, nullptr);
+		}
+	}
+	else if (ctrl.type == ARPPacket)
+	{
+		// An invalid MAC is the controller's miss answer: the request goes unanswered
+		auto pending = m_pending.find(ctrl.xid);
+		if (pending != m_pending.end())
+		{
+			if (!ctrl.dstMac.IsInvalid())
+			{
+				SendArpReply(pending->second.inPort, ctrl, pending->second.srcMac);
+			}
+			m_pending.erase(pending);
+		}
+	}
+	else if (ctrl.type == FlowDelete && m_flowTable)
+	{
+		// Rules towards flowEntry.dstIp go, and so do aggregate destination rules, which may span it
+		uint32_t removed = m_flowTable->UpdateEntries([&](FlowEntry& entry) {
+			return entry.dstMask == Ipv4Mask::GetOnes() && entry.dstIp != ctrl.flowEntry.dstIp;
+		});
+		NS_LOG_INFO("SDNSwitch: FlowDelete for " << ctrl.flowEntry.dstIp << " removed " << removed << " entries");
+	}
+	else if (ctrl.type == PacketOut && ctrl.flowEntry.outputDevice)
+	{
+		// The controller floods ARP requests it cannot answer (ArpMissFlood) this way
+		Ptr<NetDevice> port = ctrl.flowEntry.outputDevice;
+		ArpHeader request;
+		request.SetRequest(ctrl.srcMac, ctrl.srcIp, port->GetBroadcast(), ctrl.dstIp);
+		Ptr<Packet> packet = Create<Packet>();
+		packet->AddHeader(request);
+		port->Send(packet, port->GetBroadcast(), 0x0806);
+	}
+	else if (ctrl.type == ArpCacheUpdate)
+	{
+		for (const auto& binding : ctrl.arpEntries)
+		{
+			m_arpCache[binding.first] = binding.second;
+		}
+		NS_LOG_INFO("SDNSwitch: ARP cache updated with " << ctrl.arpEntries.size() << " bindings, "
+			<< m_arpCache.size() << " cached");
+	}
+}
+
+void SDNSwitch::NotifyLinkState(Ptr<NetDevice> port, bool up)
+{
+	controlPacket ctrl;
+	ctrl.type = LinkStateUpdate;
+	ctrl.linkUp = up;
+	NS_LOG_INFO("SDNSwitch: Port " << port->GetAddress() << " is " << (up ? "up" : "down"));
+	SendToController(ctrl, port);
+}
+
+void SDNSwitch::NotifySwitchState(bool up)
+{
+	controlPacket ctrl;
+	ctrl.type = up ? SwitchJoin : SwitchLeave;
+	NS_LOG_INFO("SDNSwitch: Switch " << (up ? "joining" : "leaving"));
+	SendToController(ctrl, nullptr);
+}
+
+void SDNSwitch::NotifyFlowRemoved(const FlowEntry& entry, FlowRemovedReason reason)
+{
+	controlPacket ctrl;
+	ctrl.type = FlowRemoved;
+	ctrl.srcIp = entry.srcIp;
+	ctrl.dstIp = entry.dstIp;
+	ctrl.protocolNumber = entry.protocol;
+	ctrl.srcPort = entry.srcPort;
+	ctrl.dstPort = entry.dstPort;
+	ctrl.flow = kNoFlow;
+	ctrl.packetCount = entry.packetCount;
+	ctrl.byteCount = entry.byteCount;
+	ctrl.removedReason = reason;
+	if (m_controller)
+	{
+		SendToController(ctrl, entry.outputDevice);
+	}
+}
+
+uint32_t SDNSwitch::GetNBufferedPackets() const
+{
+	return m_bufferedPackets;
+}
+
+uint64_t SDNSwitch::GetNMissDrops() const
+{
+	return m_missDrops;
+}
+
+uint64_t SDNSwitch::GetNArpCacheHits() const
+{
+	return m_arpCacheHits;
+}
+
+uint32_t SDNSwitch::GetNPendingArpRequests() const
+{
+	return m_pending.size();
+}
+
+uint64_t SDNSwitch::GetNLookups() const
+{
+	return m_lookups;
+}
+
+uint64_t SDNSwitch::GetNHits() const
+{
+	return m_hits;
+}
+
+uint64_t SDNSwitch::GetNMisses() const
+{
+	return m_misses;
+}
+
+uint64_t SDNSwitch::GetNPacketIns() const
+{
+	return m_packetIns;
+}
+
+uint64_t SDNSwitch::GetNFlowInstalls() const
+{
+	return m_flowInstalls;
+}
+
+uint64_t SDNSwitch::GetNEvictions() const
+{
+	return m_flowTable ? m_flowTable->GetNEvictions() : 0;
+}
+
+const LatencyHistogram& SDNSwitch::GetFlowSetupLatency() const
+{
+	return m_flowSetupLatency;
+}
 
+uint16_t SDNSwitch::GetNPorts() const
+{
+	return m_flowTable ? m_flowTable->GetNPorts() : 0;
+}
 
+uint64_t SDNSwitch::GetPortTxPackets(uint16_t port) const
+{
+	return port < m_portTx.size() ? m_portTx[port].txPackets : 0;
+}
 
+uint64_t SDNSwitch::GetPortTxBytes(uint16_t port) const
+{
+	return port < m_portTx.size() ? m_portTx[port].txBytes : 0;
+}
 
 } // namespace sdn
 } // namespace ns3
@@ -8,10 +8,13 @@
 #include "ns3/tcp-header.h"
 #include "ns3/udp-header.h"
 #include "ns3/net-device.h"
+#include "ns3/traced-callback.h"
 #include "sdn-flow-table.h"
 #include "sdn-controller.h"
 #include "control-packet.h"
-// #include "sdn-control-channel.h"
+#include "sdn-control-channel.h"
+#include "sdn-latency-histogram.h"
+#include <unordered_map>
 
 namespace ns3 {
 namespace sdn {
@@ -23,25 +26,141 @@ class SDNSwitch : public Object
 {
 public:
   static TypeId GetTypeId(void);
+  // Trace signatures
+  typedef void (*PacketInTracedCallback)(const controlPacket& ctrl);
+  typedef void (*FlowInstalledTracedCallback)(const FlowEntry& entry);
+
   SDNSwitch();
   virtual ~SDNSwitch();
 
   void SetFlowTable(Ptr<SDNFlowTable> table);
+  Ptr<SDNFlowTable> GetFlowTable() const;
+  // With a channel set, control messages travel through it and misses wait at the switch
+  // for the controller's reply; without one the controller is called synchronously
+  void SetControlChannel(Ptr<SDNControlChannel> channel);
+  Ptr<SDNControlChannel> GetControlChannel() const;
   void AddDevice(Ptr<NetDevice> device);
-  controlPacket GenerateControlPacket(Ptr<Packet> packet, controlType type);
+  controlPacket GenerateControlPacket(Ptr<const Packet> packet, controlType type);
+  controlPacket GenerateControlPacket(const FlowKey& key, controlType type);
+  static bool ExtractFlowKey(Ptr<const Packet> packet, FlowKey& key);
 
   bool ReceivePacket(Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &src, const Address &dst,
     ns3::NetDevice::PacketType packetType); // Main entry point 
 
-  FlowEntry* InstallFlowEntry(FlowEntry entry);
-  bool LookupFlow(Ptr<Packet> packet, FlowEntry*& matched);
+  FlowId InstallFlowEntry(const FlowEntry& entry);
+  bool LookupFlow(const FlowKey& key, FlowId& matched);
+
+  void ForwardPacket(Ptr<Packet> packet, FlowId flow);
+
+  // Controller reply delivered by the control channel (FlowAdd or ARPPacket)
+  void HandleControlMessage(const controlPacket& ctrl);
+
+  // Report topology events to the controller (LinkStateUpdate / SwitchJoin / SwitchLeave)
+  void NotifyLinkState(Ptr<NetDevice> port, bool up);
+  void NotifySwitchState(bool up);
+  // Flow table callback: reports a timed-out entry to the controller (FlowRemoved)
+  void NotifyFlowRemoved(const FlowEntry& entry, FlowRemovedReason reason);
+
+  uint32_t GetNBufferedPackets() const;
+  // Missed packets dropped: the buffer was full, or their FlowAdd never came
+  uint64_t GetNMissDrops() const;
+  // ARP requests answered from the local cache, without a PacketIn
+  uint64_t GetNArpCacheHits() const;
+  // ARP requests sent to the controller and not answered yet
+  uint32_t GetNPendingArpRequests() const;
+
+  // Datapath counters. Every IPv4 lookup is a hit or a miss; PacketIns count flow misses and
+  // ARP requests sent to the controller, including re-sent ones.
+  uint64_t GetNLookups() const;
+  uint64_t GetNHits() const;
+  uint64_t GetNMisses() const;
+  uint64_t GetNPacketIns() const;
+  uint64_t GetNFlowInstalls() const;
+  uint64_t GetNEvictions() const;
+  // Time from a flow's first buffered miss to its FlowAdd (control channel only)
+  const LatencyHistogram& GetFlowSetupLatency() const;
+  // Packets and bytes forwarded by flow rules, per flow table port (see SDNFlowTable::AddPort)
+  uint16_t GetNPorts() const;
+  uint64_t GetPortTxPackets(uint16_t port) const;
+  uint64_t GetPortTxBytes(uint16_t port) const;
 
-  void ForwardPacket(Ptr<Packet> packet, FlowEntry* flow);
-  
   std::vector<Ptr<NetDevice>> m_devices;
   Ptr<SDNController> m_controller;
 private:
+  // An ARP request waiting for the controller's reply, matched by xid
+  struct PendingRequest {
+    Ptr<NetDevice> inPort;
+    Address srcMac;            // Requester to answer
+  };
+
+  // Packets of one flow waiting for its FlowAdd. Only the first miss raises a PacketIn, which
+  // names the buffer instead of carrying the payload; the reply drains it in arrival order.
+  struct MissBuffer {
+    FlowKey key;
+    std::vector<Ptr<Packet>> packets;
+    Time packetInSent;         // PacketIn is re-sent by a packet arriving this late, and the
+                               // buffer dropped if none does (lost on the channel)
+    Time firstMiss;
+  };
+
+  // A packet waiting for the burst lookup; its key is kept apart in m_burstKeys
+  struct BurstPacket {
+    Ptr<const Packet> packet;
+    Ptr<NetDevice> device;
+  };
+
+  struct PortCounters {
+    uint64_t txPackets;
+    uint64_t txBytes;
+  };
+
+  bool SendToController(controlPacket& ctrl, Ptr<NetDevice> port);
+  void HandleMiss(const FlowKey& key, Ptr<const Packet> packet, Ptr<NetDevice> device);
+  void ProcessBurst();
+  void BufferMiss(const FlowKey& key, Ptr<const Packet> packet, Ptr<NetDevice> device);
+  void DrainMissBuffer(uint32_t bufferId, FlowId flow);
+  void ExpireMissBuffer(uint32_t bufferId);
+  void SendArpReply(Ptr<NetDevice> device, const controlPacket& ctrl, const Address& senderMac);
+  void ExpireArpRequest(uint32_t xid);
+  void ReportArpReply(Ptr<const Packet> packet, Ptr<NetDevice> device);
+
   Ptr<SDNFlowTable> m_flowTable;
+  Time m_timeoutGranularity;
+  Ptr<SDNControlChannel> m_channel;
+  std::unordered_map<uint32_t, PendingRequest> m_pending;
+  uint32_t m_nextXid;
+
+  std::unordered_map<uint32_t, MissBuffer> m_missBuffers;             // buffer id -> packets
+  std::unordered_map<FlowKey, uint32_t, FlowKeyHash> m_missBufferIds;  // flow -> buffer id
+  uint32_t m_nextBufferId;
+  uint32_t m_bufferedPackets;
+  uint32_t m_missBufferSize;   // Packets the switch can hold across all pending flows
+  Time m_packetInRetry;
+  uint64_t m_missDrops;
+
+  // Proxy ARP: bindings pushed by the controller (ArpCacheUpdate)
+  bool m_arpCacheEnabled;
+  std::unordered_map<Ipv4Address, Address, Ipv4AddressHash> m_arpCache;
+  uint64_t m_arpCacheHits;
+
+  uint32_t m_lookupBurst;
+  std::vector<FlowKey> m_burstKeys;
+  std::vector<BurstPacket> m_burstPackets;
+  std::vector<FlowId> m_burstFlows;
+  EventId m_burstEvent;
+
+  // Metrics: plain counters, exported by SDNMetricsExporter
+  uint64_t m_lookups;
+  uint64_t m_hits;
+  uint64_t m_misses;
+  uint64_t m_packetIns;
+  uint64_t m_flowInstalls;
+  LatencyHistogram m_flowSetupLatency;
+  std::vector<PortCounters> m_portTx;   // Grown on first use of a port
+
+  TracedCallback<const controlPacket&> m_packetInTrace;
+  TracedCallback<const FlowEntry&> m_flowInstalledTrace;
+  TracedCallback<Time> m_flowSetupTrace;
 };
 
 } // namespace sdn
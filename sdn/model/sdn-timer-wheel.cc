@@ -0,0 +1,142 @@
+#include "sdn-timer-wheel.h"
+
+namespace ns3 {
+namespace sdn {
+
+TimerWheel::TimerWheel()
+    : m_heads(kLevels * kSlots, kNoTimer),
+      m_free(kNoTimer),
+      m_now(0),
+      m_size(0)
+{
+}
+
+void TimerWheel::Reset(uint64_t now)
+{
+    if (m_size == 0) {
+        m_now = now;
+    }
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(uint64_t expiry, uint32_t data)
+{
+    TimerId id;
+    if (m_free != kNoTimer) {
+        id = m_free;
+        m_free = m_nodes[id].next;
+    } else {
+        id = m_nodes.size();
+        m_nodes.push_back(Node());
+    }
+
+    m_nodes[id].expiry = expiry > m_now ? expiry : m_now + 1;
+    m_nodes[id].data = data;
+    Place(id);
+    m_size++;
+    return id;
+}
+
+void TimerWheel::Cancel(TimerId id)
+{
+    if (id >= m_nodes.size() || m_nodes[id].slot == kNoTimer) return;
+    Unlink(id);
+    Release(id);
+}
+
+// Level l holds timers whose expiry agrees with the current tick above bit 8 * (l + 1);
+// the slot is the expiry's 8-bit digit at that level
+void TimerWheel::Place(TimerId id)
+{
+    Node& node = m_nodes[id];
+    uint64_t diff = node.expiry ^ m_now;
+    uint32_t slot;
+    uint32_t level = 0;
+    while (level < kLevels && (diff >> (kSlotBits * (level + 1))) != 0) {
+        level++;
+    }
+    if (level < kLevels) {
+        slot = level * kSlots + ((node.expiry >> (kSlotBits * level)) & (kSlots - 1));
+    } else {
+        // Beyond the wheel's span: park in the top slot visited last and re-place from there
+        level = kLevels - 1;
+        slot = level * kSlots + (((m_now >> (kSlotBits * level)) - 1) & (kSlots - 1));
+    }
+
+    node.slot = slot;
+    node.prev = kNoTimer;
+    node.next = m_heads[slot];
+    if (node.next != kNoTimer) {
+        m_nodes[node.next].prev = id;
+    }
+    m_heads[slot] = id;
+}
+
+void TimerWheel::Unlink(TimerId id)
+{
+    Node& node = m_nodes[id];
+    if (node.prev != kNoTimer) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_heads[node.slot] = node.next;
+    }
+    if (node.next != kNoTimer) {
+        m_nodes[node.next].prev = node.prev;
+    }
+}
+
+void TimerWheel::Release(TimerId id)
+{
+    m_nodes[id].slot = kNoTimer;
+    m_nodes[id].data = 0;
+    m_nodes[id].next = m_free;
+    m_free = id;
+    m_size--;
+}
+
+void TimerWheel::Cascade(uint32_t slot)
+{
+    TimerId id = m_heads[slot];
+    m_heads[slot] = kNoTimer;
+    while (id != kNoTimer) {
+        TimerId next = m_nodes[id].next;
+        Place(id);
+        id = next;
+    }
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<uint32_t>& expired)
+{
+    while (m_now < now) {
+        if (m_size == 0) {
+            m_now = now;
+            break;
+        }
+        m_now++;
+
+        // Entering a new span at some level: redistribute that level's slot, highest level first
+        // so timers can fall through several levels in one step
+        for (uint32_t level = kLevels - 1; level >= 1; level--) {
+            uint64_t span = 1ull << (kSlotBits * level);
+            if ((m_now & (span - 1)) == 0) {
+                Cascade(level * kSlots + ((m_now >> (kSlotBits * level)) & (kSlots - 1)));
+            }
+        }
+
+        uint32_t slot = m_now & (kSlots - 1);
+        TimerId id = m_heads[slot];
+        m_heads[slot] = kNoTimer;
+        while (id != kNoTimer) {
+            TimerId next = m_nodes[id].next;
+            if (m_nodes[id].expiry <= m_now) {
+                expired.push_back(m_nodes[id].data);
+                Release(id);
+            } else {
+                Place(id);
+            }
+            id = next;
+        }
+    }
+}
+
+} // namespace sdn
+} // namespace ns3
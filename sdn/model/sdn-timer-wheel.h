@@ -0,0 +1,64 @@
+#ifndef SDN_TIMER_WHEEL_H
+#define SDN_TIMER_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+namespace sdn {
+
+// Hierarchical timer wheel over an abstract tick counter.
+// Four levels of 256 slots each cover 2^32 ticks; a timer sits in the lowest level whose
+// span still contains its expiry and is cascaded down as time approaches it.
+// Schedule and Cancel are O(1); Advance costs O(ticks elapsed + timers fired/cascaded).
+// Timers live in a pooled, index-linked node array, so steady-state operation does not allocate.
+class TimerWheel
+{
+public:
+    typedef uint32_t TimerId;
+    static constexpr TimerId kNoTimer = 0xffffffffu;
+
+    TimerWheel();
+
+    // Moves the wheel to 'now' without firing anything; only valid while no timers are pending
+    void Reset(uint64_t now);
+
+    // Arms a timer for tick 'expiry' (clamped to the next tick if already due)
+    TimerId Schedule(uint64_t expiry, uint32_t data);
+    void Cancel(TimerId id);
+
+    // Advances to tick 'now' and appends the data of every timer that fell due
+    void Advance(uint64_t now, std::vector<uint32_t>& expired);
+
+    uint64_t GetNow() const { return m_now; }
+    uint32_t GetSize() const { return m_size; }
+
+private:
+    static constexpr uint32_t kLevels = 4;
+    static constexpr uint32_t kSlotBits = 8;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+
+    struct Node {
+        uint64_t expiry;
+        uint32_t data;
+        TimerId prev;
+        TimerId next;
+        uint32_t slot;    // Index into m_heads, or kNoTimer while free
+    };
+
+    void Place(TimerId id);
+    void Unlink(TimerId id);
+    void Release(TimerId id);
+    void Cascade(uint32_t slot);
+
+    std::vector<Node> m_nodes;
+    std::vector<TimerId> m_heads;   // kLevels * kSlots list heads
+    TimerId m_free;                 // Free list threaded through Node::next
+    uint64_t m_now;
+    uint32_t m_size;
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_TIMER_WHEEL_H
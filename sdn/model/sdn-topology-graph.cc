@@ -0,0 +1,181 @@
+#include "sdn-topology-graph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace ns3 {
+namespace sdn {
+
+TopologyGraph::TopologyGraph()
+    : m_nTransit(0),
+      m_unitWeights(true)
+{
+}
+
+void TopologyGraph::Build(const std::vector<std::vector<Link>>& adjacency, uint32_t nTransit)
+{
+    uint32_t n = adjacency.size();
+    m_nTransit = nTransit;
+    m_unitWeights = true;
+
+    m_offsets.assign(n + 1, 0);
+    for (uint32_t u = 0; u < n; u++) {
+        m_offsets[u + 1] = m_offsets[u] + adjacency[u].size();
+    }
+
+    uint32_t nEdges = m_offsets[n];
+    m_sources.resize(nEdges);
+    m_targets.resize(nEdges);
+    m_weights.resize(nEdges);
+    m_ports.resize(nEdges);
+    for (uint32_t u = 0; u < n; u++) {
+        uint32_t e = m_offsets[u];
+        for (const auto& link : adjacency[u]) {
+            m_sources[e] = u;
+            m_targets[e] = link.neighborId;
+            m_weights[e] = link.weight;
+            m_ports[e] = link.outgoingPort;
+            m_unitWeights = m_unitWeights && link.weight == 1;
+            e++;
+        }
+    }
+    m_linkUp.assign(nEdges, 1);
+    m_nodeUp.assign(n, 1);
+}
+
+// Breadth-first search: every link costs 1, so discovery order is distance order
+static void ComputeUnitShortestPath(const TopologyGraph& graph, uint32_t source, ShortestPathScratch& scratch)
+{
+    std::vector<uint32_t>& queue = scratch.queue;
+    queue.clear();
+    queue.push_back(source);
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        uint32_t u = queue[head];
+        // Hosts terminate traffic; only the source and switches are expanded
+        if (u != source && u >= graph.GetNTransitNodes()) continue;
+
+        uint32_t nextDistance = scratch.distance[u] + 1;
+        for (uint32_t e = graph.EdgeBegin(u); e < graph.EdgeEnd(u); e++) {
+            if (!graph.IsEdgeUsable(e)) continue;
+            uint32_t v = graph.GetTarget(e);
+            if (scratch.distance[v] != kNoRoute) continue;
+            scratch.distance[v] = nextDistance;
+            scratch.firstEdge[v] = (u == source) ? e : scratch.firstEdge[u];
+            queue.push_back(v);
+        }
+    }
+}
+
+// Dijkstra's algorithm on a binary heap with lazy deletion
+static void ComputeWeightedShortestPath(const TopologyGraph& graph, uint32_t source, ShortestPathScratch& scratch)
+{
+    typedef std::pair<uint32_t, uint32_t> HeapItem;   // (distance, node)
+    std::vector<HeapItem>& heap = scratch.heap;
+    std::greater<HeapItem> cmp;
+    heap.clear();
+    heap.push_back(HeapItem(0, source));
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        HeapItem top = heap.back();
+        heap.pop_back();
+        uint32_t u = top.second;
+
+        // Skip if we found a shorter path already
+        if (top.first > scratch.distance[u]) continue;
+        if (u != source && u >= graph.GetNTransitNodes()) continue;
+
+        for (uint32_t e = graph.EdgeBegin(u); e < graph.EdgeEnd(u); e++) {
+            if (!graph.IsEdgeUsable(e)) continue;
+            uint32_t v = graph.GetTarget(e);
+            uint32_t distanceToNeighbor = top.first + graph.GetWeight(e);
+            if (distanceToNeighbor < scratch.distance[v]) {
+                scratch.distance[v] = distanceToNeighbor;
+                scratch.firstEdge[v] = (u == source) ? e : scratch.firstEdge[u];
+                heap.push_back(HeapItem(distanceToNeighbor, v));
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+        }
+    }
+}
+
+void ComputeShortestPath(const TopologyGraph& graph, uint32_t source, ShortestPathScratch& scratch)
+{
+    uint32_t n = graph.GetNNodes();
+    scratch.distance.assign(n, kNoRoute);
+    scratch.firstEdge.assign(n, kNoRoute);
+    if (!graph.IsNodeUp(source)) return;
+    scratch.distance[source] = 0;
+
+    if (graph.HasUnitWeights()) {
+        ComputeUnitShortestPath(graph, source, scratch);
+    } else {
+        ComputeWeightedShortestPath(graph, source, scratch);
+    }
+}
+
+void ComputeRoutingTable(const TopologyGraph& graph, uint32_t nSources, uint32_t nThreads,
+                         std::vector<uint32_t>& table, std::vector<uint32_t>& distances)
+{
+    size_t size = static_cast<size_t>(nSources) * graph.GetNNodes();
+    table.assign(size, kNoRoute);
+    distances.assign(size, kNoRoute);
+
+    std::vector<uint32_t> sources(nSources);
+    for (uint32_t source = 0; source < nSources; source++) {
+        sources[source] = source;
+    }
+    ComputeRoutingRows(graph, sources, nThreads, table, distances);
+}
+
+void ComputeRoutingRows(const TopologyGraph& graph, const std::vector<uint32_t>& sources, uint32_t nThreads,
+                        std::vector<uint32_t>& table, std::vector<uint32_t>& distances)
+{
+    uint32_t n = graph.GetNNodes();
+    uint32_t nSources = sources.size();
+
+    if (nThreads == 0) {
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    nThreads = std::min(nThreads, std::max(1u, nSources));
+
+    // Workers claim small blocks of sources until none are left
+    const uint32_t blockSize = 16;
+    std::atomic<uint32_t> nextSource(0);
+    auto worker = [&]() {
+        ShortestPathScratch scratch;
+        for (;;) {
+            uint32_t begin = nextSource.fetch_add(blockSize);
+            if (begin >= nSources) break;
+            uint32_t end = std::min(nSources, begin + blockSize);
+            for (uint32_t i = begin; i < end; i++) {
+                uint32_t source = sources[i];
+                size_t row = static_cast<size_t>(source) * n;
+                ComputeShortestPath(graph, source, scratch);
+                std::copy(scratch.firstEdge.begin(), scratch.firstEdge.end(), table.begin() + row);
+                std::copy(scratch.distance.begin(), scratch.distance.end(), distances.begin() + row);
+            }
+        }
+    };
+
+    if (nThreads == 1) {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads - 1);
+    for (uint32_t t = 1; t < nThreads; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace sdn
+} // namespace ns3
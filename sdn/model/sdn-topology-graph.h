@@ -0,0 +1,92 @@
+#ifndef SDN_TOPOLOGY_GRAPH_H
+#define SDN_TOPOLOGY_GRAPH_H
+
+#include <vector>
+#include <limits>
+#include "ns3/ptr.h"
+#include "ns3/net-device.h"
+
+namespace ns3 {
+namespace sdn {
+
+// Marks "no path" in distance and next-hop rows
+const uint32_t kNoRoute = std::numeric_limits<uint32_t>::max();
+
+// Structure to represent network links
+struct Link {
+    uint32_t neighborId;       // Dense index of the node at the far end
+    Ptr<NetDevice> outgoingPort;
+    uint32_t weight;  // Can be hop count (1) or another metric
+};
+
+// Network topology in compressed sparse row form, keyed by dense node index.
+// The links leaving node u are the edges [EdgeBegin(u), EdgeEnd(u)).
+// Nodes [0, nTransit) forward traffic (switches); the rest (hosts) only terminate it.
+// Links and nodes can be taken down and brought back; an edge is usable only while
+// its link and both of its end nodes are up.
+class TopologyGraph
+{
+public:
+    TopologyGraph();
+
+    void Build(const std::vector<std::vector<Link>>& adjacency, uint32_t nTransit);
+
+    uint32_t GetNNodes() const { return m_offsets.empty() ? 0 : m_offsets.size() - 1; }
+    uint32_t GetNTransitNodes() const { return m_nTransit; }
+    uint32_t GetNEdges() const { return m_targets.size(); }
+    bool HasUnitWeights() const { return m_unitWeights; }
+
+    uint32_t EdgeBegin(uint32_t node) const { return m_offsets[node]; }
+    uint32_t EdgeEnd(uint32_t node) const { return m_offsets[node + 1]; }
+    uint32_t GetSource(uint32_t edge) const { return m_sources[edge]; }
+    uint32_t GetTarget(uint32_t edge) const { return m_targets[edge]; }
+    uint32_t GetWeight(uint32_t edge) const { return m_weights[edge]; }
+    Ptr<NetDevice> GetPort(uint32_t edge) const { return m_ports[edge]; }
+
+    void SetLinkUp(uint32_t edge, bool up) { m_linkUp[edge] = up; }
+    void SetNodeUp(uint32_t node, bool up) { m_nodeUp[node] = up; }
+    bool IsNodeUp(uint32_t node) const { return m_nodeUp[node]; }
+    bool IsEdgeUsable(uint32_t edge) const {
+        return m_linkUp[edge] && m_nodeUp[m_sources[edge]] && m_nodeUp[m_targets[edge]];
+    }
+
+private:
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_sources;
+    std::vector<uint32_t> m_targets;
+    std::vector<uint32_t> m_weights;
+    std::vector<Ptr<NetDevice>> m_ports;   // Outgoing device on the source node of each edge
+    std::vector<uint8_t> m_linkUp;
+    std::vector<uint8_t> m_nodeUp;
+    uint32_t m_nTransit;
+    bool m_unitWeights;
+};
+
+// Reusable per-source buffers so repeated runs do not allocate
+struct ShortestPathScratch {
+    std::vector<uint32_t> distance;    // Path cost from the source, kNoRoute if unreachable
+    std::vector<uint32_t> firstEdge;   // Edge out of the source that starts the path, kNoRoute if none
+    std::vector<std::pair<uint32_t, uint32_t>> heap;
+    std::vector<uint32_t> queue;
+};
+
+// Single-source shortest paths from 'source' into scratch.distance / scratch.firstEdge.
+// Uses BFS when every link weight is 1 and a binary-heap Dijkstra otherwise.
+void ComputeShortestPath(const TopologyGraph& graph, uint32_t source, ShortestPathScratch& scratch);
+
+// Fills 'table' (nSources x N, row = source) with the first edge of the shortest path from every
+// source in [0, nSources) to every node, and 'distances' (same shape) with the path costs.
+// Sources are spread over nThreads workers (0 = one per core), each with its own scratch; rows are
+// written in place, so the result does not depend on nThreads. Workers only read the plain index
+// arrays of the graph and never touch ns-3 objects.
+void ComputeRoutingTable(const TopologyGraph& graph, uint32_t nSources, uint32_t nThreads,
+                         std::vector<uint32_t>& table, std::vector<uint32_t>& distances);
+
+// Recomputes only the listed rows of tables laid out as by ComputeRoutingTable
+void ComputeRoutingRows(const TopologyGraph& graph, const std::vector<uint32_t>& sources, uint32_t nThreads,
+                        std::vector<uint32_t>& table, std::vector<uint32_t>& distances);
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_TOPOLOGY_GRAPH_H
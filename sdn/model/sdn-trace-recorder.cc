@@ -0,0 +1,130 @@
+#include "sdn-trace-recorder.h"
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+#include <cstring>
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNTraceRecorder");
+
+TypeId SDNTraceRecorder::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::sdn::SDNTraceRecorder")
+        .SetParent<Object>()
+        .SetGroupName("SDN")
+        .AddConstructor<SDNTraceRecorder>()
+        .AddAttribute("FileName",
+                      "File the trace is written to (truncated by Start)",
+                      StringValue("sdn-control.trace"),
+                      MakeStringAccessor(&SDNTraceRecorder::m_fileName),
+                      MakeStringChecker());
+    return tid;
+}
+
+SDNTraceRecorder::SDNTraceRecorder()
+    : m_fileName("sdn-control.trace"),
+      m_records(0),
+      m_inputs(0)
+{
+}
+
+SDNTraceRecorder::~SDNTraceRecorder()
+{
+}
+
+void SDNTraceRecorder::DoDispose()
+{
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    for (const auto& controller : m_controllers) {
+        controller->TraceDisconnectWithoutContext("ControlMessage", MakeCallback(&SDNTraceRecorder::RecordInput, this));
+        controller->TraceDisconnectWithoutContext("Decision", MakeCallback(&SDNTraceRecorder::RecordDecision, this));
+    }
+    m_controllers.clear();
+    Object::DoDispose();
+}
+
+void SDNTraceRecorder::Attach(Ptr<SDNController> controller)
+{
+    controller->TraceConnectWithoutContext("ControlMessage", MakeCallback(&SDNTraceRecorder::RecordInput, this));
+    controller->TraceConnectWithoutContext("Decision", MakeCallback(&SDNTraceRecorder::RecordDecision, this));
+    m_controllers.push_back(controller);
+}
+
+void SDNTraceRecorder::Start()
+{
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+    m_file.open(m_fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!m_file) {
+        NS_LOG_WARN("SDNTraceRecorder: Cannot open " << m_fileName);
+        return;
+    }
+    SDNTraceFileHeader header;
+    std::memcpy(header.magic, "SDNTRACE", sizeof(header.magic));
+    header.version = kTraceVersion;
+    header.byteOrder = kTraceByteOrder;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_records = 0;
+    m_inputs = 0;
+}
+
+void SDNTraceRecorder::Stop()
+{
+    if (!m_file.is_open()) return;
+    m_file.close();
+    NS_LOG_INFO("SDNTraceRecorder: " << m_records << " records written to " << m_fileName);
+}
+
+uint64_t SDNTraceRecorder::GetNRecords() const
+{
+    return m_records;
+}
+
+uint32_t SDNTraceRecorder::GetNodeId(Ptr<SDNSwitch> swtch)
+{
+    return swtch->m_devices.empty() ? 0xffffffff : swtch->m_devices.front()->GetNode()->GetId();
+}
+
+void SDNTraceRecorder::RecordInput(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port)
+{
+    if (!m_file.is_open()) return;
+    SDNControlHeader header(ctrl, SDNControlHeader::ToController, nullptr);
+    header.SetPort(port);
+    m_inputs++;
+    Write(swtch, header, false);
+}
+
+void SDNTraceRecorder::RecordDecision(Ptr<SDNSwitch> swtch, const controlPacket& ctrl)
+{
+    if (!m_file.is_open()) return;
+    Write(swtch, SDNControlHeader(ctrl, SDNControlHeader::ToSwitch, nullptr), true);
+}
+
+void SDNTraceRecorder::Write(Ptr<SDNSwitch> swtch, const SDNControlHeader& header, bool decision)
+{
+    static const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+    uint32_t size = header.GetSerializedSize();
+    m_buffer.RemoveAtStart(m_buffer.GetSize());
+    m_buffer.AddAtStart(size);
+    header.Serialize(m_buffer.Begin());
+
+    SDNTraceRecord record;
+    record.time = Simulator::Now().GetNanoSeconds();
+    record.node = GetNodeId(swtch);
+    record.size = size | (decision ? kTraceDecision : 0);
+    record.input = m_inputs;
+    m_file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_buffer.CopyData(&m_file, size);
+    m_file.write(padding, TracePaddedSize(size) - size);
+    m_records++;
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,93 @@
+#ifndef SDN_TRACE_RECORDER_H
+#define SDN_TRACE_RECORDER_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/buffer.h"
+#include "sdn-switch.h"
+#include "sdn-controller.h"
+#include "sdn-control-header.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace sdn {
+
+// Trace file layout, in the recording machine's byte order (checked on open through the
+// header's byteOrder), every record 8-byte aligned so the file can be walked in place once
+// mapped:
+//
+//   SDNTraceFileHeader
+//   SDNTraceRecord, then its payload padded to a multiple of 8 bytes, repeated
+//
+// The payload is the message in SDNControlHeader's OpenFlow 1.0 encoding: inputs as they
+// travel to the controller, decisions as they travel to the switch. Ports are switch port
+// numbers, so a trace replays against any network built the same way.
+struct SDNTraceFileHeader {
+    char magic[8];        // "SDNTRACE"
+    uint32_t version;
+    uint32_t byteOrder;   // kTraceByteOrder as the writer stored it
+};
+
+struct SDNTraceRecord {
+    int64_t time;         // Simulation time in nanoseconds
+    uint32_t node;        // Node id of the switch
+    uint32_t size;        // Payload bytes; kTraceDecision set for a decision
+    uint64_t input;       // Input's own sequence number (from 1), or for a decision that of the
+                          // latest input recorded before it (0 if none)
+};
+
+const uint32_t kTraceVersion = 2;
+const uint32_t kTraceDecision = 0x80000000;
+const uint32_t kTraceByteOrder = 0x01020304;
+
+// Rounds a payload size up to the next record boundary
+inline uint32_t TracePaddedSize(uint32_t size)
+{
+    return (size + 7) & ~7u;
+}
+
+// Writes every message a controller handles (its ControlMessage trace) and every decision it
+// makes (its Decision trace) to FileName, for SDNTraceReplay. Messages are encoded into one
+// reused buffer and appended through the stream's own buffering.
+class SDNTraceRecorder : public Object
+{
+public:
+    static TypeId GetTypeId();
+    SDNTraceRecorder();
+    virtual ~SDNTraceRecorder();
+
+    // Records controller between Start and Stop
+    void Attach(Ptr<SDNController> controller);
+    // Truncates FileName and writes the file header
+    void Start();
+    // Flushes and closes the file
+    void Stop();
+
+    uint64_t GetNRecords() const;
+
+    // Node id a switch is recorded under: the node of its first port
+    static uint32_t GetNodeId(Ptr<SDNSwitch> swtch);
+
+protected:
+    virtual void DoDispose() override;
+
+private:
+    void RecordInput(Ptr<SDNSwitch> swtch, const controlPacket& ctrl, Ptr<NetDevice> port);
+    void RecordDecision(Ptr<SDNSwitch> swtch, const controlPacket& ctrl);
+    void Write(Ptr<SDNSwitch> swtch, const SDNControlHeader& header, bool decision);
+
+    std::string m_fileName;
+    std::ofstream m_file;
+    Buffer m_buffer;      // Encoding of the message being written
+    std::vector<Ptr<SDNController>> m_controllers;
+    uint64_t m_records;
+    uint64_t m_inputs;    // Sequence number of the latest input
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_TRACE_RECORDER_H
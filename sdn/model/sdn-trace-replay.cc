@@ -0,0 +1,288 @@
+#include "sdn-trace-replay.h"
+#include "sdn-control-header.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+namespace sdn {
+
+NS_LOG_COMPONENT_DEFINE("SDNTraceReplay");
+
+TypeId SDNTraceReplay::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::sdn::SDNTraceReplay")
+        .SetParent<Object>()
+        .SetGroupName("SDN")
+        .AddConstructor<SDNTraceReplay>()
+        .AddAttribute("Verify",
+                      "Compare the controller's decisions with the recorded ones",
+                      BooleanValue(true),
+                      MakeBooleanAccessor(&SDNTraceReplay::m_verify),
+                      MakeBooleanChecker());
+    return tid;
+}
+
+SDNTraceReplay::SDNTraceReplay()
+    : m_verify(true),
+      m_data(nullptr),
+      m_size(0),
+      m_input(0),
+      m_decision(0),
+      m_current(0),
+      m_inputs(0),
+      m_skipped(0),
+      m_decisions(0),
+      m_mismatches(0),
+      m_missing(0)
+{
+}
+
+SDNTraceReplay::~SDNTraceReplay()
+{
+    Close();
+}
+
+void SDNTraceReplay::DoDispose()
+{
+    if (m_controller && m_verify) {
+        m_controller->TraceDisconnectWithoutContext("Decision", MakeCallback(&SDNTraceReplay::CheckDecision, this));
+    }
+    if (m_controller) {
+        m_controller->SetDetached(false);
+    }
+    m_controller = nullptr;
+    m_switches.clear();
+    Close();
+    Object::DoDispose();
+}
+
+bool SDNTraceReplay::Open(const std::string& fileName)
+{
+    Close();
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        NS_LOG_WARN("SDNTraceReplay: Cannot open " << fileName);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SDNTraceFileHeader)) {
+        NS_LOG_WARN("SDNTraceReplay: " << fileName << " is too short for a trace");
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        NS_LOG_WARN("SDNTraceReplay: Cannot map " << fileName);
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = info.st_size;
+
+    const SDNTraceFileHeader* header = reinterpret_cast<const SDNTraceFileHeader*>(m_data);
+    if (std::memcmp(header->magic, "SDNTRACE", sizeof(header->magic)) != 0) {
+        NS_LOG_WARN("SDNTraceReplay: " << fileName << " is not a trace");
+        Close();
+        return false;
+    }
+    // Records are read in place, so a trace from a machine of the other byte order is unusable
+    if (header->byteOrder == __builtin_bswap32(kTraceByteOrder)) {
+        NS_LOG_WARN("SDNTraceReplay: " << fileName << " was written with a different byte order");
+        Close();
+        return false;
+    }
+    if (header->version != kTraceVersion || header->byteOrder != kTraceByteOrder) {
+        NS_LOG_WARN("SDNTraceReplay: " << fileName << " is not a version " << kTraceVersion << " trace");
+        Close();
+        return false;
+    }
+    // The kernel reads ahead of the sequential walk
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_input = Find(sizeof(SDNTraceFileHeader), false);
+    m_decision = Find(sizeof(SDNTraceFileHeader), true);
+    return true;
+}
+
+void SDNTraceReplay::Close()
+{
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_input = 0;
+    m_decision = 0;
+    m_current = 0;
+}
+
+void SDNTraceReplay::SetController(Ptr<SDNController> controller)
+{
+    m_controller = controller;
+}
+
+void SDNTraceReplay::AddSwitch(Ptr<SDNSwitch> swtch)
+{
+    m_switches[SDNTraceRecorder::GetNodeId(swtch)] = swtch;
+}
+
+const SDNTraceRecord& SDNTraceReplay::RecordAt(size_t offset) const
+{
+    return *reinterpret_cast<const SDNTraceRecord*>(m_data + offset);
+}
+
+const uint8_t* SDNTraceReplay::PayloadAt(size_t offset) const
+{
+    return m_data + offset + sizeof(SDNTraceRecord);
+}
+
+size_t SDNTraceReplay::NextOffset(size_t offset) const
+{
+    return offset + sizeof(SDNTraceRecord) + TracePaddedSize(RecordAt(offset).size & ~kTraceDecision);
+}
+
+// A record cut short (a trace still being written) ends the walk
+size_t SDNTraceReplay::Find(size_t offset, bool decision) const
+{
+    while (offset + sizeof(SDNTraceRecord) <= m_size && NextOffset(offset) <= m_size) {
+        if (((RecordAt(offset).size & kTraceDecision) != 0) == decision) return offset;
+        offset = NextOffset(offset);
+    }
+    return m_size;
+}
+
+void SDNTraceReplay::Start()
+{
+    if (!m_data || !m_controller) {
+        NS_LOG_WARN("SDNTraceReplay: Start without a trace or a controller");
+        return;
+    }
+    // Decisions must not reach the switches: they would answer barriers, time rules out and
+    // relay ARP, and the controller would hear of it on top of the recorded inputs
+    m_controller->SetDetached(true);
+    if (m_verify) {
+        m_controller->TraceConnectWithoutContext("Decision", MakeCallback(&SDNTraceReplay::CheckDecision, this));
+    }
+    if (m_input < m_size) {
+        Time first = NanoSeconds(RecordAt(m_input).time);
+        m_shift = Simulator::Now() > first ? Simulator::Now() - first : Time(0);
+    }
+    ScheduleNext();
+}
+
+void SDNTraceReplay::ScheduleNext()
+{
+    if (m_input >= m_size) return;
+    Time at = NanoSeconds(RecordAt(m_input).time) + m_shift;
+    Time now = Simulator::Now();
+    Simulator::Schedule(at > now ? at - now : Time(0), &SDNTraceReplay::ReplayNext, this);
+}
+
+void SDNTraceReplay::ReplayNext()
+{
+    const SDNTraceRecord& record = RecordAt(m_input);
+    const uint8_t* payload = PayloadAt(m_input);
+    m_input = Find(NextOffset(m_input), false);
+    // Decisions after a skipped input were recorded against it too
+    m_current = record.input;
+
+    auto found = m_switches.find(record.node);
+    if (found == m_switches.end() || found->second->m_devices.empty()) {
+        m_skipped++;
+        ScheduleNext();
+        return;
+    }
+    Ptr<SDNSwitch> swtch = found->second;
+
+    m_buffer.RemoveAtStart(m_buffer.GetSize());
+    m_buffer.AddAtStart(record.size);
+    m_buffer.Begin().Write(payload, record.size);
+    SDNControlHeader header(m_ctrl, swtch->m_devices.front()->GetNode());
+    header.Deserialize(m_buffer.Begin());
+
+    // The next input is scheduled first, so one handled synchronously keeps its place
+    ScheduleNext();
+    m_inputs++;
+    m_controller->HandlePacketIn(swtch, &m_ctrl, header.GetPort());
+}
+
+// Recorded decisions are in input order, so those of the current input are a run starting at
+// m_decision once the leftovers of earlier inputs are passed
+void SDNTraceReplay::CheckDecision(Ptr<SDNSwitch> swtch, const controlPacket& ctrl)
+{
+    m_decisions++;
+    while (m_decision < m_size && RecordAt(m_decision).input < m_current) {
+        m_missing++;
+        m_decision = Find(NextOffset(m_decision), true);
+    }
+
+    SDNControlHeader header(ctrl, SDNControlHeader::ToSwitch, nullptr);
+    uint32_t size = header.GetSerializedSize();
+    m_buffer.RemoveAtStart(m_buffer.GetSize());
+    m_buffer.AddAtStart(size);
+    header.Serialize(m_buffer.Begin());
+    m_encoded.resize(size);
+    m_buffer.CopyData(m_encoded.data(), size);
+
+    uint32_t node = SDNTraceRecorder::GetNodeId(swtch);
+    for (size_t offset = m_decision; offset < m_size && RecordAt(offset).input == m_current;
+         offset = Find(NextOffset(offset), true)) {
+        if (!Matches(offset, node, size)) continue;
+        // Recorded decisions of this input passed over were not made
+        for (; m_decision != offset; m_decision = Find(NextOffset(m_decision), true)) {
+            m_missing++;
+        }
+        m_decision = Find(NextOffset(offset), true);
+        return;
+    }
+    m_mismatches++;
+    NS_LOG_INFO("SDNTraceReplay: Decision " << m_decisions << " for switch node " << node
+                << " matches no recorded decision of input " << m_current);
+}
+
+bool SDNTraceReplay::Matches(size_t offset, uint32_t node, uint32_t size) const
+{
+    const SDNTraceRecord& record = RecordAt(offset);
+    return record.node == node && (record.size & ~kTraceDecision) == size
+        && std::memcmp(PayloadAt(offset), m_encoded.data(), size) == 0;
+}
+
+uint64_t SDNTraceReplay::GetNInputs() const
+{
+    return m_inputs;
+}
+
+uint64_t SDNTraceReplay::GetNSkipped() const
+{
+    return m_skipped;
+}
+
+uint64_t SDNTraceReplay::GetNDecisions() const
+{
+    return m_decisions;
+}
+
+uint64_t SDNTraceReplay::GetNMismatches() const
+{
+    return m_mismatches;
+}
+
+// Includes the unmatched recorded decisions of inputs replayed so far
+uint64_t SDNTraceReplay::GetNMissing() const
+{
+    uint64_t missing = m_missing;
+    for (size_t offset = m_decision; offset < m_size && RecordAt(offset).input <= m_current;
+         offset = Find(NextOffset(offset), true)) {
+        missing++;
+    }
+    return missing;
+}
+
+} // namespace sdn
+} // namespace ns3
@@ -0,0 +1,96 @@
+#ifndef SDN_TRACE_REPLAY_H
+#define SDN_TRACE_REPLAY_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/buffer.h"
+#include "sdn-switch.h"
+#include "sdn-controller.h"
+#include "sdn-trace-recorder.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+namespace sdn {
+
+// Feeds a trace written by SDNTraceRecorder back into a controller without simulating the
+// data plane. The file is mapped read-only and walked in place. Each input is decoded into
+// one reused controlPacket and handed to HandlePacketIn at its recorded time, by a chain of
+// one simulator event per input, so batch windows and control channel delays behave as
+// they did when recording.
+//
+// With Verify set, every decision the controller makes is compared byte for byte with the
+// recorded decisions of the same input, the ones made after it and before the next. A
+// decision none of them matches is a mismatch, a recorded decision never made is missing,
+// and neither shifts the comparison for later inputs. An unchanged controller matches all
+// of them; after a change to routing or flow placement, the two counts locate what changed.
+//
+// The network must be built the same way as the recorded one, so node ids and ports agree.
+// Start detaches the controller (SDNController::SetDetached), so its decisions are checked
+// but never delivered and the switches stay idle: only the replayed inputs reach it.
+class SDNTraceReplay : public Object
+{
+public:
+    static TypeId GetTypeId();
+    SDNTraceReplay();
+    virtual ~SDNTraceReplay();
+
+    // Maps fileName; false if it cannot be read or is not a trace
+    bool Open(const std::string& fileName);
+    void SetController(Ptr<SDNController> controller);
+    // Inputs from switches that were not added are skipped
+    void AddSwitch(Ptr<SDNSwitch> swtch);
+    // Schedules the first input at its recorded time, or now if that has passed; later
+    // inputs keep their recorded spacing
+    void Start();
+
+    uint64_t GetNInputs() const;       // Inputs handed to the controller
+    uint64_t GetNSkipped() const;
+    uint64_t GetNDecisions() const;    // Decisions made during the replay
+    uint64_t GetNMismatches() const;   // Of those, decisions no recorded one of the same input matches
+    uint64_t GetNMissing() const;      // Recorded decisions of replayed inputs that were not made
+
+protected:
+    virtual void DoDispose() override;
+
+private:
+    // Offset of the first record of the given kind at or after offset, m_size if none
+    size_t Find(size_t offset, bool decision) const;
+    const SDNTraceRecord& RecordAt(size_t offset) const;
+    const uint8_t* PayloadAt(size_t offset) const;
+    size_t NextOffset(size_t offset) const;
+    void ScheduleNext();
+    void ReplayNext();
+    void CheckDecision(Ptr<SDNSwitch> swtch, const controlPacket& ctrl);
+    bool Matches(size_t offset, uint32_t node, uint32_t size) const;
+    void Close();
+
+    Ptr<SDNController> m_controller;
+    std::unordered_map<uint32_t, Ptr<SDNSwitch>> m_switches;   // By node id
+    bool m_verify;
+
+    const uint8_t* m_data;   // Mapped file
+    size_t m_size;
+    size_t m_input;          // Offset of the next input
+    size_t m_decision;       // Offset of the first recorded decision not yet matched
+    uint64_t m_current;      // Sequence number of the latest replayed input
+    Time m_shift;            // Added to recorded times
+
+    controlPacket m_ctrl;    // Decoding target, reused by every input
+    Buffer m_buffer;         // Input being decoded, or replayed decision being encoded
+    std::vector<uint8_t> m_encoded;   // Replayed decision being compared
+
+    uint64_t m_inputs;
+    uint64_t m_skipped;
+    uint64_t m_decisions;
+    uint64_t m_mismatches;
+    uint64_t m_missing;
+};
+
+} // namespace sdn
+} // namespace ns3
+
+#endif // SDN_TRACE_REPLAY_H
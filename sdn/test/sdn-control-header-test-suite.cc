@@ -0,0 +1,245 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Round trips of SDNControlHeader through a packet, the way SDNInBandControlChannel sends
+messages, plus the length checks a truncated message must fail.
+
+*/
+
+namespace
+{
+
+// A switch node whose ports the header can resolve
+Ptr<Node> MakeSwitchNode(uint32_t ports)
+{
+    Ptr<Node> node = CreateObject<Node>();
+    for (uint32_t p = 0; p < ports; p++)
+    {
+        Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice>();
+        device->SetAddress(Mac48Address::Allocate());
+        node->AddDevice(device);
+    }
+    return node;
+}
+
+// Encodes ctrl into a packet and decodes it back into target; returns the bytes consumed
+uint32_t RoundTrip(const controlPacket& ctrl, SDNControlHeader::Direction direction, Ptr<Node> node,
+                   Ptr<NetDevice> port, controlPacket& target, SDNControlHeader& decoder)
+{
+    SDNControlHeader header(ctrl, direction, node);
+    header.SetPort(port);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    decoder = SDNControlHeader(target, node);
+    uint32_t consumed = packet->PeekHeader(decoder);
+    return consumed == packet->GetSize() ? consumed : 0;
+}
+
+} // namespace
+
+// A bulk FlowAdd keeps every rule's match, range, timeouts, priority, buffer and output port
+class SDNControlHeaderFlowAddTestCase : public TestCase
+{
+  public:
+    SDNControlHeaderFlowAddTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNControlHeaderFlowAddTestCase::SDNControlHeaderFlowAddTestCase()
+    : TestCase("Bulk FlowAdd survives encode and decode")
+{
+}
+
+void SDNControlHeaderFlowAddTestCase::DoRun()
+{
+    Ptr<Node> node = MakeSwitchNode(3);
+
+    controlPacket ctrl;
+    ctrl.type = FlowAdd;
+    ctrl.xid = 1234;
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        FlowMod mod;
+        mod.entry.srcIp = Ipv4Address("10.0.0.1");
+        mod.entry.dstIp = Ipv4Address(0x0a010000 + r);
+        mod.entry.srcPort = 1000 * r;
+        mod.entry.srcPortMax = r == 1 ? 1999 : 0;
+        mod.entry.dstPort = 80;
+        mod.entry.protocol = 17;
+        mod.entry.priority = 10 + r;
+        mod.entry.idleTimeout = 5;
+        mod.entry.hardTimeout = 60 + r;
+        mod.entry.outputDevice = node->GetDevice(r);
+        mod.bufferId = r == 2 ? kNoBuffer : 100 + r;
+        ctrl.flowMods.push_back(mod);
+    }
+    // A prefix rule with wildcarded ports and protocol
+    ctrl.flowMods[2].entry.srcMask = Ipv4Mask::GetZero();
+    ctrl.flowMods[2].entry.dstMask = Ipv4Mask("255.255.0.0");
+    ctrl.flowMods[2].entry.srcPort = 0;
+    ctrl.flowMods[2].entry.srcPortMax = 65535;
+    ctrl.flowMods[2].entry.anyProtocol = true;
+
+    controlPacket decoded;
+    SDNControlHeader decoder;
+    NS_TEST_ASSERT_MSG_NE(RoundTrip(ctrl, SDNControlHeader::ToSwitch, node, nullptr, decoded, decoder), 0,
+                          "Decoder did not consume the whole message");
+    NS_TEST_ASSERT_MSG_EQ(decoder.GetDirection(), SDNControlHeader::ToSwitch, "Wrong direction");
+    NS_TEST_ASSERT_MSG_EQ(decoded.type, FlowAdd, "Wrong type");
+    NS_TEST_ASSERT_MSG_EQ(decoded.xid, 1234, "Wrong xid");
+    NS_TEST_ASSERT_MSG_EQ(decoded.flowMods.size(), 3, "Wrong number of rules");
+    for (uint32_t r = 0; r < 3; r++)
+    {
+        const FlowEntry& sent = ctrl.flowMods[r].entry;
+        const FlowEntry& got = decoded.flowMods[r].entry;
+        NS_TEST_ASSERT_MSG_EQ(got.srcIp, sent.srcIp, "Wrong srcIp");
+        NS_TEST_ASSERT_MSG_EQ(got.dstIp, sent.dstIp, "Wrong dstIp");
+        NS_TEST_ASSERT_MSG_EQ(got.srcMask.Get(), sent.srcMask.Get(), "Wrong srcMask");
+        NS_TEST_ASSERT_MSG_EQ(got.dstMask.Get(), sent.dstMask.Get(), "Wrong dstMask");
+        NS_TEST_ASSERT_MSG_EQ(got.srcPort, sent.srcPort, "Wrong srcPort");
+        NS_TEST_ASSERT_MSG_EQ(got.srcPortMax, sent.srcPortMax, "Wrong srcPortMax");
+        NS_TEST_ASSERT_MSG_EQ(got.dstPort, sent.dstPort, "Wrong dstPort");
+        NS_TEST_ASSERT_MSG_EQ(got.anyProtocol, sent.anyProtocol, "Wrong anyProtocol");
+        NS_TEST_ASSERT_MSG_EQ(got.protocol, sent.protocol, "Wrong protocol");
+        NS_TEST_ASSERT_MSG_EQ(got.priority, sent.priority, "Wrong priority");
+        NS_TEST_ASSERT_MSG_EQ(got.idleTimeout, sent.idleTimeout, "Wrong idleTimeout");
+        NS_TEST_ASSERT_MSG_EQ(got.hardTimeout, sent.hardTimeout, "Wrong hardTimeout");
+        NS_TEST_ASSERT_MSG_EQ(got.outputDevice, sent.outputDevice, "Wrong output port");
+        NS_TEST_ASSERT_MSG_EQ(decoded.flowMods[r].bufferId, ctrl.flowMods[r].bufferId, "Wrong bufferId");
+    }
+
+    // Decoding a single rule into the same target clears the earlier bulk
+    controlPacket single;
+    single.type = FlowAdd;
+    single.flowEntry = ctrl.flowMods[0].entry;
+    single.bufferId = 7;
+    NS_TEST_ASSERT_MSG_NE(RoundTrip(single, SDNControlHeader::ToSwitch, node, nullptr, decoded, decoder), 0,
+                          "Decoder did not consume the whole message");
+    NS_TEST_ASSERT_MSG_EQ(decoded.flowMods.size(), 0, "Rules of the previous message left behind");
+    NS_TEST_ASSERT_MSG_EQ(decoded.flowEntry.dstIp, single.flowEntry.dstIp, "Wrong dstIp");
+    NS_TEST_ASSERT_MSG_EQ(decoded.flowEntry.outputDevice, node->GetDevice(0), "Wrong output port");
+    NS_TEST_ASSERT_MSG_EQ(decoded.bufferId, 7, "Wrong bufferId");
+
+    Simulator::Destroy();
+}
+
+// PacketIn, and an ARP cache update long enough to be split over several vendor messages
+class SDNControlHeaderMessagesTestCase : public TestCase
+{
+  public:
+    SDNControlHeaderMessagesTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNControlHeaderMessagesTestCase::SDNControlHeaderMessagesTestCase()
+    : TestCase("PacketIn and split ArpCacheUpdate survive encode and decode")
+{
+}
+
+void SDNControlHeaderMessagesTestCase::DoRun()
+{
+    Ptr<Node> node = MakeSwitchNode(2);
+
+    controlPacket packetIn;
+    packetIn.type = FlowAdd;
+    packetIn.xid = 42;
+    packetIn.srcIp = Ipv4Address("10.0.0.1");
+    packetIn.dstIp = Ipv4Address("10.0.0.2");
+    packetIn.srcPort = 49152;
+    packetIn.dstPort = 443;
+    packetIn.protocolNumber = 6;
+    packetIn.srcMac = Mac48Address("00:00:00:00:00:01");
+    packetIn.dstMac = Mac48Address("00:00:00:00:00:02");
+    packetIn.bufferId = 9;
+
+    controlPacket decoded;
+    SDNControlHeader decoder;
+    NS_TEST_ASSERT_MSG_NE(RoundTrip(packetIn, SDNControlHeader::ToController, node, node->GetDevice(1), decoded,
+                                    decoder), 0, "Decoder did not consume the whole message");
+    NS_TEST_ASSERT_MSG_EQ(decoder.GetDirection(), SDNControlHeader::ToController, "Wrong direction");
+    NS_TEST_ASSERT_MSG_EQ(decoder.GetPort(), node->GetDevice(1), "Wrong ingress port");
+    NS_TEST_ASSERT_MSG_EQ(decoded.type, FlowAdd, "A table miss should decode as a FlowAdd request");
+    NS_TEST_ASSERT_MSG_EQ(decoded.xid, 42, "Wrong xid");
+    NS_TEST_ASSERT_MSG_EQ(decoded.srcIp, packetIn.srcIp, "Wrong srcIp");
+    NS_TEST_ASSERT_MSG_EQ(decoded.dstIp, packetIn.dstIp, "Wrong dstIp");
+    NS_TEST_ASSERT_MSG_EQ(decoded.srcPort, packetIn.srcPort, "Wrong srcPort");
+    NS_TEST_ASSERT_MSG_EQ(decoded.dstPort, packetIn.dstPort, "Wrong dstPort");
+    NS_TEST_ASSERT_MSG_EQ(decoded.protocolNumber, packetIn.protocolNumber, "Wrong protocol");
+    NS_TEST_ASSERT_MSG_EQ(decoded.srcMac, packetIn.srcMac, "Wrong srcMac");
+    NS_TEST_ASSERT_MSG_EQ(decoded.dstMac, packetIn.dstMac, "Wrong dstMac");
+    NS_TEST_ASSERT_MSG_EQ(decoded.bufferId, 9, "Wrong bufferId");
+
+    // More bindings than one message's 16-bit length can hold
+    controlPacket update;
+    update.type = ArpCacheUpdate;
+    update.xid = 7;
+    for (uint32_t b = 0; b < 12000; b++)
+    {
+        update.arpEntries.push_back(std::make_pair(Ipv4Address(0x0a000000 + b), Address(Mac48Address::Allocate())));
+    }
+    NS_TEST_ASSERT_MSG_NE(RoundTrip(update, SDNControlHeader::ToSwitch, node, nullptr, decoded, decoder), 0,
+                          "Decoder did not consume every chained message");
+    NS_TEST_ASSERT_MSG_EQ(decoded.type, ArpCacheUpdate, "Wrong type");
+    NS_TEST_ASSERT_MSG_EQ(decoded.arpEntries.size(), update.arpEntries.size(), "Bindings lost across messages");
+    NS_TEST_ASSERT_MSG_EQ((decoded.arpEntries == update.arpEntries), true, "Bindings changed in transit");
+
+    Simulator::Destroy();
+}
+
+// A message whose length cannot hold its fixed body decodes as Error without over-reading
+class SDNControlHeaderTruncatedTestCase : public TestCase
+{
+  public:
+    SDNControlHeaderTruncatedTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNControlHeaderTruncatedTestCase::SDNControlHeaderTruncatedTestCase()
+    : TestCase("Messages shorter than their type allows decode as Error")
+{
+}
+
+void SDNControlHeaderTruncatedTestCase::DoRun()
+{
+    // ofp_header only: version 1, then PacketIn, FlowMod and a vendor message of 8 bytes
+    for (uint8_t type : {10, 14, 4})
+    {
+        const uint8_t bytes[8] = {1, type, 0, 8, 0, 0, 0, 5};
+        Ptr<Packet> packet = Create<Packet>(bytes, sizeof(bytes));
+        controlPacket decoded;
+        SDNControlHeader decoder(decoded, nullptr);
+        NS_TEST_ASSERT_MSG_EQ(packet->PeekHeader(decoder), 8, "Truncated message not skipped by its length");
+        NS_TEST_ASSERT_MSG_EQ(decoded.type, Error, "Truncated message accepted");
+        NS_TEST_ASSERT_MSG_EQ(decoded.xid, 5, "Header of a truncated message not read");
+    }
+}
+
+class SDNControlHeaderTestSuite : public TestSuite
+{
+  public:
+    SDNControlHeaderTestSuite();
+};
+
+SDNControlHeaderTestSuite::SDNControlHeaderTestSuite()
+    : TestSuite("sdn-control-header", Type::UNIT)
+{
+    AddTestCase(new SDNControlHeaderFlowAddTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNControlHeaderMessagesTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNControlHeaderTruncatedTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNControlHeaderTestSuite g_sdnControlHeaderTestSuite;
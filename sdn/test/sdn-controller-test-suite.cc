@@ -0,0 +1,164 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+#include <algorithm>
+#include <set>
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Control-plane tests for SDNController on networks built by SDNTopologyHelper.
+
+*/
+
+namespace
+{
+
+// The switch port whose link leads to node
+Ptr<NetDevice> PortToward(Ptr<SDNSwitch> swtch, Ptr<Node> node)
+{
+    for (const auto& port : swtch->m_devices)
+    {
+        Ptr<Channel> channel = port->GetChannel();
+        for (std::size_t d = 0; d < channel->GetNDevices(); d++)
+        {
+            if (channel->GetDevice(d)->GetNode() == node)
+            {
+                return port;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// The switch's rules towards dst, by first source port
+std::vector<FlowEntry> RulesToward(Ptr<SDNSwitch> swtch, Ipv4Address dst)
+{
+    std::vector<FlowEntry> rules;
+    for (const auto& entry : swtch->GetFlowTable()->GetAllEntries())
+    {
+        if (entry.dstIp == dst)
+        {
+            rules.push_back(entry);
+        }
+    }
+    std::sort(rules.begin(), rules.end(), [](const FlowEntry& a, const FlowEntry& b) {
+        return a.srcPort < b.srcPort;
+    });
+    return rules;
+}
+
+} // namespace
+
+// The helper registers switches before computing routes, which schedules the proactive
+// install; computing routes must not install the rules a second time
+class SDNProactiveInstallOnceTestCase : public TestCase
+{
+  public:
+    SDNProactiveInstallOnceTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNProactiveInstallOnceTestCase::SDNProactiveInstallOnceTestCase()
+    : TestCase("Proactive rules are installed once per switch and host")
+{
+}
+
+void SDNProactiveInstallOnceTestCase::DoRun()
+{
+    SDNTopologyHelper helper;
+    helper.SetControllerAttribute("ProactiveMode", BooleanValue(true));
+    SDNNetwork net = helper.Linear(3, 2);
+
+    Simulator::Stop(NanoSeconds(1));
+    Simulator::Run();
+
+    uint32_t hosts = net.hosts.GetN();
+    NS_TEST_ASSERT_MSG_EQ(net.controller->GetNFlowMods(), net.switches.size() * hosts,
+                          "Proactive rules installed more than once");
+    for (const auto& swtch : net.switches)
+    {
+        NS_TEST_ASSERT_MSG_EQ(swtch->GetFlowTable()->GetNEntries(), hosts, "Switch should hold one rule per host");
+    }
+
+    Simulator::Destroy();
+}
+
+// Losing or regaining an equal-cost hop rebuilds the proactive source port ranges over the
+// hops left, one range per hop, rather than moving each old range to a hop of its own
+class SDNProactiveRebuildTestCase : public TestCase
+{
+  public:
+    SDNProactiveRebuildTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNProactiveRebuildTestCase::SDNProactiveRebuildTestCase()
+    : TestCase("Proactive ranges are rebuilt over the equal-cost hops left")
+{
+}
+
+void SDNProactiveRebuildTestCase::DoRun()
+{
+    // Two leaves and three spines: leaf 0 has three equal-cost hops towards the host on leaf 1
+    SDNTopologyHelper helper;
+    helper.SetControllerAttribute("ProactiveMode", BooleanValue(true));
+    helper.SetControllerAttribute("MultipathMode", EnumValue(SDNController::Ecmp));
+    SDNNetwork net = helper.LeafSpine(2, 3, 1);
+
+    Simulator::Stop(NanoSeconds(1));
+    Simulator::Run();
+
+    Ptr<SDNSwitch> leaf = net.switches[0];
+    Ipv4Address dst = net.hostAddresses.GetAddress(1);
+    Ptr<NetDevice> uplink = PortToward(leaf, net.switchNodes.Get(2));
+    NS_TEST_ASSERT_MSG_NE(uplink, nullptr, "Leaf has no link to the first spine");
+
+    for (bool up : {false, true})
+    {
+        net.controller->SetLinkState(uplink, up);
+
+        std::vector<FlowEntry> rules = RulesToward(leaf, dst);
+        uint32_t hops = up ? 3 : 2;
+        NS_TEST_ASSERT_MSG_EQ(rules.size(), hops, "Expected one rule per equal-cost hop");
+
+        // Consecutive ranges covering every source port, each on a different live hop
+        std::set<Ptr<NetDevice>> ports;
+        uint32_t next = 0;
+        for (const auto& rule : rules)
+        {
+            NS_TEST_ASSERT_MSG_EQ(rule.srcPort, next, "Source port ranges overlap or leave a gap");
+            next = rule.srcPortMax + 1;
+            ports.insert(rule.outputDevice);
+            NS_TEST_ASSERT_MSG_EQ((up || rule.outputDevice != uplink), true, "Rule still uses the failed link");
+        }
+        NS_TEST_ASSERT_MSG_EQ(next, 65536, "Source port ranges do not reach the last port");
+        NS_TEST_ASSERT_MSG_EQ(ports.size(), hops, "Two ranges share a hop");
+    }
+
+    Simulator::Destroy();
+}
+
+class SDNControllerTestSuite : public TestSuite
+{
+  public:
+    SDNControllerTestSuite();
+};
+
+SDNControllerTestSuite::SDNControllerTestSuite()
+    : TestSuite("sdn-controller", Type::UNIT)
+{
+    AddTestCase(new SDNProactiveInstallOnceTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNProactiveRebuildTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNControllerTestSuite g_sdnControllerTestSuite;
@@ -0,0 +1,117 @@
+#include "ns3/core-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Tests for CuckooIndex, the exact-match index behind burst lookups. Every check runs
+at each SIMD level the build supports, since each level has its own probe code.
+
+*/
+
+namespace
+{
+
+FlowKey MakeKey(uint32_t i)
+{
+    FlowKey key;
+    key.srcIp = 0x0a000000 | (i >> 8);
+    key.dstIp = 0x0a010000 | (i & 0xff);
+    key.srcPort = 1000 + (i % 7);
+    key.dstPort = 80;
+    key.protocol = (i % 2) ? 17 : 6;
+    return key;
+}
+
+} // namespace
+
+// Inserts enough keys to force displacements and growth, then checks every lookup path
+class SDNCuckooIndexLookupTestCase : public TestCase
+{
+  public:
+    SDNCuckooIndexLookupTestCase(CuckooIndex::SimdLevel level);
+
+  private:
+    void DoRun() override;
+
+    CuckooIndex::SimdLevel m_level;
+};
+
+SDNCuckooIndexLookupTestCase::SDNCuckooIndexLookupTestCase(CuckooIndex::SimdLevel level)
+    : TestCase("Insert, find, update and erase at SIMD level " + std::to_string(level)),
+      m_level(level)
+{
+}
+
+void SDNCuckooIndexLookupTestCase::DoRun()
+{
+    const uint32_t keys = 5000;
+    CuckooIndex index;
+    index.SetSimdLevel(m_level);
+    uint32_t buckets = index.GetNBuckets();
+
+    for (uint32_t i = 0; i < keys; i++)
+    {
+        index.Insert(MakeKey(i), i);
+    }
+    NS_TEST_ASSERT_MSG_EQ(index.GetSize(), keys, "Wrong size after inserts");
+    NS_TEST_ASSERT_MSG_GT(index.GetNBuckets(), buckets, "Index should have grown");
+    NS_TEST_ASSERT_MSG_EQ(index.GetSimdLevel(), std::min(m_level, CuckooIndex::GetSupportedSimdLevel()),
+                          "SIMD level not clamped to what the CPU supports");
+
+    for (uint32_t i = 0; i < keys; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(index.Find(MakeKey(i)), i, "Key lost after growth");
+    }
+    NS_TEST_ASSERT_MSG_EQ(index.Find(MakeKey(keys)), kNoFlow, "Absent key found");
+
+    // A burst longer than one prefetch group, with misses mixed in
+    std::vector<FlowKey> burst;
+    for (uint32_t i = 0; i < 40; i++)
+    {
+        burst.push_back(MakeKey(i % 2 ? i * 97 : keys + i));
+    }
+    std::vector<FlowId> ids(burst.size());
+    index.FindBatch(burst.data(), burst.size(), ids.data());
+    for (uint32_t i = 0; i < burst.size(); i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(ids[i], index.Find(burst[i]), "Batch lookup disagrees with Find");
+    }
+
+    // Reinserting a key repoints it instead of adding a second copy
+    index.Insert(MakeKey(7), 70000);
+    NS_TEST_ASSERT_MSG_EQ(index.GetSize(), keys, "Reinsert added a key");
+    NS_TEST_ASSERT_MSG_EQ(index.Find(MakeKey(7)), 70000, "Reinsert did not update the id");
+
+    for (uint32_t i = 0; i < keys; i += 2)
+    {
+        index.Erase(MakeKey(i));
+    }
+    index.Erase(MakeKey(keys));
+    NS_TEST_ASSERT_MSG_EQ(index.GetSize(), keys / 2, "Wrong size after erases");
+    for (uint32_t i = 0; i < keys; i++)
+    {
+        FlowId expected = (i % 2) ? (i == 7 ? 70000 : i) : kNoFlow;
+        NS_TEST_ASSERT_MSG_EQ(index.Find(MakeKey(i)), expected, "Erase removed the wrong keys");
+    }
+}
+
+class SDNCuckooIndexTestSuite : public TestSuite
+{
+  public:
+    SDNCuckooIndexTestSuite();
+};
+
+SDNCuckooIndexTestSuite::SDNCuckooIndexTestSuite()
+    : TestSuite("sdn-cuckoo-index", Type::UNIT)
+{
+    AddTestCase(new SDNCuckooIndexLookupTestCase(CuckooIndex::Scalar), TestCase::Duration::QUICK);
+    AddTestCase(new SDNCuckooIndexLookupTestCase(CuckooIndex::Sse2), TestCase::Duration::QUICK);
+    AddTestCase(new SDNCuckooIndexLookupTestCase(CuckooIndex::Avx2), TestCase::Duration::QUICK);
+}
+
+static SDNCuckooIndexTestSuite g_sdnCuckooIndexTestSuite;
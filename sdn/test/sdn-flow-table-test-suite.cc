@@ -0,0 +1,248 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Matching tests for SDNFlowTable: exact, wildcard and port-range rules spread over
+several tuples, with priorities deciding between overlapping rules.
+
+*/
+
+namespace
+{
+
+FlowEntry MakeEntry(const char* src, const char* dst, uint16_t srcPort, uint16_t dstPort,
+                    Ptr<NetDevice> device)
+{
+    FlowEntry entry;
+    entry.srcIp = Ipv4Address(src);
+    entry.dstIp = Ipv4Address(dst);
+    entry.srcPort = srcPort;
+    entry.dstPort = dstPort;
+    entry.protocol = 17;
+    entry.outputDevice = device;
+    return entry;
+}
+
+} // namespace
+
+// Each distinct mask gets its own tuple; a key only matches rules whose masked fields agree
+class SDNFlowTableTupleTestCase : public TestCase
+{
+  public:
+    SDNFlowTableTupleTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNFlowTableTupleTestCase::SDNFlowTableTupleTestCase()
+    : TestCase("Exact, prefix and port-range rules match through their tuples")
+{
+}
+
+void SDNFlowTableTupleTestCase::DoRun()
+{
+    Ptr<SDNFlowTable> table = CreateObject<SDNFlowTable>();
+    Ptr<NetDevice> exactPort = CreateObject<SimpleNetDevice>();
+    Ptr<NetDevice> prefixPort = CreateObject<SimpleNetDevice>();
+    Ptr<NetDevice> rangePort = CreateObject<SimpleNetDevice>();
+
+    FlowEntry exact = MakeEntry("10.0.0.1", "10.0.1.1", 1000, 2000, exactPort);
+    FlowEntry prefix = MakeEntry("0.0.0.0", "10.0.2.0", 0, 0, prefixPort);
+    prefix.srcMask = Ipv4Mask::GetZero();
+    prefix.dstMask = Ipv4Mask("255.255.255.0");
+    prefix.srcPortMax = 0xffff;
+    prefix.dstPortMax = 0xffff;
+    prefix.anyProtocol = true;
+    FlowEntry range = MakeEntry("10.0.0.1", "10.0.3.1", 5000, 80, rangePort);
+    range.srcPortMax = 5999;
+
+    FlowId exactId = table->AddFlowEntry(exact);
+    FlowId prefixId = table->AddFlowEntry(prefix);
+    FlowId rangeId = table->AddFlowEntry(range);
+    NS_TEST_ASSERT_MSG_EQ(table->GetNEntries(), 3, "Three rules installed");
+    NS_TEST_ASSERT_MSG_EQ(table->GetNTuples(), 3, "Each mask should get its own tuple");
+
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.1.1"), 1000, 2000, 17),
+                          exactId, "Exact rule not matched");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.1.1"), 1001, 2000, 17),
+                          kNoFlow, "Exact rule matched a different source port");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("192.168.0.7"), Ipv4Address("10.0.2.99"), 1, 2, 6),
+                          prefixId, "Prefix rule not matched");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("192.168.0.7"), Ipv4Address("10.0.4.1"), 1, 2, 6),
+                          kNoFlow, "Prefix rule matched outside its prefix");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.3.1"), 5999, 80, 17),
+                          rangeId, "Port-range rule not matched at its upper bound");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.3.1"), 6000, 80, 17),
+                          kNoFlow, "Port-range rule matched past its upper bound");
+    NS_TEST_ASSERT_MSG_EQ(table->GetOutputDevice(rangeId), rangePort, "Wrong action stored");
+
+    // The burst lookup must agree with the per-key one
+    FlowKey keys[3] = {SDNFlowTable::MakeFlowKey(exact), SDNFlowTable::MakeFlowKey(range),
+                       SDNFlowTable::MakeFlowKey(MakeEntry("10.9.9.9", "10.9.9.9", 1, 1, nullptr))};
+    FlowId flows[3];
+    table->FindMatchingFlows(keys, 3, flows);
+    NS_TEST_ASSERT_MSG_EQ(flows[0], exactId, "Burst lookup missed the exact rule");
+    NS_TEST_ASSERT_MSG_EQ(flows[1], rangeId, "Burst lookup missed the range rule");
+    NS_TEST_ASSERT_MSG_EQ(flows[2], kNoFlow, "Burst lookup matched an unknown key");
+
+    NS_TEST_ASSERT_MSG_EQ(table->RemoveFlowEntry(prefix), true, "Prefix rule not removed");
+    NS_TEST_ASSERT_MSG_EQ(table->GetNTuples(), 2, "Empty tuple not dropped");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("192.168.0.7"), Ipv4Address("10.0.2.99"), 1, 2, 6),
+                          kNoFlow, "Removed rule still matched");
+    NS_TEST_ASSERT_MSG_EQ(table->RemoveFlowEntry(prefix), false, "Rule removed twice");
+
+    Simulator::Destroy();
+}
+
+// Where rules overlap, the highest priority wins whichever tuple it sits in
+class SDNFlowTablePriorityTestCase : public TestCase
+{
+  public:
+    SDNFlowTablePriorityTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNFlowTablePriorityTestCase::SDNFlowTablePriorityTestCase()
+    : TestCase("The highest-priority overlapping rule wins")
+{
+}
+
+void SDNFlowTablePriorityTestCase::DoRun()
+{
+    Ptr<SDNFlowTable> table = CreateObject<SDNFlowTable>();
+    Ptr<NetDevice> port = CreateObject<SimpleNetDevice>();
+
+    // A catch-all under a more specific rule for the same destination subnet
+    FlowEntry any = MakeEntry("0.0.0.0", "0.0.0.0", 0, 0, port);
+    any.srcMask = Ipv4Mask::GetZero();
+    any.dstMask = Ipv4Mask::GetZero();
+    any.srcPortMax = 0xffff;
+    any.dstPortMax = 0xffff;
+    any.anyProtocol = true;
+    any.priority = 1;
+    FlowEntry subnet = any;
+    subnet.dstIp = Ipv4Address("10.0.1.0");
+    subnet.dstMask = Ipv4Mask("255.255.255.0");
+    subnet.priority = 10;
+    FlowEntry exact = MakeEntry("10.0.0.1", "10.0.1.1", 1000, 2000, port);
+    exact.priority = 5;
+
+    FlowId anyId = table->AddFlowEntry(any);
+    FlowId subnetId = table->AddFlowEntry(subnet);
+    FlowId exactId = table->AddFlowEntry(exact);
+
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.1.1"), 1000, 2000, 17),
+                          subnetId, "Higher-priority wildcard should beat the exact rule");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.9.1"), 1000, 2000, 17),
+                          anyId, "Catch-all not matched");
+
+    // Reinstalling the same match and priority overwrites the rule in place
+    Ptr<NetDevice> newPort = CreateObject<SimpleNetDevice>();
+    exact.outputDevice = newPort;
+    NS_TEST_ASSERT_MSG_EQ(table->AddFlowEntry(exact), exactId, "Overwritten rule changed id");
+    NS_TEST_ASSERT_MSG_EQ(table->GetNEntries(), 3, "Overwrite added a rule");
+    NS_TEST_ASSERT_MSG_EQ(table->GetOutputDevice(exactId), newPort, "Overwrite kept the old action");
+
+    // The same match at a higher priority is a separate rule, and now outranks the subnet
+    exact.priority = 20;
+    FlowId raisedId = table->AddFlowEntry(exact);
+    NS_TEST_ASSERT_MSG_NE(raisedId, exactId, "Higher priority should install a new rule");
+    NS_TEST_ASSERT_MSG_EQ(table->GetNEntries(), 4, "Higher-priority rule not added");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(Ipv4Address("10.0.0.1"), Ipv4Address("10.0.1.1"), 1000, 2000, 17),
+                          raisedId, "Raised exact rule should now win");
+
+    Simulator::Destroy();
+}
+
+// Removed rules return their FlowId to a free list; a reused id must carry only the new rule
+class SDNFlowTableFreeListTestCase : public TestCase
+{
+  public:
+    SDNFlowTableFreeListTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNFlowTableFreeListTestCase::SDNFlowTableFreeListTestCase()
+    : TestCase("Freed FlowIds are reused without stale match, stats or action")
+{
+}
+
+void SDNFlowTableFreeListTestCase::DoRun()
+{
+    Ptr<SDNFlowTable> table = CreateObject<SDNFlowTable>();
+    Ptr<NetDevice> oldPort = CreateObject<SimpleNetDevice>();
+    Ptr<NetDevice> newPort = CreateObject<SimpleNetDevice>();
+
+    std::vector<FlowEntry> entries;
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        entries.push_back(MakeEntry("10.0.0.1", "10.0.1.1", 1000 + i, 2000, oldPort));
+        NS_TEST_ASSERT_MSG_EQ(table->AddFlowEntry(entries[i]), i, "Ids should be handed out densely");
+    }
+    table->UpdateFlowStats(1, 5, 500);
+    table->UpdateFlowStats(2, 7, 700);
+
+    NS_TEST_ASSERT_MSG_EQ(table->RemoveFlowEntry(entries[1]), true, "Rule 1 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table->RemoveFlowEntry(entries[2]), true, "Rule 2 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table->GetNEntries(), 2, "Wrong count after removals");
+
+    // The most recently freed id comes back first, then the next, then the arrays grow
+    FlowEntry reused = MakeEntry("10.0.0.2", "10.0.1.2", 3000, 4000, newPort);
+    NS_TEST_ASSERT_MSG_EQ(table->AddFlowEntry(reused), 2, "Last freed id not reused");
+    NS_TEST_ASSERT_MSG_EQ(table->AddFlowEntry(MakeEntry("10.0.0.3", "10.0.1.3", 1, 1, newPort)), 1,
+                          "Earlier freed id not reused");
+    NS_TEST_ASSERT_MSG_EQ(table->AddFlowEntry(MakeEntry("10.0.0.4", "10.0.1.4", 1, 1, newPort)), 4,
+                          "Table should grow once the free list is empty");
+
+    FlowEntry entry = table->GetEntry(2);
+    NS_TEST_ASSERT_MSG_EQ(entry.srcIp, reused.srcIp, "Reused id kept the old match");
+    NS_TEST_ASSERT_MSG_EQ(entry.srcPort, 3000, "Reused id kept the old match");
+    NS_TEST_ASSERT_MSG_EQ(entry.packetCount, 0, "Reused id kept the old packet count");
+    NS_TEST_ASSERT_MSG_EQ(entry.byteCount, 0, "Reused id kept the old byte count");
+    NS_TEST_ASSERT_MSG_EQ(table->GetOutputDevice(2), newPort, "Reused id kept the old action");
+
+    // The freed rules no longer match; the survivors still do
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(SDNFlowTable::MakeFlowKey(entries[2])), kNoFlow,
+                          "Removed rule matched through its reused id");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(SDNFlowTable::MakeFlowKey(entries[3])), 3,
+                          "Surviving rule lost");
+    NS_TEST_ASSERT_MSG_EQ(table->FindMatchingFlow(SDNFlowTable::MakeFlowKey(reused)), 2,
+                          "New rule not found under its reused id");
+
+    // Removing through the visitor frees ids the same way
+    uint32_t removed = table->UpdateEntries([&](FlowEntry& e) { return e.outputDevice != oldPort; });
+    NS_TEST_ASSERT_MSG_EQ(removed, 2, "Visitor should remove the two old rules");
+    NS_TEST_ASSERT_MSG_EQ(table->GetNEntries(), 3, "Wrong count after visitor removal");
+    NS_TEST_ASSERT_MSG_EQ(table->GetAllEntries().size(), 3, "GetAllEntries disagrees with GetNEntries");
+    NS_TEST_ASSERT_MSG_LT(table->AddFlowEntry(entries[0]), 5, "Visitor removals not recycled");
+
+    Simulator::Destroy();
+}
+
+class SDNFlowTableTestSuite : public TestSuite
+{
+  public:
+    SDNFlowTableTestSuite();
+};
+
+SDNFlowTableTestSuite::SDNFlowTableTestSuite()
+    : TestSuite("sdn-flow-table", Type::UNIT)
+{
+    AddTestCase(new SDNFlowTableTupleTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNFlowTablePriorityTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNFlowTableFreeListTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNFlowTableTestSuite g_sdnFlowTableTestSuite;
@@ -0,0 +1,126 @@
+#include "ns3/core-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Tests for LatencyHistogram: bucket placement at the power-of-two edges, including the
+open-ended last bucket, and the quantiles, mean and max derived from the buckets.
+
+*/
+
+// Each sample lands in the one bucket whose range holds it
+class SDNLatencyHistogramBucketTestCase : public TestCase
+{
+  public:
+    SDNLatencyHistogramBucketTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNLatencyHistogramBucketTestCase::SDNLatencyHistogramBucketTestCase()
+    : TestCase("Samples land in the power-of-two bucket holding them")
+{
+}
+
+void SDNLatencyHistogramBucketTestCase::DoRun()
+{
+    const uint32_t last = LatencyHistogram::kBuckets - 1;
+
+    NS_TEST_ASSERT_MSG_EQ(LatencyHistogram::GetBucketLimit(0), NanoSeconds(0), "Bucket 0 holds only 0 ns");
+    NS_TEST_ASSERT_MSG_EQ(LatencyHistogram::GetBucketLimit(last), Time::Max(), "Last bucket should be open-ended");
+    NS_TEST_ASSERT_MSG_EQ(LatencyHistogram::GetBucketLimit(last - 1), NanoSeconds((uint64_t(1) << 46) - 1),
+                          "Last bucket should start at 2^46 ns");
+
+    // Both edges of every closed bucket, and values past the last edge
+    for (uint32_t bucket = 1; bucket < last; bucket++)
+    {
+        LatencyHistogram histogram;
+        histogram.Add(NanoSeconds(uint64_t(1) << (bucket - 1)));
+        histogram.Add(LatencyHistogram::GetBucketLimit(bucket));
+        NS_TEST_ASSERT_MSG_EQ(histogram.GetBucketCount(bucket), 2, "Bucket edge placed in the wrong bucket");
+    }
+
+    LatencyHistogram histogram;
+    histogram.Add(NanoSeconds(0));
+    histogram.Add(NanoSeconds(-5));                 // Negative durations count as 0
+    histogram.Add(NanoSeconds(uint64_t(1) << 46));
+    histogram.Add(Seconds(86400));
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucketCount(0), 2, "Zero and negative samples not in bucket 0");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucketCount(last - 1), 0, "2^46 ns placed below the last bucket");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucketCount(last), 2, "Large samples not in the last bucket");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetCount(), 4, "Wrong sample count");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetMax(), Seconds(86400), "Wrong max");
+}
+
+// Quantiles report their bucket's upper bound, capped by the largest sample
+class SDNLatencyHistogramQuantileTestCase : public TestCase
+{
+  public:
+    SDNLatencyHistogramQuantileTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNLatencyHistogramQuantileTestCase::SDNLatencyHistogramQuantileTestCase()
+    : TestCase("Quantiles, mean and max, alone and merged")
+{
+}
+
+void SDNLatencyHistogramQuantileTestCase::DoRun()
+{
+    LatencyHistogram empty;
+    NS_TEST_ASSERT_MSG_EQ(empty.GetQuantile(0.5), NanoSeconds(0), "Empty histogram has a median");
+    NS_TEST_ASSERT_MSG_EQ(empty.GetMean(), NanoSeconds(0), "Empty histogram has a mean");
+
+    // 90 fast samples in [64, 128) ns and 10 slow ones in [8192, 16384) ns, split over two histograms
+    LatencyHistogram whole;
+    LatencyHistogram first;
+    LatencyHistogram second;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        Time sample = i < 90 ? NanoSeconds(100) : NanoSeconds(10000);
+        whole.Add(sample);
+        (i % 2 ? first : second).Add(sample);
+    }
+    first.Merge(second);
+
+    for (const LatencyHistogram* histogram : {&whole, &first})
+    {
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetCount(), 100, "Wrong sample count");
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetMean(), NanoSeconds(1090), "Wrong mean");
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetMax(), NanoSeconds(10000), "Wrong max");
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetQuantile(0), NanoSeconds(127), "Wrong minimum quantile");
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetQuantile(0.5), NanoSeconds(127), "Wrong median");
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetQuantile(0.9), NanoSeconds(127), "Wrong 90th percentile");
+        // The slow samples' bucket reaches 16383 ns, but no sample went past 10000 ns
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetQuantile(0.91), NanoSeconds(10000), "Quantile not capped by the max");
+        NS_TEST_ASSERT_MSG_EQ(histogram->GetQuantile(1), NanoSeconds(10000), "Wrong maximum quantile");
+    }
+
+    first.Reset();
+    NS_TEST_ASSERT_MSG_EQ(first.GetCount(), 0, "Reset kept samples");
+    NS_TEST_ASSERT_MSG_EQ(first.GetMax(), NanoSeconds(0), "Reset kept the max");
+    NS_TEST_ASSERT_MSG_EQ(first.GetBucketCount(7), 0, "Reset kept bucket counts");
+}
+
+class SDNLatencyHistogramTestSuite : public TestSuite
+{
+  public:
+    SDNLatencyHistogramTestSuite();
+};
+
+SDNLatencyHistogramTestSuite::SDNLatencyHistogramTestSuite()
+    : TestSuite("sdn-latency-histogram", Type::UNIT)
+{
+    AddTestCase(new SDNLatencyHistogramBucketTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNLatencyHistogramQuantileTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNLatencyHistogramTestSuite g_sdnLatencyHistogramTestSuite;
@@ -0,0 +1,189 @@
+#include "ns3/core-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+#include <map>
+#include <random>
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Tests for LpmTable, the DIR-16-8-8 longest-prefix-match table. Prefixes are chosen to
+land in each level (/16 and shorter in the top array, /17-/24 and /25-/32 in groups).
+
+*/
+
+namespace
+{
+
+uint32_t Addr(const char* address)
+{
+    return Ipv4Address(address).Get();
+}
+
+} // namespace
+
+// Nested prefixes across all three levels, then removals that must uncover the next longest
+class SDNLpmTableNestedTestCase : public TestCase
+{
+  public:
+    SDNLpmTableNestedTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNLpmTableNestedTestCase::SDNLpmTableNestedTestCase()
+    : TestCase("Nested prefixes match longest first and reappear on removal")
+{
+}
+
+void SDNLpmTableNestedTestCase::DoRun()
+{
+    LpmTable table;
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), LpmTable::kNoMatch, "Empty table matched");
+
+    table.Insert(Addr("10.0.0.0"), 8, 8);
+    table.Insert(Addr("10.1.2.3"), 32, 32);
+    table.Insert(Addr("10.1.2.0"), 24, 24);   // Shorter than the /32 inside it: must not overwrite it
+    table.Insert(Addr("10.1.0.0"), 16, 16);
+    table.Insert(Addr("10.1.2.128"), 25, 25);
+    NS_TEST_ASSERT_MSG_EQ(table.GetNPrefixes(), 5, "Wrong prefix count");
+
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), 32, "/32 not preferred");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.4")), 24, "/24 not matched");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.200")), 25, "/25 not matched");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.3.1")), 16, "/16 not matched");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.2.0.1")), 8, "/8 not matched");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("11.0.0.1")), LpmTable::kNoMatch, "Address outside every prefix matched");
+
+    // Reinserting a prefix replaces its value only
+    table.Insert(Addr("10.1.2.0"), 24, 240);
+    NS_TEST_ASSERT_MSG_EQ(table.GetNPrefixes(), 5, "Reinsert added a prefix");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.4")), 240, "Reinsert did not update the value");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), 32, "Reinsert overwrote a longer prefix");
+
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.1.2.0"), 23), false, "Removed a prefix never inserted");
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.1.2.3"), 32), true, "/32 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), 240, "/24 not restored under the removed /32");
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.1.2.0"), 24), true, "/24 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), 16, "/16 not restored under the removed /24");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.200")), 25, "Removing the /24 dropped the /25 inside it");
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.1.2.0"), 24), false, "Prefix removed twice");
+
+    // Removing a short prefix leaves the longer ones inside it alone
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.0.0.0"), 8), true, "/8 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.2.0.1")), LpmTable::kNoMatch, "Removed /8 still matched");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.3.1")), 16, "Removing the /8 dropped the /16");
+
+    // Once only short prefixes remain, every group has been handed back
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.1.2.128"), 25), true, "/25 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table.GetNGroups(), 0, "Groups not collapsed after their prefixes went");
+    NS_TEST_ASSERT_MSG_EQ(table.Remove(Addr("10.1.0.0"), 16), true, "/16 not removed");
+    NS_TEST_ASSERT_MSG_EQ(table.GetNPrefixes(), 0, "Prefixes left in an emptied table");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), LpmTable::kNoMatch, "Emptied table matched");
+
+    // A default route covers everything
+    table.Insert(0, 0, 7);
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("192.168.1.1")), 7, "Default route not matched");
+    table.Clear();
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("192.168.1.1")), LpmTable::kNoMatch, "Clear kept the default route");
+}
+
+// Random inserts and removes, checked against a linear scan over the live prefixes
+class SDNLpmTableRandomTestCase : public TestCase
+{
+  public:
+    SDNLpmTableRandomTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNLpmTableRandomTestCase::SDNLpmTableRandomTestCase()
+    : TestCase("Random inserts and removes agree with a linear scan")
+{
+}
+
+void SDNLpmTableRandomTestCase::DoRun()
+{
+    LpmTable table;
+    std::map<std::pair<uint32_t, uint8_t>, uint32_t> reference;
+    std::mt19937 rng(1);
+
+    // Prefixes share the 10.1/16 region so that they overlap at every level
+    auto randomPrefix = [&rng](uint8_t& length) {
+        length = 8 + rng() % 25;
+        uint32_t mask = length ? ~0u << (32 - length) : 0;
+        return (0x0a010000 | (rng() & 0x0000ffff)) & mask;
+    };
+    auto scan = [&reference](uint32_t address) {
+        uint32_t value = LpmTable::kNoMatch;
+        int best = -1;
+        for (const auto& rule : reference)
+        {
+            uint8_t length = rule.first.second;
+            uint32_t mask = length ? ~0u << (32 - length) : 0;
+            if ((address & mask) == rule.first.first && length > best)
+            {
+                best = length;
+                value = rule.second;
+            }
+        }
+        return value;
+    };
+
+    for (uint32_t round = 0; round < 2000; round++)
+    {
+        uint8_t length;
+        uint32_t prefix = randomPrefix(length);
+        if (rng() % 3 == 0 && !reference.empty())
+        {
+            // Remove a live prefix
+            auto rule = reference.begin();
+            std::advance(rule, rng() % reference.size());
+            NS_TEST_ASSERT_MSG_EQ(table.Remove(rule->first.first, rule->first.second), true, "Live prefix not removed");
+            reference.erase(rule);
+        }
+        else
+        {
+            uint32_t value = rng() % 1000;
+            table.Insert(prefix, length, value);
+            reference[{prefix, length}] = value;
+        }
+        NS_TEST_ASSERT_MSG_EQ(table.GetNPrefixes(), reference.size(), "Prefix count drifted");
+
+        for (uint32_t probe = 0; probe < 8; probe++)
+        {
+            uint32_t address = 0x0a010000 | (rng() & 0x0000ffff);
+            NS_TEST_ASSERT_MSG_EQ(table.Lookup(address), scan(address), "Lookup disagrees with a linear scan");
+        }
+    }
+
+    while (!reference.empty())
+    {
+        NS_TEST_ASSERT_MSG_EQ(table.Remove(reference.begin()->first.first, reference.begin()->first.second), true,
+                              "Live prefix not removed");
+        reference.erase(reference.begin());
+    }
+    NS_TEST_ASSERT_MSG_EQ(table.GetNGroups(), 0, "Groups leaked after removing every prefix");
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(Addr("10.1.2.3")), LpmTable::kNoMatch, "Emptied table matched");
+}
+
+class SDNLpmTableTestSuite : public TestSuite
+{
+  public:
+    SDNLpmTableTestSuite();
+};
+
+SDNLpmTableTestSuite::SDNLpmTableTestSuite()
+    : TestSuite("sdn-lpm-table", Type::UNIT)
+{
+    AddTestCase(new SDNLpmTableNestedTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNLpmTableRandomTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNLpmTableTestSuite g_sdnLpmTableTestSuite;
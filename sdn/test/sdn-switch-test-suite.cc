@@ -0,0 +1,231 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Datapath tests for SDNSwitch, driven through ReceivePacket on a network from
+SDNTopologyHelper so the controller's routes are real.
+
+*/
+
+namespace
+{
+
+// A UDP datagram as a switch port sees it: IPv4 header first
+Ptr<Packet> MakeUdpPacket(Ipv4Address src, Ipv4Address dst, uint16_t srcPort, uint16_t dstPort)
+{
+    Ptr<Packet> packet = Create<Packet>(64);
+    UdpHeader udp;
+    udp.SetSourcePort(srcPort);
+    udp.SetDestinationPort(dstPort);
+    packet->AddHeader(udp);
+    Ipv4Header ip;
+    ip.SetSource(src);
+    ip.SetDestination(dst);
+    ip.SetProtocol(17);
+    ip.SetPayloadSize(packet->GetSize());
+    ip.SetTtl(64);
+    packet->AddHeader(ip);
+    return packet;
+}
+
+// The switch port whose link leads to host
+Ptr<NetDevice> PortToward(Ptr<SDNSwitch> swtch, Ptr<Node> host)
+{
+    for (const auto& port : swtch->m_devices)
+    {
+        Ptr<Channel> channel = port->GetChannel();
+        for (std::size_t d = 0; d < channel->GetNDevices(); d++)
+        {
+            if (channel->GetDevice(d)->GetNode() == host)
+            {
+                return port;
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Loses every message to the switch, as an overloaded or lossy control path would
+class LossyControlChannel : public SDNControlChannel
+{
+  public:
+    bool SendToSwitch(Ptr<SDNSwitch> swtch, const controlPacket& ctrl) override
+    {
+        return false;
+    }
+};
+
+} // namespace
+
+// A miss early in a lookup burst installs a rule that evicts another from a full table and
+// takes over its FlowId. A later packet of the evicted flow in the same burst must not be
+// forwarded by the id its batch lookup returned.
+class SDNBurstEvictionTestCase : public TestCase
+{
+  public:
+    SDNBurstEvictionTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNBurstEvictionTestCase::SDNBurstEvictionTestCase()
+    : TestCase("Burst lookups are redone after an install evicts a rule")
+{
+}
+
+void SDNBurstEvictionTestCase::DoRun()
+{
+    SDNTopologyHelper helper;
+    helper.SetFlowTableAttribute("MaxEntries", UintegerValue(1));
+    helper.SetSwitchAttribute("LookupBurst", UintegerValue(8));
+    SDNNetwork net = helper.Linear(1, 3);
+
+    Ptr<SDNSwitch> swtch = net.switches[0];
+    Ptr<NetDevice> inPort = PortToward(swtch, net.hosts.Get(0));
+    Ptr<NetDevice> portA = PortToward(swtch, net.hosts.Get(1));
+    Ptr<NetDevice> portB = PortToward(swtch, net.hosts.Get(2));
+    Ipv4Address src = net.hostAddresses.GetAddress(0);
+    Ipv4Address dstA = net.hostAddresses.GetAddress(1);
+    Ipv4Address dstB = net.hostAddresses.GetAddress(2);
+
+    // Flow A fills the table
+    FlowEntry entry;
+    entry.srcIp = src;
+    entry.dstIp = dstA;
+    entry.srcPort = 1000;
+    entry.dstPort = 2000;
+    entry.protocol = 17;
+    entry.outputDevice = portA;
+    NS_TEST_ASSERT_MSG_NE(swtch->InstallFlowEntry(entry), kNoFlow, "Flow A not installed");
+
+    // Flow B misses ahead of a hit on A; installing B evicts A
+    swtch->ReceivePacket(inPort, MakeUdpPacket(src, dstB, 1000, 2000), 0x0800, inPort->GetAddress(),
+                         inPort->GetAddress(), NetDevice::PACKET_HOST);
+    swtch->ReceivePacket(inPort, MakeUdpPacket(src, dstA, 1000, 2000), 0x0800, inPort->GetAddress(),
+                         inPort->GetAddress(), NetDevice::PACKET_HOST);
+
+    Simulator::Stop(Seconds(1));
+    Simulator::Run();
+
+    Ptr<SDNFlowTable> table = swtch->GetFlowTable();
+    NS_TEST_ASSERT_MSG_EQ(table->GetNEvictions(), 2, "B should evict A, then A evict B");
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetPortTxPackets(table->AddPort(portA)), 1, "Flow A packet not sent toward A");
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetPortTxPackets(table->AddPort(portB)), 1, "Flow B packet not sent toward B");
+
+    Simulator::Destroy();
+}
+
+// An ARP request whose reply the channel loses must not stay pending forever
+class SDNLostArpReplyTestCase : public TestCase
+{
+  public:
+    SDNLostArpReplyTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNLostArpReplyTestCase::SDNLostArpReplyTestCase()
+    : TestCase("ARP requests whose reply is lost expire")
+{
+}
+
+void SDNLostArpReplyTestCase::DoRun()
+{
+    SDNTopologyHelper helper;
+    helper.SetSwitchAttribute("ArpCache", BooleanValue(false));
+    helper.SetSwitchAttribute("PacketInRetry", TimeValue(Seconds(1)));
+    SDNNetwork net = helper.Linear(1, 2);
+
+    Ptr<SDNSwitch> swtch = net.switches[0];
+    swtch->SetControlChannel(CreateObject<LossyControlChannel>());
+    Ptr<NetDevice> inPort = PortToward(swtch, net.hosts.Get(0));
+
+    ArpHeader request;
+    request.SetRequest(inPort->GetAddress(), net.hostAddresses.GetAddress(0), Mac48Address::GetBroadcast(),
+                       net.hostAddresses.GetAddress(1));
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(request);
+    swtch->ReceivePacket(inPort, packet, 0x0806, inPort->GetAddress(), Mac48Address::GetBroadcast(),
+                         NetDevice::PACKET_BROADCAST);
+
+    Simulator::Stop(Seconds(0.5));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetNPendingArpRequests(), 1, "Request should wait for its reply");
+
+    Simulator::Stop(Seconds(1));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetNPendingArpRequests(), 0, "Unanswered request not forgotten");
+
+    Simulator::Destroy();
+}
+
+// Packets buffered behind a PacketIn whose reply is lost are dropped, freeing the buffer
+class SDNLostFlowAddTestCase : public TestCase
+{
+  public:
+    SDNLostFlowAddTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNLostFlowAddTestCase::SDNLostFlowAddTestCase()
+    : TestCase("Miss buffers whose FlowAdd is lost expire")
+{
+}
+
+void SDNLostFlowAddTestCase::DoRun()
+{
+    SDNTopologyHelper helper;
+    helper.SetSwitchAttribute("LookupBurst", UintegerValue(1));
+    helper.SetSwitchAttribute("PacketInRetry", TimeValue(Seconds(1)));
+    SDNNetwork net = helper.Linear(1, 2);
+
+    Ptr<SDNSwitch> swtch = net.switches[0];
+    swtch->SetControlChannel(CreateObject<LossyControlChannel>());
+    Ptr<NetDevice> inPort = PortToward(swtch, net.hosts.Get(0));
+    Ipv4Address src = net.hostAddresses.GetAddress(0);
+    Ipv4Address dst = net.hostAddresses.GetAddress(1);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        swtch->ReceivePacket(inPort, MakeUdpPacket(src, dst, 1000, 2000), 0x0800, inPort->GetAddress(),
+                             inPort->GetAddress(), NetDevice::PACKET_HOST);
+    }
+
+    Simulator::Stop(Seconds(0.5));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetNBufferedPackets(), 3, "Packets should wait for the FlowAdd");
+
+    Simulator::Stop(Seconds(1));
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetNBufferedPackets(), 0, "Buffer of a lost FlowAdd not released");
+    NS_TEST_ASSERT_MSG_EQ(swtch->GetNMissDrops(), 3, "Expired packets not counted as drops");
+
+    Simulator::Destroy();
+}
+
+class SDNSwitchTestSuite : public TestSuite
+{
+  public:
+    SDNSwitchTestSuite();
+};
+
+SDNSwitchTestSuite::SDNSwitchTestSuite()
+    : TestSuite("sdn-switch", Type::UNIT)
+{
+    AddTestCase(new SDNBurstEvictionTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNLostArpReplyTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNLostFlowAddTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNSwitchTestSuite g_sdnSwitchTestSuite;
@@ -0,0 +1,194 @@
+#include "ns3/core-module.h"
+#include "ns3/test.h"
+
+#include "ns3/sdn-module.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+using namespace ns3;
+using namespace sdn;
+
+/*
+
+Tests for TimerWheel. Expiries straddle the slot boundaries of the lower three levels so
+timers have to cascade down before they fire.
+
+*/
+
+// Every timer fires on exactly its tick, after cascading from whatever level it started in
+class SDNTimerWheelExpiryTestCase : public TestCase
+{
+  public:
+    SDNTimerWheelExpiryTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNTimerWheelExpiryTestCase::SDNTimerWheelExpiryTestCase()
+    : TestCase("Timers fire on their expiry tick across levels")
+{
+}
+
+void SDNTimerWheelExpiryTestCase::DoRun()
+{
+    // Offsets from tick 100: 156 and 65436 land exactly on a level-1 and a level-2 boundary
+    const uint64_t expiries[] = {1, 2, 156, 255, 256, 257, 511, 65435, 65436, 65437, 70000,
+                                 1u << 24, (1u << 24) + 300};
+    const uint32_t count = sizeof(expiries) / sizeof(expiries[0]);
+
+    // Start off a slot boundary so the first cascade happens part-way through a span
+    TimerWheel wheel;
+    wheel.Reset(100);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        wheel.Schedule(100 + expiries[i], i);
+    }
+    NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), count, "Wrong number of pending timers");
+
+    std::vector<uint32_t> expired;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        wheel.Advance(100 + expiries[i] - 1, expired);
+        NS_TEST_ASSERT_MSG_EQ(expired.size(), 0, "Timer fired early");
+        wheel.Advance(100 + expiries[i], expired);
+        NS_TEST_ASSERT_MSG_EQ(expired.size(), 1, "Timer did not fire on its tick");
+        NS_TEST_ASSERT_MSG_EQ(expired[0], i, "Wrong timer fired");
+        expired.clear();
+    }
+    NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), 0, "Timers left after all fired");
+
+    // An expiry already past is clamped to the next tick
+    uint64_t now = wheel.GetNow();
+    wheel.Schedule(now - 10, 42);
+    wheel.Advance(now + 1, expired);
+    NS_TEST_ASSERT_MSG_EQ(expired.size(), 1, "Overdue timer not fired on the next tick");
+    NS_TEST_ASSERT_MSG_EQ(expired[0], 42, "Wrong timer fired");
+}
+
+// Cancelled timers never fire and their nodes are reused
+class SDNTimerWheelCancelTestCase : public TestCase
+{
+  public:
+    SDNTimerWheelCancelTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNTimerWheelCancelTestCase::SDNTimerWheelCancelTestCase()
+    : TestCase("Cancelled timers do not fire and free their node")
+{
+}
+
+void SDNTimerWheelCancelTestCase::DoRun()
+{
+    TimerWheel wheel;
+    TimerWheel::TimerId near = wheel.Schedule(10, 1);
+    TimerWheel::TimerId far = wheel.Schedule(300, 2);
+    TimerWheel::TimerId kept = wheel.Schedule(300, 3);
+
+    wheel.Cancel(near);
+    wheel.Cancel(far);
+    wheel.Cancel(far);                     // Cancelling twice is harmless
+    wheel.Cancel(TimerWheel::kNoTimer);
+    NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), 1, "Cancelled timers still counted");
+
+    // The last node freed is the first reused
+    NS_TEST_ASSERT_MSG_EQ(wheel.Schedule(20, 4), far, "Cancelled node not reused");
+
+    std::vector<uint32_t> expired;
+    wheel.Advance(400, expired);
+    std::sort(expired.begin(), expired.end());
+    NS_TEST_ASSERT_MSG_EQ(expired.size(), 2, "Wrong number of timers fired");
+    NS_TEST_ASSERT_MSG_EQ(expired[0], 3, "Surviving timer did not fire");
+    NS_TEST_ASSERT_MSG_EQ(expired[1], 4, "Timer on a reused node did not fire");
+    wheel.Cancel(kept);                    // Already fired: nothing to do
+    NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), 0, "Timers left after all fired");
+}
+
+// Random schedules, cancels and advances, checked against a map of pending expiries
+class SDNTimerWheelRandomTestCase : public TestCase
+{
+  public:
+    SDNTimerWheelRandomTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+SDNTimerWheelRandomTestCase::SDNTimerWheelRandomTestCase()
+    : TestCase("Random schedules and cancels fire like a sorted reference")
+{
+}
+
+void SDNTimerWheelRandomTestCase::DoRun()
+{
+    TimerWheel wheel;
+    std::map<uint32_t, std::pair<TimerWheel::TimerId, uint64_t>> pending;   // data -> (id, expiry)
+    std::mt19937 rng(1);
+    uint32_t nextData = 0;
+    std::vector<uint32_t> expired;
+
+    for (uint32_t round = 0; round < 3000; round++)
+    {
+        uint32_t action = rng() % 4;
+        if (action == 0 && !pending.empty())
+        {
+            auto timer = pending.begin();
+            std::advance(timer, rng() % pending.size());
+            wheel.Cancel(timer->second.first);
+            pending.erase(timer);
+        }
+        else if (action == 1)
+        {
+            uint64_t now = wheel.GetNow() + rng() % 2000;
+            expired.clear();
+            wheel.Advance(now, expired);
+
+            std::vector<uint32_t> due;
+            for (auto timer = pending.begin(); timer != pending.end();)
+            {
+                if (timer->second.second <= now)
+                {
+                    due.push_back(timer->first);
+                    timer = pending.erase(timer);
+                }
+                else
+                {
+                    ++timer;
+                }
+            }
+            std::sort(expired.begin(), expired.end());
+            NS_TEST_ASSERT_MSG_EQ(expired.size(), due.size(), "Wrong number of timers fired");
+            NS_TEST_ASSERT_MSG_EQ((expired == due), true, "Wrong timers fired");
+        }
+        else
+        {
+            // Mostly short timeouts, some far enough out to start in the upper levels
+            uint64_t delay = (rng() % 8 == 0) ? rng() % 200000 : rng() % 600;
+            uint64_t expiry = wheel.GetNow() + delay;
+            TimerWheel::TimerId id = wheel.Schedule(expiry, nextData);
+            pending[nextData++] = {id, std::max(expiry, wheel.GetNow() + 1)};
+        }
+        NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), pending.size(), "Pending count drifted");
+    }
+}
+
+class SDNTimerWheelTestSuite : public TestSuite
+{
+  public:
+    SDNTimerWheelTestSuite();
+};
+
+SDNTimerWheelTestSuite::SDNTimerWheelTestSuite()
+    : TestSuite("sdn-timer-wheel", Type::UNIT)
+{
+    AddTestCase(new SDNTimerWheelExpiryTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNTimerWheelCancelTestCase, TestCase::Duration::QUICK);
+    AddTestCase(new SDNTimerWheelRandomTestCase, TestCase::Duration::QUICK);
+}
+
+static SDNTimerWheelTestSuite g_sdnTimerWheelTestSuite;